@@ -0,0 +1,236 @@
+"""io:bench code size and cycle benchmark of register access kernels
+
+Compile kernels (functions named bench_* in bench/*.cpp) for each
+Cortex-M core, disassemble them and report number of instructions,
+bytes and estimated cycles. Results can be compared with baseline file.
+
+Estimated cycles are from instruction timing of each core
+(no flash or bus wait states, branches are counted as taken,
+no dual issue on Cortex-M7), so are good for comparing kernels,
+not for absolute timing.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+
+class BenchError(Exception):
+    pass
+
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+IO_DIR = os.path.dirname(BENCH_DIR)
+BASELINE = os.path.join(BENCH_DIR, 'baseline.txt')
+
+OPTIMIZATIONS = ['0', '1', '2', '3', 's']
+
+CORES = {
+    'm0': ['-mcpu=cortex-m0', '-mthumb', '-mfloat-abi=soft'],
+    'm3': ['-mcpu=cortex-m3', '-mthumb', '-mfloat-abi=soft'],
+    'm4': ['-mcpu=cortex-m4', '-mthumb', '-mfloat-abi=hard', '-mfpu=fpv4-sp-d16'],
+    'm7': ['-mcpu=cortex-m7', '-mthumb', '-mfloat-abi=hard', '-mfpu=fpv5-d16'],
+}
+
+CFLAGS = [
+    '-std=c++14',
+    '-fno-exceptions',
+    '-fno-rtti',
+    '-ffunction-sections',
+    '-fdata-sections',
+    '-Wall',
+    '-Wextra',
+]
+
+# instruction timing in cycles (refill: pipeline refill after pop into pc)
+TIMING = {
+    'm0': {'load': 2, 'store': 2, 'branch': 3, 'call': 4, 'mul': 1, 'div': 0, 'refill': 3},
+    'm3': {'load': 2, 'store': 2, 'branch': 3, 'call': 3, 'mul': 1, 'div': 12, 'refill': 2},
+    'm4': {'load': 2, 'store': 2, 'branch': 3, 'call': 3, 'mul': 1, 'div': 12, 'refill': 2},
+    'm7': {'load': 1, 'store': 1, 'branch': 1, 'call': 1, 'mul': 1, 'div': 12, 'refill': 1},
+}
+
+RE_FUNCTION = re.compile(r'^[0-9a-f]+ <(bench_\w+)>:$')
+RE_INSTRUCTION = re.compile(r'^\s*[0-9a-f]+:\s+((?:[0-9a-f]{2,8} )+)\s*(\S+)\s*(.*)$')
+
+
+def count_registers(operands):
+    """Count registers in register list {r0, r4-r7, lr}"""
+    match = re.search(r'\{(.*)\}', operands)
+    if not match:
+        return 1
+    count = 0
+    for item in match.group(1).split(','):
+        item = item.strip()
+        if '-' in item:
+            first, last = item.split('-')
+            count += int(last.strip()[1:]) - int(first.strip()[1:]) + 1
+        elif item:
+            count += 1
+    return count
+
+
+def instruction_cycles(core, mnemonic, operands):
+    """Estimate cycles of one instruction"""
+    timing = TIMING[core]
+    # remove condition suffix and width qualifier
+    mnem = mnemonic.split('.')[0]
+    if mnem in ('push', 'stmia', 'stmdb', 'stm'):
+        return 1 + count_registers(operands)
+    if mnem in ('pop', 'ldmia', 'ldm'):
+        cycles = 1 + count_registers(operands)
+        if 'pc' in operands:
+            cycles += timing['refill']
+        return cycles
+    if mnem.startswith('ldr'):
+        return timing['load']
+    if mnem.startswith('str'):
+        return timing['store']
+    if mnem in ('bl', 'blx'):
+        return timing['call']
+    if mnem in ('bx', 'b', 'cbz', 'cbnz') or re.match(r'^b(eq|ne|cs|hs|cc|lo|mi|pl|vs|vc|hi|ls|ge|lt|gt|le)$', mnem):
+        return timing['branch']
+    if mnem in ('mul', 'muls', 'mla', 'mls'):
+        return timing['mul']
+    if mnem in ('udiv', 'sdiv'):
+        return timing['div']
+    if mnem in ('dmb', 'dsb', 'isb'):
+        return 4
+    return 1
+
+
+def parse_disassembly(core, text):
+    """Parse objdump output
+    Return: {kernel: (instructions, bytes, cycles)}
+    """
+    results = {}
+    kernel = None
+    for line in text.splitlines():
+        match = RE_FUNCTION.match(line)
+        if match:
+            kernel = match.group(1)
+            results[kernel] = [0, 0, 0]
+            continue
+        if kernel is None:
+            continue
+        match = RE_INSTRUCTION.match(line)
+        if not match:
+            if not line.strip():
+                kernel = None
+            continue
+        raw, mnemonic, operands = match.groups()
+        size = sum(len(word) // 2 for word in raw.split())
+        results[kernel][1] += size
+        if mnemonic.startswith('.'):
+            # literal pool data
+            continue
+        results[kernel][0] += 1
+        results[kernel][2] += instruction_cycles(core, mnemonic, operands)
+    return {name: tuple(values) for name, values in results.items()}
+
+
+def compile_kernels(core, sources, toolchain, optimization):
+    """Compile and disassemble kernels for one core"""
+    results = {}
+    with tempfile.TemporaryDirectory() as tmp:
+        # kernels include headers as "io/..."
+        os.symlink(IO_DIR, os.path.join(tmp, 'io'))
+        for source in sources:
+            obj = os.path.join(tmp, os.path.basename(source) + '.o')
+            cmd = [toolchain + 'g++', *CORES[core], *CFLAGS, optimization, f'-I{tmp}', '-c', source, '-o', obj]
+            try:
+                subprocess.run(cmd, check=True)
+                disassembly = subprocess.run(
+                    [toolchain + 'objdump', '-d', obj],
+                    check=True, capture_output=True, text=True).stdout
+            except (OSError, subprocess.CalledProcessError) as err:
+                raise BenchError(f"{core}: {source}: {err}") from err
+            results.update(parse_disassembly(core, disassembly))
+    return results
+
+
+def load_baseline(path):
+    """Load baseline: {(core, kernel): (instructions, bytes, cycles)}"""
+    baseline = {}
+    if not os.path.exists(path):
+        return baseline
+    with open(path) as file:
+        for line in file:
+            line = line.strip()
+            if not line or line.startswith('#'):
+                continue
+            core, kernel, instructions, size, cycles = line.split()
+            baseline[(core, kernel)] = (int(instructions), int(size), int(cycles))
+    return baseline
+
+
+def save_baseline(path, results):
+    with open(path, 'w') as file:
+        file.write("# core kernel instructions bytes cycles\n")
+        for (core, kernel), values in sorted(results.items()):
+            file.write(f"{core} {kernel} {values[0]} {values[1]} {values[2]}\n")
+
+
+def format_delta(value, base):
+    if base is None or value == base:
+        return f"{value:6d}       "
+    return f"{value:6d} ({value - base:+4d})"
+
+
+def report(results, baseline):
+    """Print results, return number of regressions"""
+    regressions = 0
+    print(f"{'core':4s} {'kernel':32s} {'instructions':>13s} {'bytes':>13s} {'cycles':>13s}")
+    for (core, kernel), values in sorted(results.items()):
+        base = baseline.get((core, kernel))
+        columns = [format_delta(value, base[i] if base else None) for i, value in enumerate(values)]
+        mark = ''
+        if base is None and baseline:
+            mark = '  NEW'
+        elif base and any(value > base[i] for i, value in enumerate(values)):
+            mark = '  REGRESSION'
+            regressions += 1
+        print(f"{core:4s} {kernel:32s} {columns[0]:>13s} {columns[1]:>13s} {columns[2]:>13s}{mark}")
+    for core, kernel in sorted(set(baseline) - set(results)):
+        print(f"{core:4s} {kernel:32s} REMOVED")
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('sources', nargs='*', help="kernel sources (default: bench/*.cpp)")
+    parser.add_argument('-c', '--cores', default=','.join(CORES), help="cores (default: %(default)s)")
+    parser.add_argument('-t', '--toolchain', default='arm-none-eabi-', help="toolchain prefix (default: %(default)s)")
+    parser.add_argument('-O', '--optimization', default='s', choices=OPTIMIZATIONS, help="optimization level (default: %(default)s)")
+    parser.add_argument('-b', '--baseline', default=BASELINE, help="baseline file (default: bench/baseline.txt)")
+    parser.add_argument('-u', '--update', action='store_true', help="write results as new baseline")
+    args = parser.parse_args()
+
+    sources = args.sources or sorted(
+        os.path.join(BENCH_DIR, name) for name in os.listdir(BENCH_DIR) if name.endswith('.cpp'))
+    results = {}
+    for core in args.cores.split(','):
+        if core not in CORES:
+            raise BenchError(f"unknown core: {core}")
+        for kernel, values in compile_kernels(core, sources, args.toolchain, f'-O{args.optimization}').items():
+            results[(core, kernel)] = values
+    baseline = load_baseline(args.baseline)
+    regressions = report(results, baseline)
+    if not baseline and not args.update:
+        print(f"no baseline {args.baseline}, results are not compared "
+              "(create it by: python3 bench/bench.py --update)")
+    if args.update:
+        save_baseline(args.baseline, results)
+        return 0
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    try:
+        sys.exit(main())
+    except BenchError as err:
+        print(f"ERROR: {err}", file=sys.stderr)
+        sys.exit(2)
@@ -0,0 +1,85 @@
+/**
+ * Benchmark of memory copy: CPU and DMA
+ *
+ * Kernels bench_* are measured by bench.py (code size of each path).
+ *
+ * dma_memory_benchmark() measure real duration on MCU by SysTick
+ * (clocked from CPU, running, reload 0xffffff) for range of sizes and
+ * report CPU copy, DMA copy (until done) and CPU cycles spent by DMA
+ * copy setup (time when CPU can do other work is the difference).
+ * Call it from application, DMA1 channel 1 must be enabled in RCC and
+ * its interrupt must call dma_memory_isr(). Result can be used to tune
+ * DmaMemory threshold.
+ */
+
+#include "io/reg/cortexm/systick.hpp"
+#include "io/reg/stm32/f0/dma.hpp"
+#include "io/lib/stm32/_common/dma_memory.hpp"
+
+namespace {
+
+io::DmaMemory dma_memory(io::DMA1, 1, 0);
+
+uint32_t src_buffer[1024];
+uint32_t dst_buffer[1024];
+
+/** Elapsed SysTick cycles (counter is counting down)
+ */
+uint32_t elapsed(const uint32_t start) {
+    return (start - io::SYSTICK.VAL.r) & 0xffffff;
+}
+
+}
+
+extern "C" {
+
+// kernels
+
+void bench_cpu_copy_256(void *dst, const void *src) {
+    io::DmaMemory::cpu_copy(dst, src, 256);
+}
+
+void bench_cpu_fill_256(void *dst) {
+    io::DmaMemory::cpu_fill(dst, 0, 256);
+}
+
+bool bench_dma_memcpy_start(void *dst, const void *src, const size_t size) {
+    return dma_memory.memcpy(dst, src, size);
+}
+
+void bench_dma_memory_isr() {
+    dma_memory.handle_isr();
+}
+
+// runtime benchmark
+
+void dma_memory_isr() {
+    dma_memory.handle_isr();
+}
+
+/** Result callback
+ * @param size number of bytes
+ * @param cpu cycles of CPU copy
+ * @param dma cycles of DMA copy until done
+ * @param setup cycles of CPU spent to start DMA copy
+ */
+typedef void (*dma_memory_result_t)(size_t size, uint32_t cpu, uint32_t dma, uint32_t setup);
+
+void dma_memory_benchmark(dma_memory_result_t result) {
+    static const size_t SIZES[] = {16, 32, 64, 128, 256, 512, 1024, 2048, 4096};
+    for (const size_t size : SIZES) {
+        uint32_t start = io::SYSTICK.VAL.r;
+        io::DmaMemory::cpu_copy(dst_buffer, src_buffer, size);
+        const uint32_t cpu = elapsed(start);
+
+        start = io::SYSTICK.VAL.r;
+        dma_memory.memcpy(dst_buffer, src_buffer, size);
+        const uint32_t setup = elapsed(start);
+        dma_memory.wait();
+        const uint32_t dma = elapsed(start);
+
+        result(size, cpu, dma, setup);
+    }
+}
+
+}
@@ -0,0 +1,130 @@
+/**
+ * Benchmark kernels for register access primitives
+ *
+ * Each kernel is small function with C linkage named bench_*,
+ * bench.py compile this file for each core, disassemble it and
+ * count instructions, bytes and estimated cycles of each kernel.
+ *
+ * Register instances are from STM32F0, code for access to registers
+ * is the same for other MCUs, only instruction set differ per core.
+ */
+
+#include "io/reg/cortexm/nvic.hpp"
+#include "io/reg/stm32/f0/gpio.hpp"
+#include "io/reg/stm32/f0/dma.hpp"
+#include "io/reg/stm32/f0/adc.hpp"
+#include "io/reg/stm32/f0/usart.hpp"
+#include "io/lib/stm32/_common/pin.hpp"
+
+extern "C" {
+
+// GPIO
+
+void bench_gpio_toggle() {
+    io::GPIOA.BSRR.set(5);
+    io::GPIOA.BSRR.clr(5);
+}
+
+void bench_gpio_bsrr_set(const unsigned pin) {
+    io::GPIOA.BSRR.set(pin);
+}
+
+void bench_gpio_moder_set(const unsigned pin, const uint32_t mode) {
+    io::GPIOA.MODER.set(pin, mode);
+}
+
+void bench_gpio_afr_set(const unsigned pin, const unsigned af) {
+    io::GPIOA.AFR.set(pin, af);
+}
+
+void bench_gpio_afr_set_const() {
+    io::GPIOA.AFR.set(9, 1);
+}
+
+void bench_gpio_pin_group_configure() {
+    using Bus = io::PinGroup<
+        io::PinOutput<io::base::GPIOB, 0>,
+        io::PinOutput<io::base::GPIOB, 1>,
+        io::PinAf<io::base::GPIOB, 3, 2>,
+        io::PinAf<io::base::GPIOB, 10, 4>,
+        io::PinInput<io::base::GPIOB, 7, io::Gpio::Pupdr::Pupd::PULL_UP>>;
+    Bus::configure();
+}
+
+void bench_gpio_pin_group_write_contiguous(const uint32_t value) {
+    using Bus = io::PinGroup<
+        io::PinOutput<io::base::GPIOB, 8>,
+        io::PinOutput<io::base::GPIOB, 9>,
+        io::PinOutput<io::base::GPIOB, 10>,
+        io::PinOutput<io::base::GPIOB, 11>,
+        io::PinOutput<io::base::GPIOB, 12>,
+        io::PinOutput<io::base::GPIOB, 13>,
+        io::PinOutput<io::base::GPIOB, 14>,
+        io::PinOutput<io::base::GPIOB, 15>>;
+    Bus::write(value);
+}
+
+void bench_gpio_pin_group_write_scattered(const uint32_t value) {
+    using Bus = io::PinGroup<
+        io::PinOutput<io::base::GPIOB, 0>,
+        io::PinOutput<io::base::GPIOB, 1>,
+        io::PinOutput<io::base::GPIOB, 10>,
+        io::PinOutput<io::base::GPIOB, 3>,
+        io::PinOutput<io::base::GPIOB, 4>,
+        io::PinOutput<io::base::GPIOB, 12>,
+        io::PinOutput<io::base::GPIOB, 6>,
+        io::PinOutput<io::base::GPIOB, 7>>;
+    Bus::write(value);
+}
+
+// NVIC
+
+void bench_nvic_iser(const uint32_t isr) {
+    io::NVIC.iser(isr);
+}
+
+void bench_nvic_iser_const() {
+    io::NVIC.iser(27);
+}
+
+// DMA
+
+void bench_dma_clear_flags(const unsigned channel) {
+    io::DMA1.IFCR.clear_flags(channel);
+}
+
+void bench_dma_clear_flags_const() {
+    io::DMA1.IFCR.clear_flags(3);
+}
+
+bool bench_dma_tcif(const unsigned channel) {
+    return io::DMA1.ISR.TCIF(channel);
+}
+
+// ADC
+
+void bench_adc_chselr_set(const uint32_t ch) {
+    io::ADC.CHSELR.set(ch);
+}
+
+// USART, multiple fields by bit-fields and by modify()
+
+void bench_usart_cr1_bits() {
+    io::USART1.CR1.b.M0 = 0;
+    io::USART1.CR1.b.PCE = 1;
+    io::USART1.CR1.b.TE = 1;
+    io::USART1.CR1.b.RE = 1;
+    io::USART1.CR1.b.UE = 1;
+}
+
+void bench_usart_cr1_modify() {
+    io::USART1.CR1.modify([](io::Usart::Cr1 &cr1) {
+        cr1.b.M0 = 0;
+        cr1.b.PCE = 1;
+        cr1.b.TE = 1;
+        cr1.b.RE = 1;
+        cr1.b.UE = 1;
+    });
+}
+
+}
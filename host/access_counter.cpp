@@ -0,0 +1,164 @@
+/**
+ * Bus access counter (IO_HOST build)
+ *
+ * Simulated memory is protected, each access raise SIGSEGV, handler
+ * record the access (type is from page fault error code), unprotect
+ * the page and single step the instruction (trap flag), then SIGTRAP
+ * handler protect the page again.
+ */
+
+#include "io/host/access_counter.hpp"
+#include "io/host/memory.hpp"
+
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+namespace io {
+
+namespace host {
+
+struct Counts {
+    uintptr_t address;
+    unsigned reads;
+    unsigned writes;
+};
+
+// page fault error code, write access
+static const greg_t PF_WRITE = 2;
+// EFLAGS trap flag
+static const greg_t EFLAGS_TF = 0x100;
+
+static Counts counts[AccessCounter::MAX_REGISTERS];
+static size_t counts_size = 0;
+static uintptr_t pending_page = 0;
+static uintptr_t page_size = 0;
+static bool running = false;
+static struct sigaction old_segv;
+static struct sigaction old_trap;
+
+static void protect(const int prot) {
+    for (const Region &region : REGIONS) {
+        mprotect(reinterpret_cast<void *>(region.base), region.size, prot);
+    }
+}
+
+static Counts *find(const uintptr_t address) {
+    for (size_t i = 0; i < counts_size; i++) {
+        if (counts[i].address == address) return &counts[i];
+    }
+    return nullptr;
+}
+
+static void record(const uintptr_t address, const bool is_write) {
+    Counts *c = find(address);
+    if (!c) {
+        if (counts_size >= AccessCounter::MAX_REGISTERS) {
+            static const char msg[] = "io: too many registers in AccessCounter\n";
+            ::write(STDERR_FILENO, msg, sizeof(msg) - 1);
+            std::abort();
+        }
+        c = &counts[counts_size++];
+        c->address = address;
+        c->reads = 0;
+        c->writes = 0;
+    }
+    if (is_write) c->writes++;
+    else c->reads++;
+}
+
+static void segv_handler(int sig, siginfo_t *info, void *context) {
+    ucontext_t *uc = static_cast<ucontext_t *>(context);
+    if (!running || !is_simulated(info->si_addr)) {
+        // not our fault, let it crash with previous handler
+        sigaction(SIGSEGV, &old_segv, nullptr);
+        return;
+    }
+    (void)sig;
+    const uintptr_t address = reinterpret_cast<uintptr_t>(info->si_addr);
+    record(address & ~static_cast<uintptr_t>(3), uc->uc_mcontext.gregs[REG_ERR] & PF_WRITE);
+    pending_page = address & ~(page_size - 1);
+    mprotect(reinterpret_cast<void *>(pending_page), page_size, PROT_READ | PROT_WRITE);
+    uc->uc_mcontext.gregs[REG_EFL] |= EFLAGS_TF;
+}
+
+static void trap_handler(int, siginfo_t *, void *context) {
+    ucontext_t *uc = static_cast<ucontext_t *>(context);
+    if (!pending_page) return;
+    mprotect(reinterpret_cast<void *>(pending_page), page_size, running ? PROT_NONE : PROT_READ | PROT_WRITE);
+    pending_page = 0;
+    uc->uc_mcontext.gregs[REG_EFL] &= ~EFLAGS_TF;
+}
+
+AccessCounter::AccessCounter(const bool start_counting) {
+    clear();
+    if (start_counting) start();
+}
+
+AccessCounter::~AccessCounter() {
+    stop();
+}
+
+void AccessCounter::start() {
+    if (running) return;
+    if (!page_size) page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    struct sigaction sa;
+    std::memset(&sa, 0, sizeof(sa));
+    sa.sa_flags = SA_SIGINFO;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_sigaction = segv_handler;
+    sigaction(SIGSEGV, &sa, &old_segv);
+    sa.sa_sigaction = trap_handler;
+    sigaction(SIGTRAP, &sa, &old_trap);
+    running = true;
+    protect(PROT_NONE);
+}
+
+void AccessCounter::stop() {
+    if (!running) return;
+    running = false;
+    protect(PROT_READ | PROT_WRITE);
+    sigaction(SIGSEGV, &old_segv, nullptr);
+    sigaction(SIGTRAP, &old_trap, nullptr);
+}
+
+void AccessCounter::clear() {
+    counts_size = 0;
+}
+
+unsigned AccessCounter::reads() const {
+    unsigned res = 0;
+    for (size_t i = 0; i < counts_size; i++) res += counts[i].reads;
+    return res;
+}
+
+unsigned AccessCounter::writes() const {
+    unsigned res = 0;
+    for (size_t i = 0; i < counts_size; i++) res += counts[i].writes;
+    return res;
+}
+
+unsigned AccessCounter::reads(const volatile void *reg) const {
+    const Counts *c = find(reinterpret_cast<uintptr_t>(reg) & ~static_cast<uintptr_t>(3));
+    return c ? c->reads : 0;
+}
+
+unsigned AccessCounter::writes(const volatile void *reg) const {
+    const Counts *c = find(reinterpret_cast<uintptr_t>(reg) & ~static_cast<uintptr_t>(3));
+    return c ? c->writes : 0;
+}
+
+void AccessCounter::report(FILE *out, const char *name) const {
+    std::fprintf(out, "%s: %u reads, %u writes\n", name, reads(), writes());
+    for (size_t i = 0; i < counts_size; i++) {
+        std::fprintf(out, "    0x%08lx: %u reads, %u writes\n",
+            static_cast<unsigned long>(counts[i].address), counts[i].reads, counts[i].writes);
+    }
+}
+
+}
+
+}
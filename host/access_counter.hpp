@@ -0,0 +1,104 @@
+/**
+* Bus access counter
+*
+* Instrumentation for host build (IO_HOST), it count every read and
+* write to simulated MCU memory (see io/host/memory.hpp), per register.
+* This allow to check how many bus accesses costs some operation:
+*
+*   io::host::AccessCounter counter;
+*   io::GPIOA.MODER.set(5, io::Gpio::Moder::Mode::OUTPUT);
+*   counter.stop();
+*   // counter.reads() == 2, counter.writes() == 2 (clear and set of field)
+*
+* Accesses are trapped by page protection and single stepping,
+* so real instructions generated by compiler are counted, including
+* bit-field accesses. Only one counter can run at time and only in
+* single thread. Only Linux on x86-64 is supported.
+*
+* Need to be linked with io/host/access_counter.cpp and io/host/memory.cpp
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+
+namespace io {
+
+namespace host {
+
+/** Counted accesses
+ */
+struct Accesses {
+    unsigned reads;
+    unsigned writes;
+};
+
+/** Bus access counter
+ */
+class AccessCounter {
+public:
+    /** Maximum number of different registers counted
+     */
+    static const size_t MAX_REGISTERS = 256;
+
+    /** Create counter
+     * @param start start counting immediately
+     */
+    AccessCounter(const bool start=true);
+
+    ~AccessCounter();
+
+    /** Start (or continue) counting
+     */
+    void start();
+
+    /** Stop counting
+     */
+    void stop();
+
+    /** Clear all counts
+     */
+    void clear();
+
+    /** Total reads
+     */
+    unsigned reads() const;
+
+    /** Total writes
+     */
+    unsigned writes() const;
+
+    /** Reads of one register
+     * @param reg address of register (any byte in 32 bit word)
+     */
+    unsigned reads(const volatile void *reg) const;
+
+    /** Writes of one register
+     * @param reg address of register (any byte in 32 bit word)
+     */
+    unsigned writes(const volatile void *reg) const;
+
+    /** Print counts per register
+     * @param out output stream
+     * @param name name of test
+     */
+    void report(FILE *out, const char *name) const;
+};
+
+/** Count bus accesses of one operation
+ * @param f operation
+ * @return counted accesses
+ */
+template <typename F>
+inline Accesses count_accesses(F f) {
+    AccessCounter counter;
+    f();
+    counter.stop();
+    return {counter.reads(), counter.writes()};
+}
+
+}
+
+}
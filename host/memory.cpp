@@ -0,0 +1,71 @@
+/**
+ * Host memory map (IO_HOST build)
+ */
+
+#include "io/host/memory.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <sys/mman.h>
+
+namespace io {
+
+namespace host {
+
+static bool mapped = false;
+
+bool map_memory() {
+    if (mapped) return true;
+    for (const Region &region : REGIONS) {
+        void *addr = reinterpret_cast<void *>(region.base);
+        void *res = mmap(addr, region.size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED_NOREPLACE, -1, 0);
+        if (res != addr) {
+            if (res != MAP_FAILED) munmap(res, region.size);
+            // roll back already mapped regions
+            for (const Region *r = REGIONS; r != &region; r++) {
+                munmap(reinterpret_cast<void *>(r->base), r->size);
+            }
+            return false;
+        }
+    }
+    mapped = true;
+    return true;
+}
+
+void unmap_memory() {
+    if (!mapped) return;
+    for (const Region &region : REGIONS) {
+        munmap(reinterpret_cast<void *>(region.base), region.size);
+    }
+    mapped = false;
+}
+
+void reset_memory() {
+    if (!mapped) return;
+    // anonymous private pages read back as zero after MADV_DONTNEED
+    for (const Region &region : REGIONS) {
+        madvise(reinterpret_cast<void *>(region.base), region.size, MADV_DONTNEED);
+    }
+}
+
+bool is_simulated(const volatile void *address) {
+    const uintptr_t addr = reinterpret_cast<uintptr_t>(address);
+    for (const Region &region : REGIONS) {
+        if (addr >= region.base && addr < region.base + region.size) return true;
+    }
+    return false;
+}
+
+// map memory before any static constructor can touch registers
+__attribute__((constructor(101))) static void init_memory() {
+    if (!map_memory()) {
+        std::fprintf(stderr, "io: can not map simulated MCU memory\n");
+        std::abort();
+    }
+}
+
+}
+
+}
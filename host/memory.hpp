@@ -0,0 +1,60 @@
+/**
+* Host memory map
+*
+* Simulated MCU memory for host build (IO_HOST).
+* Anonymous memory is mapped at the same addresses where are peripherals
+* on the MCU, so all peripheral instances (io::GPIOA, io::NVIC, ..)
+* and drivers can be compiled by host compiler and used in unit tests
+* and benchmarks without any change.
+*
+* Regions are mapped automatically before static constructors (and
+* zeroed), this need to be linked with io/host/memory.cpp.
+* Only Linux is supported.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace io {
+
+namespace host {
+
+/** Simulated memory region
+ */
+struct Region {
+    size_t base;  // start address
+    size_t size;  // size in bytes
+};
+
+/** Simulated regions
+ */
+static const Region REGIONS[] = {
+    {0x1ff00000, 0x00100000},  // system memory (UID, calibration values, ..)
+    {0x40000000, 0x20000000},  // peripherals (APB, AHB)
+    {0xe0000000, 0x00100000},  // Cortex-M private peripheral bus (NVIC, SCB, SYSTICK)
+};
+
+/** Map all regions
+ * @return true if success or already mapped
+ */
+bool map_memory();
+
+/** Unmap all regions
+ */
+void unmap_memory();
+
+/** Zero all regions (registers reset value is zero)
+ */
+void reset_memory();
+
+/** Check if address is in simulated memory
+ * @param address address to check
+ * @return true if address is in some region
+ */
+bool is_simulated(const volatile void *address);
+
+}
+
+}
@@ -0,0 +1,162 @@
+/**
+* Deferred binary log
+*
+* Format strings are never formatted on MCU. They are placed in section
+* .io_log which is not loaded into FLASH (see io/ld/_common/flash.ld),
+* its address in this section is used as message ID. Log record contain
+* only ID and raw arguments and it is stored into ring buffer, which is
+* drained later (for example by LogUsart over USART DMA). Messages are
+* reconstructed on host from ELF file by io/lib/log_decode.py.
+*
+* Record: [length] [ID] [arguments..]
+*  - length: number of bytes after length byte
+*  - ID: varint (7 bits per byte, LSB first, bit 7 is continuation)
+*  - integer, bool, char, pointer: converted to int32_t, zig-zag varint
+*    (decoder convert it back according to format: %d, %u, %x, ..)
+*  - float, double: 4 bytes IEEE float, little endian
+* String arguments (%s) are not supported.
+*
+* Writing a record cost encoding of arguments on stack and short copy
+* into ring with interrupts disabled (no exclusive access on Cortex-M0),
+* so log can be used from main loop and from interrupts. When ring is
+* full, record is dropped and counted.
+*
+* Example:
+*   uint8_t log_buffer[512];
+*   io::Log log(log_buffer, sizeof(log_buffer));
+*
+*   [[gnu::section(".io_log")]] static const char MSG_ADC[] = "adc: ch=%u value=%d temp=%.1f";
+*   log.write(MSG_ADC, channel, value, temp);
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+#include "io/reg/cortexm/nvic.hpp"
+
+namespace io {
+
+class Log {
+public:
+    static const size_t MAX_RECORD = 256;
+
+    /** Log constructor
+     * @param buffer ring buffer
+     * @param size size of buffer (power of two)
+     */
+    Log(uint8_t *buffer, const size_t size) :
+        _buffer(buffer),
+        _mask(size - 1) {}
+
+    /** Write log record
+     * @param format format string in section .io_log
+     * @param args arguments (integers, pointers, floats)
+     * @return false if ring is full (record is dropped)
+     */
+    template <typename... Args>
+    bool write(const char *format, const Args... args) {
+        static_assert(1 + 5 + sizeof...(Args) * 5 <= MAX_RECORD, "too many arguments");
+        uint8_t record[1 + 5 + sizeof...(Args) * 5];
+        uint8_t *end = varint(record + 1, static_cast<uint32_t>(reinterpret_cast<uintptr_t>(format)));
+        end = encode(end, args...);
+        const size_t size = static_cast<size_t>(end - record);
+        record[0] = static_cast<uint8_t>(size - 1);
+        return push(record, size);
+    }
+
+    /** Number of dropped records
+     */
+    unsigned dropped() const {
+        return _dropped;
+    }
+
+    /** Get contiguous block of data to drain
+     * @param data set to first byte
+     * @return number of bytes (0 if ring is empty)
+     */
+    size_t peek(const uint8_t *&data) const {
+        const size_t tail = _tail;
+        const size_t used = _head - tail;
+        const size_t offset = tail & _mask;
+        const size_t to_end = _mask + 1 - offset;
+        data = _buffer + offset;
+        return used < to_end ? used : to_end;
+    }
+
+    /** Release drained data
+     * @param size number of bytes from peek()
+     */
+    void consume(const size_t size) {
+        _tail = _tail + size;
+    }
+
+private:
+    uint8_t *const _buffer;
+    const size_t _mask;
+    volatile size_t _head = 0;  // free running, producer
+    volatile size_t _tail = 0;  // free running, consumer
+    volatile unsigned _dropped = 0;
+
+    static uint8_t *varint(uint8_t *p, uint32_t value) {
+        while (value >= 0x80) {
+            *p++ = static_cast<uint8_t>(value | 0x80);
+            value >>= 7;
+        }
+        *p++ = static_cast<uint8_t>(value);
+        return p;
+    }
+
+    static uint8_t *zigzag(uint8_t *p, const int32_t value) {
+        return varint(p, (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31));
+    }
+
+    template <typename T>
+    static uint8_t *argument(uint8_t *p, const T value, std::true_type /* floating */) {
+        const float f = static_cast<float>(value);
+        std::memcpy(p, &f, 4);
+        return p + 4;
+    }
+
+    template <typename T>
+    static uint8_t *argument(uint8_t *p, const T value, std::false_type /* floating */) {
+        static_assert(std::is_integral<T>::value && sizeof(T) <= 4, "log argument must be integer up to 32 bits, pointer or float");
+        return zigzag(p, static_cast<int32_t>(value));
+    }
+
+    template <typename T>
+    static uint8_t *argument(uint8_t *p, T *value, std::false_type /* floating */) {
+        return zigzag(p, static_cast<int32_t>(reinterpret_cast<uintptr_t>(value)));
+    }
+
+    static uint8_t *encode(uint8_t *p) {
+        return p;
+    }
+
+    template <typename T, typename... Args>
+    static uint8_t *encode(uint8_t *p, const T value, const Args... args) {
+        p = argument(p, value, std::is_floating_point<T>());
+        return encode(p, args...);
+    }
+
+    bool push(const uint8_t *record, const size_t size) {
+        const uint32_t primask = Nvic::isr_save();
+        const size_t head = _head;
+        if (_mask + 1 - (head - _tail) < size) {
+            _dropped = _dropped + 1;
+            Nvic::isr_restore(primask);
+            return false;
+        }
+        for (size_t i = 0; i < size; i++) {
+            _buffer[(head + i) & _mask] = record[i];
+        }
+        _head = head + size;
+        Nvic::isr_restore(primask);
+        return true;
+    }
+};
+
+}
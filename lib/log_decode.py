@@ -0,0 +1,181 @@
+"""io:log decoder of deferred binary log
+
+Read format strings from section .io_log of ELF file and decode stream
+of log records (io/lib/log.hpp) from file, serial port (configured by
+stty) or stdin into text lines.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+
+class LogDecodeError(Exception):
+    pass
+
+
+SECTION = '.io_log'
+
+RE_CONVERSION = re.compile(r'%([-+ #0]*\d*(?:\.\d+)?)(?:hh|h|ll|l|z|j|t|L)?([diuoxXcpfFeEgGaAs%])')
+
+SIGNED = 'di'
+UNSIGNED = 'uoxXc'
+FLOAT = 'fFeEgGaA'
+
+
+def read_section(path, name=SECTION):
+    """Read section from ELF file
+    Return: (address, data)
+    """
+    with open(path, 'rb') as file:
+        elf = file.read()
+    if elf[:4] != b'\x7fELF':
+        raise LogDecodeError(f"{path}: not ELF file")
+    if elf[5] != 1:
+        raise LogDecodeError(f"{path}: only little endian ELF is supported")
+    if elf[4] == 1:
+        shoff, = struct.unpack_from('<I', elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from('<HHH', elf, 0x2e)
+        header = '<IIIIIIIIII'
+    else:
+        shoff, = struct.unpack_from('<Q', elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from('<HHH', elf, 0x3a)
+        header = '<IIQQQQIIQQ'
+    sections = [struct.unpack_from(header, elf, shoff + i * shentsize) for i in range(shnum)]
+    strtab = sections[shstrndx]
+    for section in sections:
+        start = strtab[4] + section[0]
+        section_name = elf[start:elf.index(b'\0', start)].decode()
+        if section_name == name:
+            address, offset, size = section[3], section[4], section[5]
+            return address, elf[offset:offset + size]
+    raise LogDecodeError(f"{path}: section {name} not found")
+
+
+def read_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        if pos >= len(data):
+            raise LogDecodeError("truncated record")
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7f) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def read_int(data, pos):
+    """Read zig-zag varint, return int32 value"""
+    value, pos = read_varint(data, pos)
+    return (value >> 1) ^ -(value & 1), pos
+
+
+def format_message(fmt, data, pos):
+    """Replace conversions in format by decoded arguments"""
+    result = []
+    last = 0
+    for match in RE_CONVERSION.finditer(fmt):
+        result.append(fmt[last:match.start()])
+        last = match.end()
+        flags, conversion = match.groups()
+        if conversion == '%':
+            result.append('%')
+        elif conversion in FLOAT:
+            if pos + 4 > len(data):
+                raise LogDecodeError("truncated record")
+            value, = struct.unpack_from('<f', data, pos)
+            pos += 4
+            result.append(('%' + flags + (conversion if conversion not in 'aA' else 'e')) % value)
+        else:
+            value, pos = read_int(data, pos)
+            if conversion in SIGNED:
+                result.append(('%' + flags + 'd') % value)
+            elif conversion in UNSIGNED:
+                result.append(('%' + flags + conversion) % (value & 0xffffffff))
+            elif conversion == 'p':
+                result.append('0x%08x' % (value & 0xffffffff))
+            else:
+                result.append('<str@0x%08x>' % (value & 0xffffffff))
+    result.append(fmt[last:])
+    return ''.join(result), pos
+
+
+def read_exact(stream, size):
+    """Read size bytes, serial port or pipe can return less in one read
+    Return: bytes, shorter only at end of stream
+    """
+    data = b''
+    while len(data) < size:
+        chunk = stream.read(size - len(data))
+        if not chunk:
+            break
+        data += chunk
+    return data
+
+
+class Decoder:
+    def __init__(self, address, strings):
+        self._address = address
+        self._strings = strings
+
+    def format_string(self, message_id):
+        offset = message_id - self._address
+        if offset < 0 or offset >= len(self._strings):
+            return None
+        end = self._strings.find(b'\0', offset)
+        return self._strings[offset:end].decode(errors='replace')
+
+    def decode_record(self, record):
+        """Decode record (without length byte)"""
+        message_id, pos = read_varint(record, 0)
+        fmt = self.format_string(message_id)
+        if fmt is None:
+            return f"<unknown message id {message_id}: {record.hex()}>"
+        message, pos = format_message(fmt, record, pos)
+        if pos != len(record):
+            message += f" <{len(record) - pos} extra bytes>"
+        return message.rstrip('\n')
+
+    def decode_stream(self, stream):
+        """Generate text lines from binary stream"""
+        while True:
+            length = read_exact(stream, 1)
+            if not length:
+                return
+            record = read_exact(stream, length[0])
+            if len(record) < length[0]:
+                return
+            try:
+                yield self.decode_record(record)
+            except LogDecodeError as err:
+                yield f"<{err}: {record.hex()}>"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('elf', help="firmware ELF file")
+    parser.add_argument('input', nargs='?', help="log stream (file or serial port, default: stdin)")
+    args = parser.parse_args()
+
+    address, strings = read_section(args.elf)
+    decoder = Decoder(address, strings)
+    if args.input:
+        stream = open(args.input, 'rb', buffering=0)
+    else:
+        stream = sys.stdin.buffer
+    with stream:
+        for line in decoder.decode_stream(stream):
+            print(line, flush=True)
+
+
+if __name__ == "__main__":
+    try:
+        main()
+    except LogDecodeError as err:
+        print(f"ERROR: {err}", file=sys.stderr)
+        sys.exit(1)
+    except KeyboardInterrupt:
+        pass
@@ -0,0 +1,156 @@
+/**
+* DMA channel manager
+*
+* Allocate channels of one DMA controller to drivers, program request
+* routing (CSELR) and dispatch channel interrupts to per-channel
+* callbacks. Interrupt vectors shared by more channels are handled by
+* single read of Dma::Isr, channels with pending flags are found by
+* count-leading-zeros over the flag word (only set channels are
+* visited) and all handled flags are cleared by single Ifcr write (without
+* GIF, which would clear also flags raised after the read).
+*
+* Example (STM32F0, see also io/lib/stm32/f0/dma_manager.hpp):
+*   io::DmaManager dma1(io::DMA1);
+*   unsigned ch = dma1.allocate(io::DmaManager::mask(2, 4), 0x8, callback, this);
+*
+*   void DMA1_CH2_3_DMA2_CH1_2_handler() {
+*       dma1.handle_isr(io::dma_vector::DMA1_CH2_3);
+*   }
+*
+* MCUs containing this peripheral:
+*  - all MCUs with DMA v1 (see io/reg/stm32/_common/dma_v1.hpp)
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "io/reg/stm32/_common/dma_v1.hpp"
+
+namespace io {
+
+class DmaManager {
+public:
+    static const unsigned CHANNELS = 7;
+
+    /** Request value for MCUs without CSELR (fixed request mapping)
+     */
+    static const unsigned NO_REQUEST = 0xff;
+
+    /** Channel event callback
+     * called from interrupt, flags are already cleared
+     * @param context user context
+     * @param flags Dma::Ifcr::TCIF, HTIF and TEIF of channel
+     */
+    typedef void (*callback_t)(void *context, unsigned flags);
+
+    /** Mask of channels
+     * @param channel channel number (1 - 7)
+     */
+    static constexpr uint32_t mask(const unsigned channel) {
+        return static_cast<uint32_t>(1) << (channel - 1);
+    }
+
+    template <typename... T>
+    static constexpr uint32_t mask(const unsigned channel, const T... channels) {
+        return mask(channel) | mask(channels...);
+    }
+
+    /** DmaManager constructor
+     * @param dma DMA controller
+     * @param channels number of channels of this controller (DMA2 on F0 has 5)
+     */
+    DmaManager(Dma &dma, const unsigned channels=CHANNELS) :
+        _dma(dma),
+        _available(mask_all(channels)) {}
+
+    /** Allocate channel
+     * @param channels mask of channels which can be used for request (mask())
+     * @param request request number for CSELR or NO_REQUEST
+     * @param callback called on channel events (can be nullptr)
+     * @param context user context for callback
+     * @return channel number (1 - 7) or 0 if all channels from mask are used
+     */
+    unsigned allocate(const uint32_t channels, const unsigned request, callback_t callback, void *context=nullptr) {
+        const uint32_t free = channels & _available & ~_allocated;
+        if (!free) return 0;
+        const unsigned channel = __builtin_ctz(free) + 1;
+        _allocated |= mask(channel);
+        _callbacks[channel - 1] = {callback, context};
+        _dma.CHANNEL(channel).CCR.r = 0;
+        _dma.IFCR.clear_flags(channel);
+        if (request != NO_REQUEST) _dma.CSELR.set(channel, request);
+        return channel;
+    }
+
+    /** Release channel
+     * channel is disabled and its flags are cleared
+     * @param channel channel number
+     */
+    void release(const unsigned channel) {
+        if (!is_allocated(channel)) return;
+        _dma.CHANNEL(channel).CCR.r = 0;
+        _dma.IFCR.clear_flags(channel);
+        _callbacks[channel - 1] = {nullptr, nullptr};
+        _allocated &= ~mask(channel);
+    }
+
+    /** Check if channel is allocated
+     */
+    bool is_allocated(const unsigned channel) const {
+        return _allocated & mask(channel);
+    }
+
+    /** Access registers of channel
+     */
+    Dma::Channel &channel(const unsigned channel) {
+        return _dma.CHANNEL(channel);
+    }
+
+    /** Dispatch interrupt of channels
+     * call from DMA interrupt handler, with mask of channels of this vector
+     * @param channels mask of channels (mask())
+     */
+    void handle_isr(const uint32_t channels=mask_all(CHANNELS)) {
+        uint32_t pending = _dma.ISR.r & flags_mask(channels);
+        if (!pending) return;
+        // clear read flags at once, events after the read and during callbacks stay pending
+        _dma.IFCR.r = pending;
+        while (pending) {
+            const unsigned bit = 31 - __builtin_clz(pending);
+            const unsigned index = bit >> 2;
+            const unsigned flags = (pending >> (index << 2)) & (Dma::Ifcr::TCIF | Dma::Ifcr::HTIF | Dma::Ifcr::TEIF);
+            pending &= ~(static_cast<uint32_t>(0x0f) << (index << 2));
+            const Callback &cb = _callbacks[index];
+            if (flags && cb.callback) cb.callback(cb.context, flags);
+        }
+    }
+
+private:
+    struct Callback {
+        callback_t callback;
+        void *context;
+    };
+
+    Dma &_dma;
+    const uint32_t _available;
+    uint32_t _allocated = 0;
+    Callback _callbacks[CHANNELS] = {};
+
+    static constexpr uint32_t mask_all(const unsigned channels) {
+        return (static_cast<uint32_t>(1) << channels) - 1;
+    }
+
+    /** Mask of TCIF, HTIF and TEIF flags of channels (without GIF)
+     */
+    static constexpr uint32_t flags_mask(const uint32_t channels) {
+        uint32_t res = 0;
+        for (unsigned i = 0; i < CHANNELS; i++) {
+            if (channels & (static_cast<uint32_t>(1) << i)) res |= static_cast<uint32_t>(Dma::Ifcr::TCIF | Dma::Ifcr::HTIF | Dma::Ifcr::TEIF) << (i << 2);
+        }
+        return res;
+    }
+};
+
+}
@@ -0,0 +1,250 @@
+/**
+* Asynchronous memory copy and fill by DMA
+*
+* DMA channel in MEM2MEM mode copy or fill memory while CPU continue,
+* done callback is called from DMA interrupt. Transfer width (8, 16 or
+* 32 bits) is chosen from alignment of addresses and size, transfers
+* longer than 65535 elements are chained from interrupt.
+*
+* Blocks smaller than threshold are copied by CPU immediately (DMA setup
+* and interrupt cost more than the copy), done callback is then called
+* before memcpy()/memset() return. Empty block (size 0) is done
+* immediately also with threshold 0 (DMA would never complete CNDTR 0).
+*
+* Example:
+*   io::DmaMemory dma_memory(io::DMA1, 1);
+*   dma_memory.memcpy(frame, next_frame, sizeof(frame), done, nullptr);
+*
+*   void DMA1_CH1_handler() {
+*       dma_memory.handle_isr();
+*   }
+*
+* MCUs containing this peripheral:
+*  - all MCUs with DMA v1 (see io/reg/stm32/_common/dma_v1.hpp)
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "io/reg/stm32/_common/dma_v1.hpp"
+
+namespace io {
+
+class DmaMemory {
+public:
+    static const size_t THRESHOLD = 64;
+
+    /** Done callback
+     * @param context user context
+     * @param ok false on transfer error
+     */
+    typedef void (*done_t)(void *context, bool ok);
+
+    /** DmaMemory constructor
+     * @param dma DMA controller
+     * @param channel DMA channel (1 - 7), any free channel
+     * @param threshold size in bytes below which CPU is used
+     */
+    DmaMemory(Dma &dma, const unsigned channel, const size_t threshold=THRESHOLD) :
+        _dma(dma),
+        _channel(channel),
+        _threshold(threshold) {}
+
+    /** Copy memory
+     * @param dst destination
+     * @param src source (SRAM or FLASH)
+     * @param size number of bytes
+     * @param done called when copy is done
+     * @param context user context for callback
+     * @return false if previous transfer is still running
+     */
+    bool memcpy(void *dst, const void *src, const size_t size, done_t done=nullptr, void *context=nullptr) {
+        if (_busy) return false;
+        if (!size || size < _threshold) {
+            cpu_copy(dst, src, size);
+            if (done) done(context, true);
+            return true;
+        }
+        _dst = reinterpret_cast<uintptr_t>(dst);
+        _src = reinterpret_cast<uintptr_t>(src);
+        _fill = false;
+        start(size, done, context);
+        return true;
+    }
+
+    /** Fill memory
+     * @param dst destination
+     * @param value byte value
+     * @param size number of bytes
+     * @param done called when fill is done
+     * @param context user context for callback
+     * @return false if previous transfer is still running
+     */
+    bool memset(void *dst, const uint8_t value, const size_t size, done_t done=nullptr, void *context=nullptr) {
+        if (_busy) return false;
+        if (!size || size < _threshold) {
+            cpu_fill(dst, value, size);
+            if (done) done(context, true);
+            return true;
+        }
+        _pattern = value * static_cast<uint32_t>(0x01010101);
+        _dst = reinterpret_cast<uintptr_t>(dst);
+        _src = reinterpret_cast<uintptr_t>(&_pattern);
+        _fill = true;
+        start(size, done, context);
+        return true;
+    }
+
+    /** Check if DMA transfer is running
+     */
+    bool is_busy() const {
+        return _busy;
+    }
+
+    /** Wait until DMA transfer is done
+     */
+    void wait() const {
+        while (_busy) {}
+    }
+
+    /** DMA channel interrupt handler
+     * call from interrupt handler of DMA channel
+     */
+    void handle_isr() {
+        const unsigned shift = (_channel - 1) << 2;
+        const unsigned flags = (_dma.ISR.r >> shift) & (Dma::Ifcr::TCIF | Dma::Ifcr::TEIF);
+        if (!flags) return;
+        _dma.IFCR.clear_flags(_channel, flags);
+        dma_event(this, flags);
+    }
+
+    /** Channel event handler
+     * (can be used as DmaManager callback with this as context)
+     * @param context DmaMemory instance
+     * @param flags TCIF and TEIF of channel (already cleared)
+     */
+    static void dma_event(void *context, const unsigned flags) {
+        static_cast<DmaMemory *>(context)->event(flags);
+    }
+
+    /** Copy memory by CPU
+     * word copy when source and destination have the same alignment
+     */
+    static void cpu_copy(void *dst, const void *src, size_t size) {
+        uint8_t *d = static_cast<uint8_t *>(dst);
+        const uint8_t *s = static_cast<const uint8_t *>(src);
+        if (((reinterpret_cast<uintptr_t>(d) ^ reinterpret_cast<uintptr_t>(s)) & 3) == 0) {
+            while (size && (reinterpret_cast<uintptr_t>(d) & 3)) {
+                *d++ = *s++;
+                size--;
+            }
+            uint32_t *dw = reinterpret_cast<uint32_t *>(d);
+            const uint32_t *sw = reinterpret_cast<const uint32_t *>(s);
+            while (size >= 16) {
+                dw[0] = sw[0];
+                dw[1] = sw[1];
+                dw[2] = sw[2];
+                dw[3] = sw[3];
+                dw += 4;
+                sw += 4;
+                size -= 16;
+            }
+            while (size >= 4) {
+                *dw++ = *sw++;
+                size -= 4;
+            }
+            d = reinterpret_cast<uint8_t *>(dw);
+            s = reinterpret_cast<const uint8_t *>(sw);
+        }
+        while (size--) *d++ = *s++;
+    }
+
+    /** Fill memory by CPU
+     */
+    static void cpu_fill(void *dst, const uint8_t value, size_t size) {
+        uint8_t *d = static_cast<uint8_t *>(dst);
+        while (size && (reinterpret_cast<uintptr_t>(d) & 3)) {
+            *d++ = value;
+            size--;
+        }
+        const uint32_t pattern = value * static_cast<uint32_t>(0x01010101);
+        uint32_t *dw = reinterpret_cast<uint32_t *>(d);
+        while (size >= 4) {
+            *dw++ = pattern;
+            size -= 4;
+        }
+        d = reinterpret_cast<uint8_t *>(dw);
+        while (size--) *d++ = value;
+    }
+
+private:
+    static const size_t MAX_COUNT = 0xffff;
+
+    Dma &_dma;
+    const unsigned _channel;
+    const size_t _threshold;
+    done_t _done = nullptr;
+    void *_context = nullptr;
+    uintptr_t _dst = 0;
+    uintptr_t _src = 0;
+    size_t _remaining = 0;
+    uint32_t _pattern = 0;
+    bool _fill = false;
+    unsigned _width = 0;
+    volatile bool _busy = false;
+
+    void start(const size_t size, done_t done, void *context) {
+        _done = done;
+        _context = context;
+        _remaining = size;
+        // widest access allowed by alignment of all addresses and size
+        const uintptr_t align = _dst | (_fill ? 0 : _src) | size;
+        _width = (align & 1) ? 0 : (align & 2) ? 1 : 2;
+        _busy = true;
+        next();
+    }
+
+    /** Start next chunk of transfer
+     */
+    void next() {
+        size_t count = _remaining >> _width;
+        if (count > MAX_COUNT) count = MAX_COUNT;
+        const size_t bytes = count << _width;
+        Dma::Channel &ch = _dma.CHANNEL(_channel);
+        ch.CCR.r = 0;
+        // DIR = 0: CPAR is source, CMAR is destination
+        ch.CPAR.r = static_cast<uint32_t>(_src);
+        ch.CMAR.r = static_cast<uint32_t>(_dst);
+        ch.CNDTR.r = static_cast<uint32_t>(count);
+        const Dma::Channel::Ccr::Size size = static_cast<Dma::Channel::Ccr::Size>(_width);
+        const bool fill = _fill;
+        ch.CCR.write([size, fill](Dma::Channel::Ccr &ccr) {
+            ccr.b.MEM2MEM = 1;
+            ccr.b.PINC = !fill;
+            ccr.b.MINC = 1;
+            ccr.PSIZE(size);
+            ccr.MSIZE(size);
+            ccr.PL(Dma::Channel::Ccr::Pl::LOW);
+            ccr.b.TCIE = 1;
+            ccr.b.TEIE = 1;
+            ccr.b.EN = 1;
+        });
+        _remaining -= bytes;
+        _dst += bytes;
+        if (!_fill) _src += bytes;
+    }
+
+    void event(const unsigned flags) {
+        if (!(flags & Dma::Ifcr::TEIF) && _remaining) {
+            next();
+            return;
+        }
+        _dma.CHANNEL(_channel).CCR.r = 0;
+        _busy = false;
+        if (_done) _done(_context, !(flags & Dma::Ifcr::TEIF));
+    }
+};
+
+}
@@ -0,0 +1,211 @@
+/**
+* Circular DMA double buffer stream
+*
+* DMA channel in circular mode transfer between peripheral data register
+* and buffer split into two halves. When one half is complete (HTIF for
+* first half, TCIF for second half), it is handed to the consumer in
+* place (pointer and count, no copy) while DMA continues with the other
+* half. Consumer return the half by release() before DMA wraps back to
+* it, otherwise overrun is counted (DMA is writing half which consumer
+* still holds, or interrupt latency lost one half).
+*
+* Receive (from peripheral): handed half contain new data.
+* Transmit (to peripheral): handed half was sent and can be filled.
+*
+* Completed half is determined from CNDTR (half which DMA is not
+* transferring now), so delayed interrupt hands always the newest data.
+*
+* Example (ADC samples):
+*   io::DmaStream<uint16_t> adc_stream(io::DMA1, 1);
+*   uint16_t samples[256];
+*
+*   void ready(void *, uint16_t *data, size_t count) {
+*       process(data, count);
+*       adc_stream.release(data);
+*   }
+*
+*   adc_stream.start(&io::ADC.DR, samples, 256, io::DmaStream<uint16_t>::Direction::RX, ready);
+*
+*   void DMA1_CH1_handler() {
+*       adc_stream.handle_isr();
+*   }
+*
+* MCUs containing this peripheral:
+*  - all MCUs with DMA v1 (see io/reg/stm32/_common/dma_v1.hpp)
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "io/reg/stm32/_common/dma_v1.hpp"
+
+namespace io {
+
+template <typename T>
+class DmaStream {
+    static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4, "DMA element must be 8, 16 or 32 bits");
+
+public:
+    enum class Direction {
+        RX,  // from peripheral into buffer
+        TX,  // from buffer into peripheral
+    };
+
+    /** Ready callback
+     * called from interrupt when half of buffer is complete
+     * @param context user context
+     * @param data first element of the half
+     * @param count number of elements in half
+     */
+    typedef void (*ready_t)(void *context, T *data, size_t count);
+
+    /** DmaStream constructor
+     * @param dma DMA controller
+     * @param channel DMA channel (1 - 7)
+     */
+    DmaStream(Dma &dma, const unsigned channel) :
+        _dma(dma),
+        _channel(channel) {}
+
+    /** Start stream
+     * @param peripheral peripheral data register
+     * @param buffer buffer for both halves
+     * @param count number of elements in buffer (even, max 65534)
+     * @param direction transfer direction
+     * @param ready called for each completed half (nullptr for polling by take())
+     * @param context user context for callback
+     */
+    template <typename P>
+    void start(volatile P *peripheral, T *buffer, const size_t count, const Direction direction, ready_t ready=nullptr, void *context=nullptr) {
+        stop();
+        _buffer = buffer;
+        _half = count >> 1;
+        _ready = ready;
+        _context = context;
+        _held[0] = false;
+        _held[1] = false;
+        _taken = NONE;
+        _overruns = 0;
+        Dma::Channel &ch = _dma.CHANNEL(_channel);
+        ch.CPAR.PAR(peripheral);
+        ch.CMAR.MAR(buffer);
+        ch.CNDTR.r = static_cast<uint32_t>(_half << 1);
+        ch.CCR.write([direction](Dma::Channel::Ccr &ccr) {
+            ccr.b.DIR = direction == Direction::TX;
+            ccr.b.CIRC = 1;
+            ccr.b.MINC = 1;
+            ccr.PSIZE(size());
+            ccr.MSIZE(size());
+            ccr.PL(Dma::Channel::Ccr::Pl::HIGH);
+            ccr.b.TCIE = 1;
+            ccr.b.HTIE = 1;
+            ccr.b.TEIE = 1;
+            ccr.b.EN = 1;
+        });
+    }
+
+    /** Stop stream
+     */
+    void stop() {
+        _dma.CHANNEL(_channel).CCR.r = 0;
+        _dma.IFCR.clear_flags(_channel);
+    }
+
+    /** Check if stream is running
+     * (stopped also after transfer error)
+     */
+    bool is_running() const {
+        return _dma.CHANNEL(_channel).CCR.b.EN;
+    }
+
+    /** Take completed half (polling mode, without ready callback)
+     * @param data set to first element of the half
+     * @return number of elements, 0 if no half is complete
+     */
+    size_t take(T *&data) {
+        const unsigned index = _taken;
+        if (index == NONE) return 0;
+        _taken = NONE;
+        data = _buffer + index * _half;
+        return _half;
+    }
+
+    /** Return half back to DMA
+     * @param data pointer received by ready callback or take()
+     */
+    void release(const T *data) {
+        _held[data < _buffer + _half ? 0 : 1] = false;
+    }
+
+    /** Number of overruns since start
+     */
+    unsigned overruns() const {
+        return _overruns;
+    }
+
+    /** DMA channel interrupt handler
+     * call from interrupt handler of DMA channel
+     */
+    void handle_isr() {
+        // single read of all flags of this channel
+        const unsigned shift = (_channel - 1) << 2;
+        const unsigned flags = (_dma.ISR.r >> shift) & (Dma::Ifcr::TCIF | Dma::Ifcr::HTIF | Dma::Ifcr::TEIF);
+        if (!flags) return;
+        // only read flags, TCIF raised after the read stays pending (GIF would clear it)
+        _dma.IFCR.clear_flags(_channel, flags);
+        dma_event(this, flags);
+    }
+
+    /** Channel event handler
+     * (can be used as DmaManager callback with this as context)
+     * @param context DmaStream instance
+     * @param flags TCIF, HTIF and TEIF of channel (already cleared)
+     */
+    static void dma_event(void *context, const unsigned flags) {
+        static_cast<DmaStream *>(context)->event(flags);
+    }
+
+private:
+    static const unsigned NONE = 2;
+
+    Dma &_dma;
+    const unsigned _channel;
+    T *_buffer = nullptr;
+    size_t _half = 0;
+    ready_t _ready = nullptr;
+    void *_context = nullptr;
+    volatile bool _held[2] = {false, false};
+    volatile unsigned _taken = NONE;
+    volatile unsigned _overruns = 0;
+
+    static constexpr Dma::Channel::Ccr::Size size() {
+        return sizeof(T) == 1 ? Dma::Channel::Ccr::Size::SIZE_8
+            : sizeof(T) == 2 ? Dma::Channel::Ccr::Size::SIZE_16
+            : Dma::Channel::Ccr::Size::SIZE_32;
+    }
+
+    void event(const unsigned flags) {
+        if (flags & Dma::Ifcr::TEIF) {
+            // channel is disabled by hardware
+            stop();
+            return;
+        }
+        // both flags at once: one half was lost by interrupt latency
+        const unsigned both = Dma::Ifcr::TCIF | Dma::Ifcr::HTIF;
+        if ((flags & both) == both) _overruns = _overruns + 1;
+        // half which DMA is transferring now (CNDTR counts down)
+        const unsigned active = _dma.CHANNEL(_channel).CNDTR.r > _half ? 0 : 1;
+        const unsigned index = active ^ 1;
+        if (_held[active]) _overruns = _overruns + 1;
+        _held[index] = true;
+        if (_ready) {
+            _ready(_context, _buffer + index * _half, _half);
+        } else {
+            _taken = index;
+        }
+    }
+};
+
+}
@@ -0,0 +1,299 @@
+/**
+* I2C master transactions
+*
+* Asynchronous I2C v2 master, data are moved by DMA (TXDR, RXDR), CPU is
+* interrupted only at end of transaction and every 255 bytes:
+*  - NBYTES is 8 bit, longer transfers use RELOAD, next NBYTES is written
+*    on TCR
+*  - last chunk uses AUTOEND, STOP is generated by hardware and
+*    transaction is complete on STOPF
+*  - write_read() (register read) ends write phase without AUTOEND and
+*    issues repeated start for read phase on TC
+*  - NACK is reported after automatic STOP (byte prefetched by DMA into
+*    TXDR is flushed), bus error and arbitration
+*    lost reset the peripheral (PE) and are reported immediately
+* DMA interrupts are not used.
+*
+* Example:
+*   io::I2cMaster i2c(io::I2C1, io::DMA1, 3, 2);
+*   i2c.configure(0x00201d2b);  // TIMINGR
+*   const uint8_t reg = 0x28;
+*   i2c.write_read(0x6a, &reg, 1, data, 10, done, nullptr);
+*
+*   void I2C1_handler() { i2c.handle_isr(); }
+*
+* MCUs containing this peripheral:
+*  - all MCUs with I2C v2 and DMA v1 (F0, F3, L0, L4)
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "io/reg/stm32/_common/i2c_v2.hpp"
+#include "io/reg/stm32/_common/dma_v1.hpp"
+
+namespace io {
+
+class I2cMaster {
+public:
+    static const size_t MAX_SIZE = 0xffff;
+
+    /** Transaction result
+     */
+    enum class Status {
+        OK,
+        NACK,  // address or data not acknowledged
+        BUS_ERROR,  // misplaced START or STOP
+        ARBITRATION_LOST,
+        TIMEOUT,  // SCL low timeout (TIMEOUTR)
+    };
+
+    /** Done callback
+     * called from interrupt when transaction is complete,
+     * next transaction can be started from callback
+     * @param context user context
+     * @param status result of transaction
+     */
+    typedef void (*done_t)(void *context, Status status);
+
+    /** I2cMaster constructor
+     * @param i2c I2C
+     * @param dma DMA controller
+     * @param rx_channel DMA channel connected to I2C RX request (1 - 7)
+     * @param tx_channel DMA channel connected to I2C TX request (1 - 7)
+     */
+    I2cMaster(I2c &i2c, Dma &dma, const unsigned rx_channel, const unsigned tx_channel) :
+        _i2c(i2c),
+        _dma(dma),
+        _rx_channel(rx_channel),
+        _tx_channel(tx_channel) {}
+
+    /** Configure and enable I2C master
+     * @param timingr TIMINGR value (see I2cTiming)
+     */
+    void configure(const uint32_t timingr) {
+        _i2c.CR1.modify([](I2c::Cr1 &cr1) { cr1.b.PE = 0; });
+        _i2c.TIMINGR.r = timingr;
+        _i2c.CR1.modify([](I2c::Cr1 &cr1) {
+            cr1.b.NACKIE = 1;
+            cr1.b.STOPIE = 1;
+            cr1.b.TCIE = 1;
+            cr1.b.ERRIE = 1;
+            cr1.b.TXDMAEN = 1;
+            cr1.b.RXDMAEN = 1;
+            cr1.b.PE = 1;
+        });
+    }
+
+    /** Write data
+     * @param address 7 bit slave address
+     * @param data data (must be valid until done), size 0 only address
+     * @param size number of bytes (max 65535)
+     * @param done called when transaction is complete
+     * @param context user context for callback
+     * @return false if previous transaction is still running
+     */
+    bool write(const uint8_t address, const uint8_t *data, const size_t size, done_t done=nullptr, void *context=nullptr) {
+        return start(address, data, size, nullptr, 0, done, context);
+    }
+
+    /** Read data
+     * @param address 7 bit slave address
+     * @param data buffer for received data
+     * @param size number of bytes (1 - 65535)
+     * @param done called when transaction is complete
+     * @param context user context for callback
+     * @return false if previous transaction is still running
+     */
+    bool read(const uint8_t address, uint8_t *data, const size_t size, done_t done=nullptr, void *context=nullptr) {
+        if (!size) return false;
+        return start(address, nullptr, 0, data, size, done, context);
+    }
+
+    /** Write then read with repeated start (e.g. register address then data)
+     * [S] [addr W] [write data ..] [Sr] [addr R] [read data ..] [P]
+     * @param address 7 bit slave address
+     * @param write_data data to write (must be valid until done)
+     * @param write_size number of bytes to write (1 - 65535)
+     * @param read_data buffer for received data
+     * @param read_size number of bytes to read (1 - 65535)
+     * @param done called when transaction is complete
+     * @param context user context for callback
+     * @return false if previous transaction is still running
+     */
+    bool write_read(const uint8_t address, const uint8_t *write_data, const size_t write_size, uint8_t *read_data, const size_t read_size, done_t done=nullptr, void *context=nullptr) {
+        if (!write_size || !read_size) return false;
+        return start(address, write_data, write_size, read_data, read_size, done, context);
+    }
+
+    /** Check if transaction is running
+     */
+    bool is_busy() const {
+        return _busy;
+    }
+
+    /** Wait until transaction is complete
+     */
+    void wait() const {
+        while (_busy) {}
+    }
+
+    /** I2C interrupt handler
+     * call from I2C (event and error) interrupt handler
+     */
+    void handle_isr() {
+        // single read of flags
+        const I2c::Isr isr = _i2c.ISR.read();
+        const uint32_t errors = isr.r & error_flags();
+        if (errors) {
+            _i2c.ICR.r = errors;
+            abort(isr.b.ARLO ? Status::ARBITRATION_LOST : isr.b.TIMEOUT ? Status::TIMEOUT : Status::BUS_ERROR);
+            return;
+        }
+        // STOP is generated by hardware after NACK
+        if (isr.b.NACKF) _status = Status::NACK;
+        const uint32_t end = isr.r & end_flags();
+        if (end) _i2c.ICR.r = end;
+        if (isr.b.STOPF) {
+            finish();
+        } else if (isr.b.TCR) {
+            reload();
+        } else if (isr.b.TC && !_last) {
+            // write phase done, repeated start for read phase
+            start_phase(true, _read_size);
+        }
+    }
+
+private:
+    static const size_t MAX_NBYTES = 255;
+
+    I2c &_i2c;
+    Dma &_dma;
+    const unsigned _rx_channel;
+    const unsigned _tx_channel;
+    uint8_t _address = 0;
+    size_t _read_size = 0;
+    size_t _remaining = 0;
+    bool _last = false;
+    done_t _done = nullptr;
+    void *_context = nullptr;
+    volatile Status _status = Status::OK;
+    volatile bool _busy = false;
+
+    bool start(const uint8_t address, const uint8_t *write_data, const size_t write_size, uint8_t *read_data, const size_t read_size, done_t done, void *context) {
+        if (_busy || write_size > MAX_SIZE || read_size > MAX_SIZE) return false;
+        _busy = true;
+        _address = address;
+        _read_size = read_size;
+        _done = done;
+        _context = context;
+        _status = Status::OK;
+        if (write_size) start_channel(_tx_channel, write_data, write_size, true);
+        if (read_size) start_channel(_rx_channel, read_data, read_size, false);
+        if (write_size || !read_size) {
+            start_phase(false, write_size);
+        } else {
+            start_phase(true, read_size);
+        }
+        return true;
+    }
+
+    void start_channel(const unsigned channel, const void *memory, const size_t size, const bool tx) {
+        Dma::Channel &ch = _dma.CHANNEL(channel);
+        ch.CCR.r = 0;
+        ch.CPAR.PAR(tx ? static_cast<volatile void *>(&_i2c.TXDR) : static_cast<volatile void *>(&_i2c.RXDR));
+        ch.CMAR.MAR(memory);
+        ch.CNDTR.r = static_cast<uint32_t>(size);
+        ch.CCR.write([tx](Dma::Channel::Ccr &ccr) {
+            ccr.b.DIR = tx;
+            ccr.b.MINC = 1;
+            ccr.PSIZE(Dma::Channel::Ccr::Size::SIZE_8);
+            ccr.MSIZE(Dma::Channel::Ccr::Size::SIZE_8);
+            ccr.PL(Dma::Channel::Ccr::Pl::HIGH);
+            ccr.b.EN = 1;
+        });
+    }
+
+    /** Start (or repeated start) of phase
+     * @param read read direction
+     * @param size number of bytes of phase
+     */
+    void start_phase(const bool read, const size_t size) {
+        const size_t nbytes = size > MAX_NBYTES ? MAX_NBYTES : size;
+        _remaining = size - nbytes;
+        _last = read || !_read_size;
+        const uint32_t sadd = static_cast<uint32_t>(_address) << 1;
+        const bool reload = _remaining != 0;
+        const bool autoend = _last && !reload;
+        _i2c.CR2.write([sadd, read, nbytes, reload, autoend](I2c::Cr2 &cr2) {
+            cr2.b.SADD = sadd;
+            cr2.b.RD_WRN = read;
+            cr2.b.NBYTES = static_cast<uint32_t>(nbytes);
+            cr2.b.RELOAD = reload;
+            cr2.b.AUTOEND = autoend;
+            cr2.b.START = 1;
+        });
+    }
+
+    /** Next chunk of phase (TCR)
+     */
+    void reload() {
+        const size_t nbytes = _remaining > MAX_NBYTES ? MAX_NBYTES : _remaining;
+        _remaining -= nbytes;
+        const bool reload = _remaining != 0;
+        const bool autoend = _last && !reload;
+        _i2c.CR2.modify([nbytes, reload, autoend](I2c::Cr2 &cr2) {
+            cr2.b.NBYTES = static_cast<uint32_t>(nbytes);
+            cr2.b.RELOAD = reload;
+            cr2.b.AUTOEND = autoend;
+            cr2.b.START = 0;
+        });
+    }
+
+    /** Error flags (the same bits in Isr and Icr)
+     */
+    static uint32_t error_flags() {
+        I2c::Icr icr;
+        icr.b.BERRCF = 1;
+        icr.b.ARLOCF = 1;
+        icr.b.TIMOUTCF = 1;
+        return icr.r;
+    }
+
+    /** Flags of end of transaction (TC and TCR are cleared by CR2)
+     */
+    static uint32_t end_flags() {
+        I2c::Icr icr;
+        icr.b.NACKCF = 1;
+        icr.b.STOPCF = 1;
+        return icr.r;
+    }
+
+    void stop_dma() {
+        _dma.CHANNEL(_tx_channel).CCR.r = 0;
+        _dma.CHANNEL(_rx_channel).CCR.r = 0;
+    }
+
+    void finish() {
+        stop_dma();
+        // flush TXDR, DMA may have written byte which was not sent (NACK)
+        _i2c.ISR.write([](I2c::Isr &isr) { isr.b.TXE = 1; });
+        _busy = false;
+        if (_done) _done(_context, _status);
+    }
+
+    /** Error, software reset of I2C (clears flags and releases lines)
+     */
+    void abort(const Status status) {
+        _status = status;
+        _i2c.CR1.modify([](I2c::Cr1 &cr1) { cr1.b.PE = 0; });
+        // PE must stay low for 3 APB clock cycles, read back
+        while (_i2c.CR1.read().b.PE) {}
+        _i2c.CR1.modify([](I2c::Cr1 &cr1) { cr1.b.PE = 1; });
+        finish();
+    }
+};
+
+}
@@ -0,0 +1,158 @@
+/**
+* Batched I2C read scheduler
+*
+* Periodic register reads of more devices on one I2C bus merged into one
+* continuous sequence per cycle: cycle() (e.g. from timer interrupt)
+* starts first due read, each next read is started from done callback
+* of previous one (I2C interrupt), so there is no idle time between
+* devices. When all due reads are complete, snapshot callback is called
+* once with timestamp of cycle start (passed to cycle(), e.g. timer
+* counter), so all samples of cycle share one timestamp without jitter.
+*
+* Each read is write_read() of register pointer and data with repeated
+* start, read is due every `period` cycles.
+* Data buffers of reads are valid in snapshot callback until next cycle.
+*
+* Example:
+*   io::I2cScheduler<> scheduler(i2c, snapshot, nullptr);
+*   io::I2cScheduler<>::Read accel = {0x6a, 0x28, accel_data, 6, 1};
+*   io::I2cScheduler<>::Read baro = {0x76, 0xf7, baro_data, 6, 4};
+*   scheduler.add(accel);
+*   scheduler.add(baro);
+*
+*   void TIM14_handler() { ...; scheduler.cycle(timestamp); }
+*   void snapshot(void *, const io::I2cScheduler<>::Snapshot &s) { ... }
+*
+* MCUs containing this peripheral:
+*  - all MCUs with I2C v2 and DMA v1 (see I2cMaster)
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "io/lib/stm32/_common/i2c_master.hpp"
+
+namespace io {
+
+template <unsigned MAX=8>
+class I2cScheduler {
+    static_assert(MAX >= 1 && MAX <= 32, "MAX must be 1 - 32");
+
+public:
+    /** Periodic read (owned by caller)
+     */
+    struct Read {
+        uint8_t address;  // 7 bit slave address
+        uint8_t reg;  // register pointer written before read
+        uint8_t *data;  // buffer for data
+        size_t size;  // number of bytes to read
+        unsigned period;  // read every period cycles (0 same as 1)
+    };
+
+    /** Result of one cycle
+     */
+    struct Snapshot {
+        uint32_t timestamp;  // timestamp passed to cycle()
+        uint32_t cycle;  // cycle number
+        uint32_t read;  // mask of reads (index by add()) which were due in this cycle
+        uint32_t failed;  // mask of reads which failed (NACK, bus error), data are not valid
+    };
+
+    /** Snapshot callback
+     * called from interrupt when all due reads of cycle are complete
+     * @param context user context
+     * @param snapshot result of cycle
+     */
+    typedef void (*snapshot_t)(void *context, const Snapshot &snapshot);
+
+    /** I2cScheduler constructor
+     * @param i2c I2C master (used only by scheduler during cycle)
+     * @param snapshot called at end of each cycle
+     * @param context user context for callback
+     */
+    I2cScheduler(I2cMaster &i2c, snapshot_t snapshot, void *context=nullptr) :
+        _i2c(i2c),
+        _snapshot(snapshot),
+        _context(context) {}
+
+    /** Add read
+     * (only when no cycle is running)
+     * @param read read description (must stay valid)
+     * @return false if there is already MAX reads
+     */
+    bool add(Read &read) {
+        if (_count >= MAX || _busy) return false;
+        _reads[_count++] = &read;
+        return true;
+    }
+
+    /** Start cycle
+     * @param timestamp timestamp of cycle for snapshot
+     * @return false if previous cycle is still running (overrun, cycle is skipped)
+     */
+    bool cycle(const uint32_t timestamp) {
+        if (_busy) {
+            _overruns = _overruns + 1;
+            return false;
+        }
+        _busy = true;
+        _current = {timestamp, _cycle, 0, 0};
+        for (unsigned i = 0; i < _count; i++) {
+            const unsigned period = _reads[i]->period ? _reads[i]->period : 1;
+            if (_cycle % period == 0) _current.read |= 1u << i;
+        }
+        _cycle = _cycle + 1;
+        _index = 0;
+        next();
+        return true;
+    }
+
+    /** Check if cycle is running
+     */
+    bool is_busy() const {
+        return _busy;
+    }
+
+    /** Number of skipped cycles (previous cycle was still running)
+     */
+    unsigned overruns() const {
+        return _overruns;
+    }
+
+private:
+    I2cMaster &_i2c;
+    snapshot_t _snapshot;
+    void *_context;
+    Read *_reads[MAX] = {};
+    unsigned _count = 0;
+    unsigned _index = 0;
+    uint32_t _cycle = 0;
+    Snapshot _current = {0, 0, 0, 0};
+    volatile bool _busy = false;
+    volatile unsigned _overruns = 0;
+
+    /** Start next due read or finish cycle
+     */
+    void next() {
+        while (_index < _count) {
+            const unsigned index = _index++;
+            if (!(_current.read & (1u << index))) continue;
+            Read &read = *_reads[index];
+            if (_i2c.write_read(read.address, &read.reg, 1, read.data, read.size, done, this)) return;
+            _current.failed |= 1u << index;
+        }
+        const Snapshot snapshot = _current;
+        _busy = false;
+        if (_snapshot) _snapshot(_context, snapshot);
+    }
+
+    static void done(void *context, const I2cMaster::Status status) {
+        I2cScheduler &scheduler = *static_cast<I2cScheduler *>(context);
+        if (status != I2cMaster::Status::OK) scheduler._current.failed |= 1u << (scheduler._index - 1);
+        scheduler.next();
+    }
+};
+
+}
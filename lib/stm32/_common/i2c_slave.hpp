@@ -0,0 +1,320 @@
+/**
+* I2C slave register file
+*
+* I2C v2 slave answering own address 1 (OAR1) and range of addresses
+* by own address 2 with mask (OAR2 OA2MSK), each matched address is
+* mapped by select callback to register file (e.g. I/O expander).
+*
+* Register file semantic:
+*   write: [S] [addr W] [pointer] [data ..] [P]  data stored from pointer
+*   read:  [S] [addr W] [pointer] [Sr] [addr R] [data ..] [P]  data sent from pointer
+*   read without pointer starts at last pointer of the same address
+* Pointer is kept per address (ADDCODE) and advanced by written bytes (not
+* by read bytes, DMA prefetch of TXDR make number of really read bytes
+* unknown).
+*
+* Data are moved by DMA directly from/into register file, CPU handle only
+* ADDR, pointer byte and STOPF, so clock is stretched only for ADDR and
+* pointer byte interrupt latency. Bytes beyond end of register file are
+* dropped (write) or 0xff (read).
+*
+* Example:
+*   io::I2cSlave slave(io::I2C1, io::DMA1, 3, 2);
+*   slave.configure(0x20, 0x40, 2);  // 0x20 and 0x40 - 0x43
+*   slave.start(select, written, nullptr);
+*
+*   io::I2cSlave::File select(void *, uint8_t address) { return {regs[address & 3], sizeof(regs[0])}; }
+*   void written(void *, uint8_t address, size_t offset, size_t size) { apply(address, offset, size); }
+*
+*   void I2C1_handler() { slave.handle_isr(); }
+*   void DMA1_CH2_3_DMA2_CH1_2_handler() { slave.handle_dma_isr(); }
+*
+* MCUs containing this peripheral:
+*  - all MCUs with I2C v2 and DMA v1 (F0, F3, L0, L4)
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "io/reg/stm32/_common/i2c_v2.hpp"
+#include "io/reg/stm32/_common/dma_v1.hpp"
+
+namespace io {
+
+class I2cSlave {
+public:
+    /** Register file (size 0 for no file, writes are dropped and reads return 0xff)
+     */
+    struct File {
+        uint8_t *data;
+        size_t size;
+    };
+
+    /** Select callback
+     * called from interrupt on address match
+     * @param context user context
+     * @param address matched 7 bit address
+     * @return register file of address
+     */
+    typedef File (*select_t)(void *context, uint8_t address);
+
+    /** Written callback
+     * called from interrupt when master wrote data into register file
+     * @param context user context
+     * @param address 7 bit address
+     * @param offset pointer of first written byte
+     * @param size number of written bytes
+     */
+    typedef void (*written_t)(void *context, uint8_t address, size_t offset, size_t size);
+
+    /** I2cSlave constructor
+     * @param i2c I2C
+     * @param dma DMA controller
+     * @param rx_channel DMA channel connected to I2C RX request (1 - 7)
+     * @param tx_channel DMA channel connected to I2C TX request (1 - 7)
+     */
+    I2cSlave(I2c &i2c, Dma &dma, const unsigned rx_channel, const unsigned tx_channel) :
+        _i2c(i2c),
+        _dma(dma),
+        _rx_channel(rx_channel),
+        _tx_channel(tx_channel) {}
+
+    /** Configure own addresses
+     * (I2C must be disabled, TIMINGR must be set for SDADEL/SCLDEL)
+     * @param address1 own address 1 (7 bit)
+     * @param address2 own address 2 (7 bit), 0 for none
+     * @param mask2 OA2MSK: number of masked low bits of address 2 (0 - 7)
+     */
+    void configure(const uint8_t address1, const uint8_t address2=0, const uint8_t mask2=0) {
+        _i2c.OAR1.r = 0;
+        _i2c.OAR1.write([address1](I2c::Oar1 &oar1) {
+            oar1.b.OA1 = static_cast<uint32_t>(address1) << 1;
+            oar1.b.OA1EN = 1;
+        });
+        _i2c.OAR2.r = 0;
+        if (address2) {
+            _i2c.OAR2.write([address2, mask2](I2c::Oar2 &oar2) {
+                oar2.b.OA2 = address2;
+                oar2.b.OA2MASK = mask2;
+                oar2.b.OA2EN = 1;
+            });
+        }
+    }
+
+    /** Enable slave
+     * @param select maps address to register file
+     * @param written called after master wrote data (nullptr for none)
+     * @param context user context for callbacks
+     */
+    void start(select_t select, written_t written=nullptr, void *context=nullptr) {
+        _select = select;
+        _written = written;
+        _context = context;
+        _state = State::IDLE;
+        _i2c.CR1.modify([](I2c::Cr1 &cr1) {
+            cr1.b.ADDRIE = 1;
+            cr1.b.STOPIE = 1;
+            cr1.b.NACKIE = 1;
+            cr1.b.ERRIE = 1;
+            cr1.b.TXDMAEN = 1;
+            cr1.b.RXDMAEN = 1;
+            cr1.b.SBC = 0;
+            cr1.b.NOSTRETCH = 0;
+            cr1.b.PE = 1;
+        });
+    }
+
+    /** Disable slave
+     */
+    void stop() {
+        _i2c.CR1.modify([](I2c::Cr1 &cr1) { cr1.b.PE = 0; });
+        stop_dma();
+        _state = State::IDLE;
+    }
+
+    /** Number of bus errors and overruns
+     */
+    unsigned errors() const {
+        return _errors;
+    }
+
+    /** I2C interrupt handler
+     * call from I2C (event and error) interrupt handler
+     */
+    void handle_isr() {
+        // single read of flags
+        const I2c::Isr isr = _i2c.ISR.read();
+        const uint32_t errors = isr.r & error_flags();
+        if (errors) {
+            _i2c.ICR.r = errors;
+            _errors = _errors + 1;
+        }
+        if (isr.b.NACKF) _i2c.ICR.write([](I2c::Icr &icr) { icr.b.NACKCF = 1; });
+        if (isr.b.RXNE && (_state == State::POINTER || _state == State::DISCARD)) {
+            receive(static_cast<uint8_t>(_i2c.RXDR.r));
+        }
+        if (isr.b.TXIS && _state == State::FILL) {
+            _i2c.TXDR.r = 0xff;
+        }
+        if (isr.b.STOPF) {
+            _i2c.ICR.write([](I2c::Icr &icr) { icr.b.STOPCF = 1; });
+            end();
+        }
+        // ADDR is last, repeated start may follow data of previous phase
+        if (isr.b.ADDR) address(isr);
+    }
+
+    /** DMA interrupt handler (RX and TX channel)
+     * call from interrupt handler of DMA channels
+     */
+    void handle_dma_isr() {
+        const unsigned rx_shift = (_rx_channel - 1) << 2;
+        const unsigned tx_shift = (_tx_channel - 1) << 2;
+        const uint32_t flags = _dma.ISR.r;
+        const unsigned rx = (flags >> rx_shift) & (Dma::Ifcr::TCIF | Dma::Ifcr::TEIF);
+        const unsigned tx = (flags >> tx_shift) & (Dma::Ifcr::TCIF | Dma::Ifcr::TEIF);
+        if (rx) {
+            // only read flags, flag raised after the read stays pending (GIF would clear it)
+            _dma.IFCR.clear_flags(_rx_channel, rx);
+            // register file is full, drop remaining bytes
+            if (_state == State::RX) {
+                _state = State::DISCARD;
+                _i2c.CR1.modify([](I2c::Cr1 &cr1) { cr1.b.RXIE = 1; });
+            }
+        }
+        if (tx) {
+            _dma.IFCR.clear_flags(_tx_channel, tx);
+            // end of register file, send 0xff
+            if (_state == State::TX) {
+                _state = State::FILL;
+                _i2c.CR1.modify([](I2c::Cr1 &cr1) { cr1.b.TXIE = 1; });
+            }
+        }
+    }
+
+private:
+    enum class State {
+        IDLE,
+        POINTER,  // waiting for pointer byte
+        RX,  // receiving by DMA
+        DISCARD,  // receiving beyond end of file
+        TX,  // sending by DMA
+        FILL,  // sending beyond end of file
+    };
+
+    I2c &_i2c;
+    Dma &_dma;
+    const unsigned _rx_channel;
+    const unsigned _tx_channel;
+    select_t _select = nullptr;
+    written_t _written = nullptr;
+    void *_context = nullptr;
+    File _file = {nullptr, 0};
+    uint8_t _address = 0;
+    size_t _pointers[128] = {};  // per 7 bit address
+    size_t _count = 0;
+    volatile State _state = State::IDLE;
+    volatile unsigned _errors = 0;
+
+    /** Error flags (the same bits in Isr and Icr)
+     */
+    static uint32_t error_flags() {
+        I2c::Icr icr;
+        icr.b.BERRCF = 1;
+        icr.b.ARLOCF = 1;
+        icr.b.OVRCF = 1;
+        icr.b.TIMOUTCF = 1;
+        return icr.r;
+    }
+
+    void stop_dma() {
+        _dma.CHANNEL(_rx_channel).CCR.r = 0;
+        _dma.CHANNEL(_tx_channel).CCR.r = 0;
+        _i2c.CR1.modify([](I2c::Cr1 &cr1) {
+            cr1.b.RXIE = 0;
+            cr1.b.TXIE = 0;
+        });
+    }
+
+    void start_channel(const unsigned channel, uint8_t *memory, const size_t size, const bool tx) {
+        Dma::Channel &ch = _dma.CHANNEL(channel);
+        ch.CCR.r = 0;
+        _dma.IFCR.clear_flags(channel);
+        ch.CPAR.PAR(tx ? static_cast<volatile void *>(&_i2c.TXDR) : static_cast<volatile void *>(&_i2c.RXDR));
+        ch.CMAR.MAR(memory);
+        ch.CNDTR.r = static_cast<uint32_t>(size);
+        ch.CCR.write([tx](Dma::Channel::Ccr &ccr) {
+            ccr.b.DIR = tx;
+            ccr.b.MINC = 1;
+            ccr.PSIZE(Dma::Channel::Ccr::Size::SIZE_8);
+            ccr.MSIZE(Dma::Channel::Ccr::Size::SIZE_8);
+            ccr.PL(Dma::Channel::Ccr::Pl::VERY_HIGH);
+            ccr.b.TCIE = 1;
+            ccr.b.EN = 1;
+        });
+    }
+
+    /** Address matched, ADDR is cleared after DMA is ready
+     */
+    void address(const I2c::Isr flags) {
+        end();
+        _address = static_cast<uint8_t>(flags.b.ADDCODE);
+        _file = _select ? _select(_context, _address) : File{nullptr, 0};
+        if (flags.b.DIR) {
+            // slave transmitter, flush TXDR (may hold byte from previous read)
+            _i2c.ISR.write([](I2c::Isr &isr) { isr.b.TXE = 1; });
+            const size_t pointer = _pointers[_address];
+            if (pointer < _file.size) {
+                _state = State::TX;
+                start_channel(_tx_channel, _file.data + pointer, _file.size - pointer, true);
+            } else {
+                _state = State::FILL;
+                _i2c.CR1.modify([](I2c::Cr1 &cr1) { cr1.b.TXIE = 1; });
+            }
+        } else {
+            _state = State::POINTER;
+            _i2c.CR1.modify([](I2c::Cr1 &cr1) { cr1.b.RXIE = 1; });
+        }
+        _i2c.ICR.write([](I2c::Icr &icr) { icr.b.ADDRCF = 1; });
+    }
+
+    /** Byte received by CPU (pointer or beyond end of file)
+     */
+    void receive(const uint8_t data) {
+        if (_state == State::DISCARD) return;
+        _pointers[_address] = data;
+        _i2c.CR1.modify([](I2c::Cr1 &cr1) { cr1.b.RXIE = 0; });
+        if (data < _file.size) {
+            _state = State::RX;
+            _count = _file.size - data;
+            start_channel(_rx_channel, _file.data + data, _count, false);
+        } else {
+            _state = State::DISCARD;
+            _count = 0;
+            _i2c.CR1.modify([](I2c::Cr1 &cr1) { cr1.b.RXIE = 1; });
+        }
+    }
+
+    /** End of phase (STOP or repeated start)
+     */
+    void end() {
+        const State state = _state;
+        size_t received = 0;
+        if (state == State::RX) {
+            received = _count - _dma.CHANNEL(_rx_channel).CNDTR.r;
+        } else if (state == State::DISCARD) {
+            received = _count;
+        }
+        stop_dma();
+        _state = State::IDLE;
+        if (received) {
+            const size_t offset = _pointers[_address];
+            _pointers[_address] = offset + received;
+            if (_written) _written(_context, _address, offset, received);
+        }
+    }
+};
+
+}
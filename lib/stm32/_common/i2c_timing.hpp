@@ -0,0 +1,166 @@
+/**
+* I2C timing
+*
+* Compile time solver of TIMINGR (PRESC, SCLL, SCLH, SDADEL, SCLDEL) for
+* I2C v2 from kernel clock, bus speed and rise/fall times, with
+* I2C specification limits of Standard-mode (100 kHz), Fast-mode
+* (400 kHz) and Fast-mode Plus (1 MHz), analog filter on and digital
+* filter off.
+*
+* Smallest PRESC (finest resolution) which satisfy all limits is used:
+*  - SDADEL: tf - tAF(min) - 3 * tI2CCLK <= tSDADEL <= tVD;DAT(max) - tr - tAF(max) - 4 * tI2CCLK
+*  - SCLDEL: tSCLDEL >= tr + tSU;DAT(min)
+*  - SCLL, SCLH: tLOW >= tLOW(min), tHIGH >= tHIGH(min) and SCL period
+*    (with synchronization delays) >= 1 / speed, so bus is never faster
+*    than requested
+* Compilation fails when no valid setting exists or when real speed is
+* more than tolerance below requested speed (minimal SCL low/high times
+* and slow edges may not fit into period, e.g. Fast-mode Plus with low
+* kernel clock).
+*
+* Example:
+*   typedef io::I2cTiming<48000000, 400000, 100, 10> Timing;
+*   i2c.configure(Timing::timingr);  // Timing::speed is real bus speed
+*
+* Fast-mode Plus on F0 needs also SYSCFG I2C_FMP bits (20 mA drive).
+*
+* MCUs containing this peripheral:
+*  - all MCUs with I2C v2 (F0, F3, F7, H7, L0, L4)
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "io/reg/stm32/_common/i2c_v2.hpp"
+
+namespace io {
+
+namespace i2c_timing {
+
+/** I2C specification limits in ns
+ */
+struct Mode {
+    uint32_t speed;  // max bus speed (Hz)
+    uint32_t low_min;  // tLOW
+    uint32_t high_min;  // tHIGH
+    uint32_t setup_min;  // tSU;DAT
+    uint32_t valid_max;  // tVD;DAT
+    uint32_t rise_max;  // tr
+    uint32_t fall_max;  // tf
+};
+
+constexpr Mode STANDARD = {100000, 4700, 4000, 250, 3450, 1000, 300};
+constexpr Mode FAST = {400000, 1300, 600, 100, 900, 300, 300};
+constexpr Mode FAST_PLUS = {1000000, 500, 260, 50, 450, 120, 120};
+
+// analog filter delay
+static const uint32_t AF_MIN = 50;
+static const uint32_t AF_MAX = 260;
+
+constexpr Mode mode(const uint32_t speed) {
+    return speed <= STANDARD.speed ? STANDARD : speed <= FAST.speed ? FAST : FAST_PLUS;
+}
+
+/** Solved timing
+ */
+struct Result {
+    bool valid;  // false when there is no valid setting
+    uint32_t timingr;
+    uint32_t speed;  // real bus speed
+};
+
+constexpr int64_t div_ceil(const int64_t a, const int64_t b) {
+    return a <= 0 ? -((-a) / b) : (a + b - 1) / b;
+}
+
+/** Solve TIMINGR
+ * (all times in ps internally)
+ * @param clock I2C kernel clock in Hz
+ * @param speed bus speed in Hz
+ * @param rise SCL/SDA rise time in ns
+ * @param fall SCL/SDA fall time in ns
+ */
+constexpr Result solve(const uint32_t clock, const uint32_t speed, const uint32_t rise, const uint32_t fall) {
+    const Mode m = mode(speed);
+    const int64_t clk = (1000000000000ll + clock / 2) / clock;
+    const int64_t tr = rise * 1000ll;
+    const int64_t tf = fall * 1000ll;
+    const int64_t period = div_ceil(1000000000000ll, speed);
+    // synchronization of SCL edges (filter and 2 kernel clocks), lower bound
+    const int64_t sync = tf + tr + 2 * (AF_MIN * 1000ll + 2 * clk);
+    for (uint32_t presc = 0; presc < 16; presc++) {
+        const int64_t t = (presc + 1) * clk;
+        int64_t sdadel = div_ceil(tf - AF_MIN * 1000ll - 3 * clk, t);
+        if (sdadel < 0) sdadel = 0;
+        // with worst case filter delay Fast-mode Plus has negative margin, then only minimum is used
+        const int64_t margin = m.valid_max * 1000ll - tr - AF_MAX * 1000ll - 4 * clk;
+        const int64_t sdadel_max = margin < 0 ? -1 : margin / t;
+        int64_t scldel = div_ceil(tr + m.setup_min * 1000ll, t) - 1;
+        if (scldel < 0) scldel = 0;
+        if (sdadel > 15 || (sdadel_max >= 0 && sdadel > sdadel_max) || scldel > 15) continue;
+        int64_t low = div_ceil(m.low_min * 1000ll, t);
+        int64_t high = div_ceil(m.high_min * 1000ll, t);
+        const int64_t total = div_ceil(period - sync, t);
+        if (low + high < total) {
+            const int64_t extra = total - low - high;
+            low += (extra + 1) / 2;
+            high += extra / 2;
+        }
+        if (low > 256 || high > 256) continue;
+        const uint32_t timingr = (presc << 28) | (static_cast<uint32_t>(scldel) << 20) | (static_cast<uint32_t>(sdadel) << 16)
+            | (static_cast<uint32_t>(high - 1) << 8) | static_cast<uint32_t>(low - 1);
+        return {true, timingr, static_cast<uint32_t>(1000000000000ll / ((low + high) * t + sync))};
+    }
+    return {false, 0, 0};
+}
+
+/** Error of real speed in ppm (real speed is never above requested)
+ */
+constexpr uint32_t error_ppm(const uint32_t speed, const uint32_t real) {
+    return static_cast<uint32_t>(((speed - real) * static_cast<uint64_t>(1000000) + speed / 2) / speed);
+}
+
+}
+
+/** Compile time I2C timing
+ * @param CLOCK I2C kernel clock in Hz
+ * @param SPEED bus speed in Hz (max 1 MHz, mode is selected by speed)
+ * @param RISE rise time in ns (bus capacitance and pull-up)
+ * @param FALL fall time in ns
+ * @param TOLERANCE maximal error of real speed in ppm (default 5 %)
+ */
+template <uint32_t CLOCK, uint32_t SPEED, uint32_t RISE=100, uint32_t FALL=10, uint32_t TOLERANCE=50000>
+struct I2cTiming {
+    static_assert(SPEED > 0 && SPEED <= i2c_timing::FAST_PLUS.speed, "bus speed must be up to 1 MHz");
+    static_assert(RISE <= i2c_timing::mode(SPEED).rise_max, "rise time is above limit of I2C mode");
+    static_assert(FALL <= i2c_timing::mode(SPEED).fall_max, "fall time is above limit of I2C mode");
+
+    static constexpr i2c_timing::Result result = i2c_timing::solve(CLOCK, SPEED, RISE, FALL);
+    static constexpr uint32_t timingr = result.timingr;
+    static constexpr uint32_t speed = result.speed;
+    static constexpr uint32_t error_ppm = i2c_timing::error_ppm(SPEED, speed);
+
+    static_assert(result.valid, "no valid timing for this clock and bus speed");
+    static_assert(!result.valid || error_ppm <= TOLERANCE, "bus speed error is above tolerance");
+
+    /** Set TIMINGR
+     * (I2C must be disabled, PE = 0)
+     * @param i2c I2C
+     */
+    static void configure(I2c &i2c) {
+        i2c.TIMINGR.r = timingr;
+    }
+};
+
+template <uint32_t CLOCK, uint32_t SPEED, uint32_t RISE, uint32_t FALL, uint32_t TOLERANCE>
+constexpr i2c_timing::Result I2cTiming<CLOCK, SPEED, RISE, FALL, TOLERANCE>::result;
+template <uint32_t CLOCK, uint32_t SPEED, uint32_t RISE, uint32_t FALL, uint32_t TOLERANCE>
+constexpr uint32_t I2cTiming<CLOCK, SPEED, RISE, FALL, TOLERANCE>::timingr;
+template <uint32_t CLOCK, uint32_t SPEED, uint32_t RISE, uint32_t FALL, uint32_t TOLERANCE>
+constexpr uint32_t I2cTiming<CLOCK, SPEED, RISE, FALL, TOLERANCE>::speed;
+template <uint32_t CLOCK, uint32_t SPEED, uint32_t RISE, uint32_t FALL, uint32_t TOLERANCE>
+constexpr uint32_t I2cTiming<CLOCK, SPEED, RISE, FALL, TOLERANCE>::error_ppm;
+
+}
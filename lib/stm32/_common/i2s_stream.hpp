@@ -0,0 +1,268 @@
+/**
+* I2S audio stream
+*
+* Continuous I2S transmit or receive (SPI in I2S mode) on circular DMA
+* double buffer (DmaStream), no interrupt per sample, ready callback is
+* called for each half of buffer (receive: half with new samples,
+* transmit: half which can be filled).
+*
+* Frames 16, 24 and 32 bits, DMA always move 16 bit halfwords:
+*  - 16 bit data: one halfword per sample
+*  - 24 and 32 bit data: two halfwords per sample, high halfword first
+*    (use sample32() and set_sample32())
+* Samples in buffer are interleaved left, right.
+*
+* Compile time prescaler (I2SDIV, ODD, MCKOE):
+*   Fs = I2SCLK / (F * (2 * I2SDIV + ODD))
+*   F = 256 with master clock output, 64 with 32 bit channel, 32 with 16 bit channel
+* Compilation fails when sample rate error is above tolerance.
+*
+* Example:
+*   typedef io::I2sPrescaler<86000000, 48000, 32> Prescaler;  // 47991 Hz
+*   io::I2sStream i2s(io::SPI2, io::DMA1, 4);
+*   i2s.configure<Prescaler>(io::Spi::I2scfgr::I2scfg::MASTER_RX, io::Spi::I2scfgr::Datalen::DATALEN_24);
+*   i2s.start(buffer, 512, ready, nullptr);
+*
+*   void ready(void *, uint16_t *data, size_t count) {
+*       process(data, count);
+*       i2s.release(data);
+*   }
+*
+*   void DMA1_CH4_handler() { i2s.handle_dma_isr(); }
+*
+* MCUs containing this peripheral:
+*  - all MCUs with SPI v1 (I2S capable instances) and DMA v1 (F1, L0, L1)
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "io/reg/stm32/_common/spi_v1.hpp"
+#include "io/reg/stm32/_common/dma_v1.hpp"
+#include "io/lib/stm32/_common/dma_stream.hpp"
+
+namespace io {
+
+namespace i2s_prescaler {
+
+/** Clock cycles per sample for divider 1
+ * @param channel_bits channel length (16 or 32)
+ * @param mck master clock output enabled
+ */
+constexpr uint32_t factor(const unsigned channel_bits, const bool mck) {
+    return mck ? 256 : channel_bits * 2;
+}
+
+/** Divider (2 * I2SDIV + ODD) rounded to nearest
+ */
+constexpr uint32_t divider(const uint32_t clock, const uint32_t rate, const uint32_t factor) {
+    return static_cast<uint32_t>((static_cast<uint64_t>(clock) + static_cast<uint64_t>(rate) * factor / 2) / (static_cast<uint64_t>(rate) * factor));
+}
+
+/** Real sample rate
+ */
+constexpr uint32_t actual(const uint32_t clock, const uint32_t div, const uint32_t factor) {
+    return div ? static_cast<uint32_t>((clock + div * factor / 2) / (div * factor)) : 0;
+}
+
+/** Error in ppm (absolute value)
+ */
+constexpr uint32_t error_ppm(const uint32_t rate, const uint32_t real) {
+    return static_cast<uint32_t>(((real > rate ? real - rate : rate - real) * static_cast<uint64_t>(1000000) + rate / 2) / rate);
+}
+
+/** Divider is valid: I2SDIV 2 .. 255
+ */
+constexpr bool valid(const uint32_t div) {
+    return div >= 4 && div <= 511;
+}
+
+}
+
+/** Compile time I2S prescaler
+ * @param CLOCK I2S clock in Hz
+ * @param RATE sample rate in Hz (8000 - 96000)
+ * @param CHANNEL_BITS channel length (16 or 32, 32 is required for 24 and 32 bit data)
+ * @param MCK master clock output (256 * RATE)
+ * @param TOLERANCE maximal error in ppm (default 1 %)
+ */
+template <uint32_t CLOCK, uint32_t RATE, unsigned CHANNEL_BITS=16, bool MCK=false, uint32_t TOLERANCE=10000>
+struct I2sPrescaler {
+    static_assert(RATE >= 8000 && RATE <= 96000, "sample rate must be 8 - 96 kHz");
+    static_assert(CHANNEL_BITS == 16 || CHANNEL_BITS == 32, "channel length must be 16 or 32 bits");
+
+    static constexpr unsigned channel_bits = CHANNEL_BITS;
+    static constexpr uint32_t factor = i2s_prescaler::factor(CHANNEL_BITS, MCK);
+    static constexpr uint32_t divider = i2s_prescaler::divider(CLOCK, RATE, factor);
+    static constexpr uint32_t i2spr = (divider >> 1) | ((divider & 1) << 8) | (MCK ? 1u << 9 : 0);
+    static constexpr uint32_t actual = i2s_prescaler::actual(CLOCK, divider, factor);
+    static constexpr uint32_t error_ppm = i2s_prescaler::error_ppm(RATE, actual);
+
+    static_assert(i2s_prescaler::valid(divider), "sample rate is out of range for this clock");
+    static_assert(error_ppm <= TOLERANCE, "sample rate error is above tolerance");
+};
+
+template <uint32_t CLOCK, uint32_t RATE, unsigned CHANNEL_BITS, bool MCK, uint32_t TOLERANCE>
+constexpr unsigned I2sPrescaler<CLOCK, RATE, CHANNEL_BITS, MCK, TOLERANCE>::channel_bits;
+template <uint32_t CLOCK, uint32_t RATE, unsigned CHANNEL_BITS, bool MCK, uint32_t TOLERANCE>
+constexpr uint32_t I2sPrescaler<CLOCK, RATE, CHANNEL_BITS, MCK, TOLERANCE>::factor;
+template <uint32_t CLOCK, uint32_t RATE, unsigned CHANNEL_BITS, bool MCK, uint32_t TOLERANCE>
+constexpr uint32_t I2sPrescaler<CLOCK, RATE, CHANNEL_BITS, MCK, TOLERANCE>::divider;
+template <uint32_t CLOCK, uint32_t RATE, unsigned CHANNEL_BITS, bool MCK, uint32_t TOLERANCE>
+constexpr uint32_t I2sPrescaler<CLOCK, RATE, CHANNEL_BITS, MCK, TOLERANCE>::i2spr;
+template <uint32_t CLOCK, uint32_t RATE, unsigned CHANNEL_BITS, bool MCK, uint32_t TOLERANCE>
+constexpr uint32_t I2sPrescaler<CLOCK, RATE, CHANNEL_BITS, MCK, TOLERANCE>::actual;
+template <uint32_t CLOCK, uint32_t RATE, unsigned CHANNEL_BITS, bool MCK, uint32_t TOLERANCE>
+constexpr uint32_t I2sPrescaler<CLOCK, RATE, CHANNEL_BITS, MCK, TOLERANCE>::error_ppm;
+
+class I2sStream {
+public:
+    /** Ready callback
+     * called from interrupt when half of buffer is complete,
+     * half must be returned by release()
+     * @param context user context
+     * @param data first halfword of the half
+     * @param count number of halfwords in half
+     */
+    typedef DmaStream<uint16_t>::ready_t ready_t;
+
+    /** I2sStream constructor
+     * @param spi SPI with I2S
+     * @param dma DMA controller
+     * @param channel DMA channel connected to SPI TX (transmit) or RX (receive) request (1 - 7)
+     */
+    I2sStream(Spi &spi, Dma &dma, const unsigned channel) :
+        _spi(spi),
+        _stream(dma, channel) {}
+
+    /** Configure I2S
+     * (I2S must be disabled)
+     * @param PRESCALER I2sPrescaler (channel length must be 32 for 24 and 32 bit data)
+     * @param mode Spi::I2scfgr::I2scfg (MASTER_TX, MASTER_RX, SLAVE_TX, SLAVE_RX)
+     * @param datalen Spi::I2scfgr::Datalen (16, 24 or 32 bits)
+     * @param standard Spi::I2scfgr::I2sstd
+     * @param ckpol clock steady state polarity
+     */
+    template <typename PRESCALER>
+    void configure(const uint32_t mode, const uint32_t datalen=Spi::I2scfgr::Datalen::DATALEN_16, const uint32_t standard=Spi::I2scfgr::I2sstd::I2S_PHILLIPS, const bool ckpol=false) {
+        configure(mode, datalen, PRESCALER::channel_bits == 32, PRESCALER::i2spr, standard, ckpol);
+    }
+
+    /** Configure I2S with raw I2SPR value
+     * (I2S must be disabled, slave modes ignore prescaler)
+     * @param mode Spi::I2scfgr::I2scfg
+     * @param datalen Spi::I2scfgr::Datalen
+     * @param channel32 32 bit channel (required for 24 and 32 bit data)
+     * @param i2spr I2SPR value (I2SDIV, ODD, MCKOE)
+     * @param standard Spi::I2scfgr::I2sstd
+     * @param ckpol clock steady state polarity
+     */
+    void configure(const uint32_t mode, const uint32_t datalen, const bool channel32, const uint32_t i2spr, const uint32_t standard=Spi::I2scfgr::I2sstd::I2S_PHILLIPS, const bool ckpol=false) {
+        _transmit = mode == Spi::I2scfgr::I2scfg::MASTER_TX || mode == Spi::I2scfgr::I2scfg::SLAVE_TX;
+        _spi.I2SPR.r = i2spr;
+        _spi.I2SCFGR.write([mode, datalen, channel32, standard, ckpol](Spi::I2scfgr &i2scfgr) {
+            i2scfgr.b.CHLEN = channel32;
+            i2scfgr.b.DATLEN = datalen;
+            i2scfgr.b.CKPOL = ckpol;
+            i2scfgr.b.I2SSTD = standard;
+            i2scfgr.b.I2SCFG = mode;
+            i2scfgr.b.I2SMOD = 1;
+        });
+    }
+
+    /** Start stream
+     * (transmit: buffer should be filled before start)
+     * @param buffer buffer for both halves
+     * @param count number of halfwords in buffer (multiple of 4, max 65532)
+     * @param ready called for each completed half
+     * @param context user context for callback
+     * @return false if count is not multiple of 4
+     */
+    bool start(uint16_t *buffer, const size_t count, ready_t ready, void *context=nullptr) {
+        // each half hold whole left + right frames also with 32 bit samples
+        if (!count || (count & 3) || count > 0xffff) return false;
+        const bool transmit = _transmit;
+        _stream.start(&_spi.DR, buffer, count, transmit ? DmaStream<uint16_t>::Direction::TX : DmaStream<uint16_t>::Direction::RX, ready, context);
+        _spi.CR2.write([transmit](Spi::Cr2 &cr2) {
+            cr2.b.TXDMAEN = transmit;
+            cr2.b.RXDMAEN = !transmit;
+        });
+        _spi.I2SCFGR.modify([](Spi::I2scfgr &i2scfgr) { i2scfgr.b.I2SE = 1; });
+        return true;
+    }
+
+    /** Stop stream
+     * (disable sequence of reference manual: DMA is stopped first, transmit:
+     * I2S is disabled after last frame is sent, master receive: I2S is
+     * disabled after last frame is received)
+     */
+    void stop() {
+        // circular DMA would refill DR forever, TXE and BSY never settle
+        _stream.stop();
+        _spi.CR2.r = 0;
+        if (_transmit) {
+            while (!_spi.SR.read().b.TXE) {}
+            while (_spi.SR.read().b.BSY) {}
+        } else if (_spi.I2SCFGR.read().b.I2SCFG == Spi::I2scfgr::I2scfg::MASTER_RX) {
+            // disable at frame boundary, slave can be disabled any time
+            while (!_spi.SR.read().b.RXNE) {}
+            (void)_spi.DR.DR16;
+        }
+        _spi.I2SCFGR.modify([](Spi::I2scfgr &i2scfgr) { i2scfgr.b.I2SE = 0; });
+    }
+
+    /** Return half back to DMA
+     * @param data pointer received by ready callback
+     */
+    void release(const uint16_t *data) {
+        _stream.release(data);
+    }
+
+    /** Number of overruns (late release or lost half) since start
+     */
+    unsigned overruns() const {
+        return _stream.overruns();
+    }
+
+    /** DMA channel interrupt handler
+     * call from interrupt handler of DMA channel
+     */
+    void handle_dma_isr() {
+        _stream.handle_isr();
+    }
+
+    /** Channel event handler
+     * (can be used as DmaManager callback with this as context)
+     * @param context I2sStream instance
+     * @param flags TCIF, HTIF and TEIF of channel (already cleared)
+     */
+    static void dma_event(void *context, const unsigned flags) {
+        DmaStream<uint16_t>::dma_event(&static_cast<I2sStream *>(context)->_stream, flags);
+    }
+
+    /** Read 24 or 32 bit sample (two halfwords, high first)
+     * (24 bit sample is in bits 31:8)
+     * @param data first halfword of sample
+     */
+    static int32_t sample32(const uint16_t *data) {
+        return static_cast<int32_t>((static_cast<uint32_t>(data[0]) << 16) | data[1]);
+    }
+
+    /** Write 24 or 32 bit sample (two halfwords, high first)
+     * @param data first halfword of sample
+     * @param sample sample (24 bit sample in bits 31:8)
+     */
+    static void set_sample32(uint16_t *data, const int32_t sample) {
+        data[0] = static_cast<uint16_t>(static_cast<uint32_t>(sample) >> 16);
+        data[1] = static_cast<uint16_t>(sample);
+    }
+
+private:
+    Spi &_spi;
+    DmaStream<uint16_t> _stream;
+    bool _transmit = false;
+};
+
+}
@@ -0,0 +1,79 @@
+/**
+* Drain of deferred binary log over USART DMA
+*
+* Log ring (io/lib/log.hpp) is sent in place by UsartTx, next block is
+* queued from done callback, so after start() the log is drained from
+* interrupts only. poll() must be called when new records may be waiting
+* and drain is idle (for example from main loop).
+*
+* Example:
+*   io::UsartTx<> tx(io::USART1, io::DMA1, 2);
+*   io::LogUsart<> log_usart(log, tx);
+*
+*   while (true) {
+*       log_usart.poll();
+*       ...
+*   }
+*
+* MCUs containing this peripheral:
+*  - all MCUs with USART v2 and DMA v1 (F0, L0, L4, F3)
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "io/lib/log.hpp"
+#include "io/lib/stm32/_common/usart_tx.hpp"
+
+namespace io {
+
+template <unsigned QUEUE=8>
+class LogUsart {
+public:
+    /** LogUsart constructor
+     * @param log log ring
+     * @param tx USART transmit queue (can be shared with other messages)
+     */
+    LogUsart(Log &log, UsartTx<QUEUE> &tx) :
+        _log(log),
+        _tx(tx) {}
+
+    /** Start sending of waiting records if drain is idle
+     */
+    void poll() {
+        const uint32_t primask = Nvic::isr_save();
+        if (!_sending) send();
+        Nvic::isr_restore(primask);
+    }
+
+    /** Check if drain is idle
+     */
+    bool is_idle() const {
+        return !_sending;
+    }
+
+private:
+    Log &_log;
+    UsartTx<QUEUE> &_tx;
+    volatile size_t _sending = 0;
+
+    void send() {
+        const uint8_t *data;
+        const size_t size = _log.peek(data);
+        if (!size) return;
+        const size_t block = size < UsartTx<QUEUE>::MAX_SIZE ? size : UsartTx<QUEUE>::MAX_SIZE;
+        if (_tx.send(data, block, sent, this)) _sending = block;
+    }
+
+    static void sent(void *context, const bool) {
+        // block aborted by transfer error is dropped too, retry could loop in interrupt
+        LogUsart &drain = *static_cast<LogUsart *>(context);
+        drain._log.consume(drain._sending);
+        drain._sending = 0;
+        drain.send();
+    }
+};
+
+}
@@ -0,0 +1,354 @@
+/**
+* Compile-time pin descriptors
+*
+* Pin<PORT, N, ..> describe one pin with its configuration,
+* PinGroup<Pins..> fold configuration of all pins of one port into
+* precomputed masks, so whole port is configured by one read-modify-write
+* per register (at most six: AFRL, AFRH, OTYPER, OSPEEDR, PUPDR, MODER)
+* instead of one per pin and register.
+*
+* Example:
+*   using Led = io::PinOutput<io::base::GPIOA, 5>;
+*   using Tx = io::PinAf<io::base::GPIOA, 9, 1>;
+*   using Rx = io::PinAf<io::base::GPIOA, 10, 1, io::Gpio::Otyper::Otype::PUSH_PULL,
+*       io::Gpio::Ospeedr::Ospeed::LOW, io::Gpio::Pupdr::Pupd::PULL_UP>;
+*   using PortA = io::PinGroup<Led, Tx, Rx>;
+*   PortA::configure();
+*   Led::set();
+*
+* Pin can be in PinGroup only once (checked at compile time),
+* pins_unique<Pins..>() check pins of more drivers also across ports.
+*
+* MCUs containing this peripheral:
+*  - all MCUs with GPIO v2 (see io/reg/stm32/_common/gpio_v2.hpp)
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+#include "io/reg/stm32/_common/gpio_v2.hpp"
+
+namespace io {
+
+namespace pin {
+
+/** Bitwise OR of all arguments
+ */
+constexpr uint64_t bit_or() {
+    return 0;
+}
+
+template <typename... T>
+constexpr uint64_t bit_or(const uint64_t first, const T... rest) {
+    return first | bit_or(rest...);
+}
+
+/** Check if all arguments are equal to first one
+ */
+constexpr bool all_equal(const size_t) {
+    return true;
+}
+
+template <typename... T>
+constexpr bool all_equal(const size_t first, const size_t second, const T... rest) {
+    return first == second && all_equal(first, rest...);
+}
+
+/** Check if pin numbers are contiguous and in ascending order
+ */
+constexpr bool is_contiguous(const unsigned) {
+    return true;
+}
+
+template <typename... T>
+constexpr bool is_contiguous(const unsigned first, const unsigned second, const T... rest) {
+    return second == first + 1 && is_contiguous(second, rest...);
+}
+
+/** Lookup table for scattering 8 bits of value to pin positions
+ */
+struct ScatterTable {
+    uint16_t bits[256];
+};
+
+/** Make lookup table for 8 pins starting at offset
+ * @param offset index of first pin in group (bit of value)
+ * @param numbers pin numbers of all pins in group
+ */
+template <typename... T>
+constexpr ScatterTable scatter_table(const unsigned offset, const T... numbers) {
+    const unsigned pins[] = {numbers...};
+    ScatterTable table{};
+    for (unsigned value = 0; value < 256; value++) {
+        uint16_t bits = 0;
+        for (unsigned i = 0; i < 8 && offset + i < sizeof...(numbers); i++) {
+            if (value & (1u << i)) bits |= static_cast<uint16_t>(1u << pins[offset + i]);
+        }
+        table.bits[value] = bits;
+    }
+    return table;
+}
+
+/** Change bits in mask with single load and single store
+ */
+inline void modify(volatile uint32_t &reg, const uint32_t mask, const uint32_t value) {
+    reg = (reg & ~mask) | value;
+}
+
+}
+
+/** Pin descriptor
+ * @param PORT GPIO base address (io::base::GPIOA, ..)
+ * @param N pin number (0 - 15)
+ * @param MODE Gpio::Moder::Mode
+ * @param OTYPE Gpio::Otyper::Otype (output and AF mode)
+ * @param OSPEED Gpio::Ospeedr::Ospeed (output and AF mode)
+ * @param PUPD Gpio::Pupdr::Pupd
+ * @param AF alternate function (AF mode)
+ */
+template <
+    size_t PORT,
+    unsigned N,
+    uint32_t MODE=Gpio::Moder::Mode::INPUT,
+    uint32_t OTYPE=Gpio::Otyper::Otype::PUSH_PULL,
+    uint32_t OSPEED=Gpio::Ospeedr::Ospeed::LOW,
+    uint32_t PUPD=Gpio::Pupdr::Pupd::OFF,
+    unsigned AF=0>
+struct Pin {
+    static_assert(N < 16, "pin number must be 0 - 15");
+    static_assert(MODE < 4 && OTYPE < 2 && OSPEED < 4 && PUPD < 3 && AF < 16, "wrong pin configuration");
+
+    static constexpr size_t port = PORT;
+    static constexpr unsigned number = N;
+    static constexpr uint32_t mask = 1u << N;
+
+    // configuration masks and values
+    static constexpr bool is_output = MODE == Gpio::Moder::Mode::OUTPUT || MODE == Gpio::Moder::Mode::AF;
+    static constexpr uint32_t moder_mask = 3u << (N << 1);
+    static constexpr uint32_t moder_value = MODE << (N << 1);
+    static constexpr uint32_t otyper_mask = is_output ? mask : 0;
+    static constexpr uint32_t otyper_value = is_output ? OTYPE << N : 0;
+    static constexpr uint32_t ospeedr_mask = is_output ? moder_mask : 0;
+    static constexpr uint32_t ospeedr_value = is_output ? OSPEED << (N << 1) : 0;
+    static constexpr uint32_t pupdr_mask = moder_mask;
+    static constexpr uint32_t pupdr_value = PUPD << (N << 1);
+    static constexpr uint64_t afr_mask = MODE == Gpio::Moder::Mode::AF ? 0xfull << (N << 2) : 0;
+    static constexpr uint64_t afr_value = MODE == Gpio::Moder::Mode::AF ? static_cast<uint64_t>(AF) << (N << 2) : 0;
+
+    static inline Gpio &gpio() {
+        return GPIO(PORT);
+    }
+
+    /** Configure this pin
+     */
+    static inline void configure();
+
+    /** Set output to high
+     * (single store)
+     */
+    static inline void set() {
+        gpio().BSRR.r = mask;
+    }
+
+    /** Set output to low
+     * (single store)
+     */
+    static inline void clr() {
+        gpio().BSRR.r = mask << 16;
+    }
+
+    /** Set output
+     * (single store)
+     * @param val output level
+     */
+    static inline void write(const bool val) {
+        gpio().BSRR.r = val ? mask : mask << 16;
+    }
+
+    /** Read input
+     * @return input level
+     */
+    static inline bool get() {
+        return gpio().IDR.r & mask;
+    }
+};
+
+/** Input pin
+ */
+template <size_t PORT, unsigned N, uint32_t PUPD=Gpio::Pupdr::Pupd::OFF>
+using PinInput = Pin<PORT, N, Gpio::Moder::Mode::INPUT, Gpio::Otyper::Otype::PUSH_PULL, Gpio::Ospeedr::Ospeed::LOW, PUPD>;
+
+/** Output pin
+ */
+template <
+    size_t PORT,
+    unsigned N,
+    uint32_t OTYPE=Gpio::Otyper::Otype::PUSH_PULL,
+    uint32_t OSPEED=Gpio::Ospeedr::Ospeed::LOW,
+    uint32_t PUPD=Gpio::Pupdr::Pupd::OFF>
+using PinOutput = Pin<PORT, N, Gpio::Moder::Mode::OUTPUT, OTYPE, OSPEED, PUPD>;
+
+/** Alternate function pin
+ */
+template <
+    size_t PORT,
+    unsigned N,
+    unsigned AF,
+    uint32_t OTYPE=Gpio::Otyper::Otype::PUSH_PULL,
+    uint32_t OSPEED=Gpio::Ospeedr::Ospeed::LOW,
+    uint32_t PUPD=Gpio::Pupdr::Pupd::OFF>
+using PinAf = Pin<PORT, N, Gpio::Moder::Mode::AF, OTYPE, OSPEED, PUPD, AF>;
+
+/** Analog pin
+ */
+template <size_t PORT, unsigned N>
+using PinAnalog = Pin<PORT, N, Gpio::Moder::Mode::ANALOG>;
+
+/** Check if no pin is used more than once
+ * (also across more ports)
+ * @return true if all pins are unique
+ */
+template <typename... Pins>
+constexpr bool pins_unique() {
+    const size_t ports[] = {Pins::port...};
+    const unsigned numbers[] = {Pins::number...};
+    for (size_t i = 0; i < sizeof...(Pins); i++) {
+        for (size_t j = i + 1; j < sizeof...(Pins); j++) {
+            if (ports[i] == ports[j] && numbers[i] == numbers[j]) return false;
+        }
+    }
+    return true;
+}
+
+/** Group of pins on one port
+ * Bit i of group value is the i-th pin in Pins.
+ *
+ * write(value) set all pins by single BSRR store, value is scattered
+ * to pin positions by shift (contiguous pins in ascending order) or by
+ * lookup tables (other pins, 512 bytes for up to 8 pins, 1024 bytes
+ * for up to 16 pins, in flash).
+ */
+template <typename First, typename... Pins>
+struct PinGroup {
+    static_assert(pin::all_equal(First::port, Pins::port...), "all pins in group must be on same port");
+
+    static constexpr size_t port = First::port;
+    static constexpr size_t size = 1 + sizeof...(Pins);
+    static constexpr uint32_t mask = pin::bit_or(First::mask, Pins::mask...);
+
+    static_assert(static_cast<size_t>(__builtin_popcount(mask)) == size, "pin is used more than once");
+
+    static constexpr uint32_t moder_mask = pin::bit_or(First::moder_mask, Pins::moder_mask...);
+    static constexpr uint32_t moder_value = pin::bit_or(First::moder_value, Pins::moder_value...);
+    static constexpr uint32_t otyper_mask = pin::bit_or(First::otyper_mask, Pins::otyper_mask...);
+    static constexpr uint32_t otyper_value = pin::bit_or(First::otyper_value, Pins::otyper_value...);
+    static constexpr uint32_t ospeedr_mask = pin::bit_or(First::ospeedr_mask, Pins::ospeedr_mask...);
+    static constexpr uint32_t ospeedr_value = pin::bit_or(First::ospeedr_value, Pins::ospeedr_value...);
+    static constexpr uint32_t pupdr_mask = pin::bit_or(First::pupdr_mask, Pins::pupdr_mask...);
+    static constexpr uint32_t pupdr_value = pin::bit_or(First::pupdr_value, Pins::pupdr_value...);
+    static constexpr uint64_t afr_mask = pin::bit_or(First::afr_mask, Pins::afr_mask...);
+    static constexpr uint64_t afr_value = pin::bit_or(First::afr_value, Pins::afr_value...);
+
+    static constexpr bool contiguous = pin::is_contiguous(First::number, Pins::number...);
+    static constexpr pin::ScatterTable lut_lo = pin::scatter_table(0, First::number, Pins::number...);
+    static constexpr pin::ScatterTable lut_hi = pin::scatter_table(8, First::number, Pins::number...);
+
+    static inline Gpio &gpio() {
+        return GPIO(port);
+    }
+
+    // scatter methods, only the used one is instantiated (with its tables)
+    typedef std::integral_constant<int, 0> ScatterShift;
+    typedef std::integral_constant<int, 1> ScatterLut8;
+    typedef std::integral_constant<int, 2> ScatterLut16;
+    typedef std::integral_constant<int, contiguous ? 0 : size <= 8 ? 1 : 2> ScatterMethod;
+
+    static constexpr uint32_t scatter(const uint32_t value, ScatterShift) {
+        return (value << First::number) & mask;
+    }
+
+    static constexpr uint32_t scatter(const uint32_t value, ScatterLut8) {
+        return lut_lo.bits[value & 0xff];
+    }
+
+    static constexpr uint32_t scatter(const uint32_t value, ScatterLut16) {
+        return static_cast<uint32_t>(lut_lo.bits[value & 0xff] | lut_hi.bits[(value >> 8) & 0xff]);
+    }
+
+    /** Scatter value to pin positions
+     * @param value bit i is the i-th pin
+     * @return port bits
+     */
+    static constexpr uint32_t scatter(const uint32_t value) {
+        return scatter(value, ScatterMethod());
+    }
+
+    /** BSRR value which set pins to value
+     * (can be used also to precompute BSRR words)
+     * @param value bit i is the i-th pin
+     * @return BSRR value (set and reset halves)
+     */
+    static constexpr uint32_t bsrr(const uint32_t value) {
+        return scatter(value) | ((mask & ~scatter(value)) << 16);
+    }
+
+    /** Set outputs of all pins
+     * (single store)
+     * @param value bit i is the i-th pin
+     */
+    static inline void write(const uint32_t value) {
+        gpio().BSRR.r = bsrr(value);
+    }
+
+    /** Configure all pins
+     * One read-modify-write per used register, MODER is the last,
+     * so pins are switched into new mode already configured.
+     */
+    static inline void configure() {
+        Gpio &g = gpio();
+        if (afr_mask & 0xffffffff) {
+            pin::modify(g.AFR.r[0], static_cast<uint32_t>(afr_mask), static_cast<uint32_t>(afr_value));
+        }
+        if (afr_mask >> 32) {
+            pin::modify(g.AFR.r[1], static_cast<uint32_t>(afr_mask >> 32), static_cast<uint32_t>(afr_value >> 32));
+        }
+        if (otyper_mask) {
+            pin::modify(g.OTYPER.r, otyper_mask, otyper_value);
+        }
+        if (ospeedr_mask) {
+            pin::modify(g.OSPEEDR.r, ospeedr_mask, ospeedr_value);
+        }
+        pin::modify(g.PUPDR.r, pupdr_mask, pupdr_value);
+        pin::modify(g.MODER.r, moder_mask, moder_value);
+    }
+
+    /** Set all outputs to high
+     * (single store)
+     */
+    static inline void set() {
+        gpio().BSRR.r = mask;
+    }
+
+    /** Set all outputs to low
+     * (single store)
+     */
+    static inline void clr() {
+        gpio().BSRR.r = mask << 16;
+    }
+};
+
+template <typename First, typename... Pins>
+constexpr pin::ScatterTable PinGroup<First, Pins...>::lut_lo;
+
+template <typename First, typename... Pins>
+constexpr pin::ScatterTable PinGroup<First, Pins...>::lut_hi;
+
+template <size_t PORT, unsigned N, uint32_t MODE, uint32_t OTYPE, uint32_t OSPEED, uint32_t PUPD, unsigned AF>
+inline void Pin<PORT, N, MODE, OTYPE, OSPEED, PUPD, AF>::configure() {
+    PinGroup<Pin>::configure();
+}
+
+}
@@ -0,0 +1,302 @@
+/**
+* RS-485 multi-drop node
+*
+* Half-duplex USART with hardware driver enable and address mark mute
+* mode:
+*  - DE pin is driven by USART (DEM), asserted DEAT sample times before
+*    start bit and released DEDT sample times after stop bit, no GPIO
+*    toggling and no waiting for TC in software
+*  - 9 bit characters, character with bit 8 set is address (WAKE = 1),
+*    receiver is in mute mode (MME) until address matching ADD is
+*    received and returns to mute mode on any other address, so node is
+*    never interrupted by frames for other nodes
+*
+* Frame on the bus: [address | 0x100] [data ..]
+*
+* Received data are moved by DMA with PSIZE 16 and MSIZE 8 (bit 8 is
+* dropped), frame end is detected by IDLE or receiver timeout (RTOR).
+* Transmitted address is written into TDR by CPU, data are moved by DMA
+* (bit 8 is zero).
+*
+* Example:
+*   io::Rs485 bus(io::USART1, io::DMA1, 3, 2);
+*   io::UsartBaud<48000000, 1000000>::configure(io::USART1);
+*   bus.configure(0x12);
+*   bus.start(rx_buffer, sizeof(rx_buffer), received, nullptr);
+*   bus.send(0x01, reply, reply_size, sent, nullptr);
+*
+*   void USART1_handler() { bus.handle_isr(); }
+*   void DMA1_CH2_3_DMA2_CH1_2_handler() { bus.handle_dma_isr(); }
+*
+* MCUs containing this peripheral:
+*  - all MCUs with USART v2 and DMA v1 (F0, L0, L4, F3)
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "io/reg/stm32/_common/usart_v2.hpp"
+#include "io/reg/stm32/_common/dma_v1.hpp"
+
+namespace io {
+
+class Rs485 {
+public:
+    static const uint8_t ADDRESS_MASK = 0x7f;
+
+    /** Receive callback
+     * called from interrupt, buffer is reused after return
+     * @param context user context
+     * @param data frame data (without address)
+     * @param size number of bytes
+     */
+    typedef void (*receive_t)(void *context, const uint8_t *data, size_t size);
+
+    /** Done callback
+     * called from interrupt after last stop bit (and DE is released)
+     * @param context user context
+     */
+    typedef void (*done_t)(void *context);
+
+    /** Rs485 constructor
+     * @param usart USART
+     * @param dma DMA controller
+     * @param rx_channel DMA channel connected to USART RX request (1 - 7)
+     * @param tx_channel DMA channel connected to USART TX request (1 - 7)
+     */
+    Rs485(Usart &usart, Dma &dma, const unsigned rx_channel, const unsigned tx_channel) :
+        _usart(usart),
+        _dma(dma),
+        _rx_channel(rx_channel),
+        _tx_channel(tx_channel) {}
+
+    /** Configure and enable USART for RS-485
+     * baud rate must be already set, USART must be disabled (UE = 0)
+     * @param address node address (7 bits)
+     * @param de_assert DE assertion time in sample times (0 - 31)
+     * @param de_deassert DE de-assertion time in sample times (0 - 31)
+     * @param de_active_low DE polarity
+     */
+    void configure(const uint8_t address, const uint8_t de_assert=16, const uint8_t de_deassert=16, const bool de_active_low=false) {
+        _usart.CR2.modify([address](Usart::Cr2 &cr2) {
+            cr2.b.ADDM7 = 1;
+            cr2.b.ADD = address & ADDRESS_MASK;
+        });
+        _usart.CR3.modify([de_active_low](Usart::Cr3 &cr3) {
+            cr3.b.DEM = 1;
+            cr3.b.DEP = de_active_low;
+            cr3.b.EIE = 1;
+        });
+        // DEAT, DEDT (and CR2, CR3 above) are writable only while UE = 0,
+        // USART is enabled by separate store
+        _usart.CR1.modify([de_assert, de_deassert](Usart::Cr1 &cr1) {
+            cr1.b.M0 = 1;
+            cr1.b.M1 = 0;
+            cr1.b.PCE = 0;
+            cr1.b.WAKE = 1;
+            cr1.b.MME = 1;
+            cr1.b.DEAT = de_assert;
+            cr1.b.DEDT = de_deassert;
+            cr1.b.TE = 1;
+            cr1.b.UE = 0;
+        });
+        _usart.CR1.modify([](Usart::Cr1 &cr1) { cr1.b.UE = 1; });
+    }
+
+    /** Start receiving frames addressed to this node
+     * @param buffer buffer for one frame (address + data, max 65535)
+     * @param size size of buffer
+     * @param receive called for each received frame
+     * @param context user context for callback
+     * @param timeout receiver timeout in bit times (RTOR), 0 for IDLE
+     */
+    void start(uint8_t *buffer, const size_t size, receive_t receive, void *context=nullptr, const uint32_t timeout=0) {
+        _buffer = buffer;
+        _size = size;
+        _receive = receive;
+        _context = context;
+        if (timeout) {
+            _usart.RTOR.modify([timeout](Usart::Rtor &rtor) { rtor.b.RTO = timeout; });
+            _usart.CR2.modify([](Usart::Cr2 &cr2) { cr2.b.RTOEN = 1; });
+        }
+        _flags = error_flags() | end_flag(timeout != 0);
+        start_rx();
+        _usart.CR3.modify([](Usart::Cr3 &cr3) { cr3.b.DMAR = 1; });
+        _usart.CR1.modify([timeout](Usart::Cr1 &cr1) {
+            cr1.b.IDLEIE = !timeout;
+            cr1.b.RTOIE = timeout != 0;
+            cr1.b.RE = 1;
+        });
+        // wait in mute mode for own address
+        _usart.RQR.write([](Usart::Rqr &rqr) { rqr.b.MMRQ = 1; });
+    }
+
+    /** Send frame to address
+     * @param address destination address (7 bits)
+     * @param data frame data (max 65535), must be valid until done
+     * @param size number of bytes
+     * @param done called when frame was sent
+     * @param context user context for callback
+     * @return false if previous frame is still being sent
+     */
+    bool send(const uint8_t address, const uint8_t *data, const size_t size, done_t done=nullptr, void *context=nullptr) {
+        if (_sending) return false;
+        _sending = true;
+        _done = done;
+        _done_context = context;
+        _usart.ICR.write([](Usart::Icr &icr) { icr.b.TCCF = 1; });
+        _usart.CR3.modify([](Usart::Cr3 &cr3) { cr3.b.DMAT = 1; });
+        // address mark, TDR is empty when no transmission is running
+        _usart.TDR.r = ADDRESS_MARK | (address & ADDRESS_MASK);
+        if (!size) {
+            wait_tc();
+            return true;
+        }
+        Dma::Channel &ch = _dma.CHANNEL(_tx_channel);
+        ch.CCR.r = 0;
+        ch.CPAR.PAR(&_usart.TDR);
+        ch.CMAR.MAR(data);
+        ch.CNDTR.r = static_cast<uint32_t>(size);
+        ch.CCR.write([](Dma::Channel::Ccr &ccr) {
+            ccr.b.DIR = 1;
+            ccr.b.MINC = 1;
+            ccr.PSIZE(Dma::Channel::Ccr::Size::SIZE_16);
+            ccr.MSIZE(Dma::Channel::Ccr::Size::SIZE_8);
+            ccr.PL(Dma::Channel::Ccr::Pl::HIGH);
+            ccr.b.TCIE = 1;
+            ccr.b.TEIE = 1;
+            ccr.b.EN = 1;
+        });
+        return true;
+    }
+
+    /** Check if frame is being sent
+     */
+    bool is_sending() const {
+        return _sending;
+    }
+
+    /** Number of receive errors (overrun, framing, noise, frame too long)
+     */
+    unsigned errors() const {
+        return _errors;
+    }
+
+    /** USART interrupt handler
+     * call from USART interrupt handler
+     */
+    void handle_isr() {
+        // single read of flags, flags without enabled interrupt are ignored
+        const Usart::Isr isr = _usart.ISR.read();
+        const uint32_t flags = isr.r & _flags;
+        if (flags) {
+            _usart.ICR.r = flags;
+            if (flags & error_flags()) _errors = _errors + 1;
+            if (flags & ~error_flags()) frame_end();
+        }
+        if (isr.b.TC && _usart.CR1.read().b.TCIE) {
+            _usart.CR1.modify([](Usart::Cr1 &cr1) { cr1.b.TCIE = 0; });
+            _usart.ICR.write([](Usart::Icr &icr) { icr.b.TCCF = 1; });
+            _sending = false;
+            if (_done) _done(_done_context);
+        }
+    }
+
+    /** DMA TX channel interrupt handler
+     * call from interrupt handler of DMA channel
+     */
+    void handle_dma_isr() {
+        const unsigned shift = (_tx_channel - 1) << 2;
+        const unsigned flags = (_dma.ISR.r >> shift) & (Dma::Ifcr::TCIF | Dma::Ifcr::TEIF);
+        if (!flags) return;
+        // only read flags, TCIF raised after the read stays pending (GIF would clear it)
+        _dma.IFCR.clear_flags(_tx_channel, flags);
+        dma_event(this, flags);
+    }
+
+    /** TX channel event handler
+     * (can be used as DmaManager callback with this as context)
+     * @param context Rs485 instance
+     * @param flags TCIF and TEIF of channel (already cleared)
+     */
+    static void dma_event(void *context, const unsigned flags) {
+        Rs485 &bus = *static_cast<Rs485 *>(context);
+        if (!(flags & (Dma::Ifcr::TCIF | Dma::Ifcr::TEIF))) return;
+        bus._dma.CHANNEL(bus._tx_channel).CCR.r = 0;
+        // last character is in shift register, done after stop bit
+        bus.wait_tc();
+    }
+
+private:
+    static const uint32_t ADDRESS_MARK = 0x100;  // bit 8 of character
+
+    Usart &_usart;
+    Dma &_dma;
+    const unsigned _rx_channel;
+    const unsigned _tx_channel;
+    uint8_t *_buffer = nullptr;
+    size_t _size = 0;
+    receive_t _receive = nullptr;
+    void *_context = nullptr;
+    done_t _done = nullptr;
+    void *_done_context = nullptr;
+    uint32_t _flags = 0;  // Isr flags with enabled interrupt
+    volatile bool _sending = false;
+    volatile unsigned _errors = 0;
+
+    /** Receive errors enabled by EIE: FE, NF, ORE
+     * (Isr flags, the same bits clear them in Icr)
+     */
+    static uint32_t error_flags() {
+        Usart::Icr icr;
+        icr.b.FECF = 1;
+        icr.b.NCF = 1;
+        icr.b.ORECF = 1;
+        return icr.r;
+    }
+
+    /** Frame end: IDLE or RTOF
+     * (Isr flag, the same bit clears it in Icr)
+     */
+    static uint32_t end_flag(const bool timeout) {
+        Usart::Icr icr;
+        icr.b.IDLECF = !timeout;
+        icr.b.RTOCF = timeout;
+        return icr.r;
+    }
+
+    void start_rx() {
+        Dma::Channel &ch = _dma.CHANNEL(_rx_channel);
+        ch.CCR.r = 0;
+        ch.CPAR.PAR(&_usart.RDR);
+        ch.CMAR.MAR(_buffer);
+        ch.CNDTR.r = static_cast<uint32_t>(_size);
+        ch.CCR.write([](Dma::Channel::Ccr &ccr) {
+            ccr.b.MINC = 1;
+            ccr.PSIZE(Dma::Channel::Ccr::Size::SIZE_16);
+            ccr.MSIZE(Dma::Channel::Ccr::Size::SIZE_8);
+            ccr.PL(Dma::Channel::Ccr::Pl::VERY_HIGH);
+            ccr.b.EN = 1;
+        });
+    }
+
+    void frame_end() {
+        const size_t received = _size - _dma.CHANNEL(_rx_channel).CNDTR.r;
+        if (received >= _size) {
+            // frame did not fit into buffer
+            _errors = _errors + 1;
+        } else if (received && _receive) {
+            // first byte is own address
+            _receive(_context, _buffer + 1, received - 1);
+        }
+        start_rx();
+    }
+
+    void wait_tc() {
+        _usart.CR1.modify([](Usart::Cr1 &cr1) { cr1.b.TCIE = 1; });
+    }
+};
+
+}
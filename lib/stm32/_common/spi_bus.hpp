@@ -0,0 +1,175 @@
+/**
+* Queued SPI bus
+*
+* One SPI shared by more device drivers (flash, display, sensor, ..).
+* Transactions are queued and executed back to back from DMA interrupt,
+* drivers never wait for the bus. Each device has own chip select (GPIO,
+* active low), frame size, clock polarity/phase and baud rate, SPI is
+* reconfigured only when device changes (SPI is disabled between
+* transfers, see SpiDma).
+*
+* Transaction can be chain of segments (next), chip select is asserted
+* for whole chain, e.g. command followed by data:
+*   [CS low] [segment 1] [segment 2] .. [CS high]
+*
+* Transactions and devices are owned by caller and must stay valid until
+* done callback of last segment is called.
+*
+* Example:
+*   io::SpiDma spi(io::SPI1, io::DMA1, 2, 3);
+*   io::SpiBus<> bus(spi);
+*   const io::SpiBus<>::Device flash = {&io::GPIO(io::base::GPIOA), 1 << 4, 8, io::Spi::Cr1::Br::DIV_2};
+*   io::SpiBus<>::Transaction data = {&flash, nullptr, buffer, 256, done, nullptr, nullptr};
+*   io::SpiBus<>::Transaction command = {&flash, cmd, nullptr, 4, nullptr, nullptr, &data};
+*   bus.submit(command);
+*
+*   void DMA1_CH2_3_DMA2_CH1_2_handler() { spi.handle_dma_isr(); }
+*
+* MCUs containing this peripheral:
+*  - all MCUs with SPI v2 and DMA v1 (F0, F3, L4)
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "io/reg/cortexm/nvic.hpp"
+#include "io/reg/stm32/_common/gpio_v2.hpp"
+#include "io/lib/stm32/_common/spi_dma.hpp"
+
+namespace io {
+
+template <unsigned QUEUE=8>
+class SpiBus {
+    static_assert(QUEUE >= 2 && (QUEUE & (QUEUE - 1)) == 0, "QUEUE must be power of two");
+
+public:
+    /** Done callback
+     * called from interrupt when segment is complete
+     * @param context user context
+     * @param ok false on transfer error (rest of chain is skipped)
+     */
+    typedef SpiDma::done_t done_t;
+
+    /** Device on bus
+     */
+    struct Device {
+        Gpio *cs;  // chip select port (nullptr for no chip select)
+        uint32_t cs_mask;  // chip select pin mask
+        unsigned bits;  // frame size (4 - 16)
+        uint32_t br;  // baud rate prescaler (Spi::Cr1::Br)
+        bool cpol;  // clock polarity
+        bool cpha;  // clock phase
+        bool lsb_first;  // LSB first
+        uint16_t crc_polynomial;  // CRC polynomial for crc transactions (0: crc transactions are rejected)
+        bool crc16;  // 16 bit CRC
+    };
+
+    /** Transaction segment
+     */
+    struct Transaction {
+        const Device *device;  // device (chip select and configuration of first segment is used for chain)
+        const void *tx;  // data to send or nullptr (0xff is sent)
+        void *rx;  // buffer for received data or nullptr
+        size_t count;  // number of frames (1 - 65535)
+        done_t done;  // called when segment is complete or nullptr
+        void *context;  // user context for callback
+        Transaction *next;  // next segment with chip select still asserted
+        bool crc;  // hardware CRC after data (see SpiDma)
+    };
+
+    /** SpiBus constructor
+     * @param spi SPI DMA engine (its DMA interrupt must be handled by application)
+     */
+    SpiBus(SpiDma &spi) :
+        _spi(spi) {}
+
+    /** Queue transaction
+     * (can be called also from done callback)
+     * @param transaction first segment of transaction
+     * @return false if queue is full or chain contains crc segment and
+     *   device has no crc_polynomial (CRC unit would keep polynomial of
+     *   previous device)
+     */
+    bool submit(Transaction &transaction) {
+        for (const Transaction *t = &transaction; t; t = t->next) {
+            if (t->crc && !transaction.device->crc_polynomial) return false;
+        }
+        const uint32_t primask = Nvic::isr_save();
+        const bool ok = _head - _tail < QUEUE;
+        if (ok) {
+            _queue[_head & (QUEUE - 1)] = &transaction;
+            _head = _head + 1;
+            if (!_current) start();
+        }
+        Nvic::isr_restore(primask);
+        return ok;
+    }
+
+    /** Check if all queued transactions are complete
+     */
+    bool is_idle() const {
+        return _head == _tail && !_current;
+    }
+
+    /** Wait until all queued transactions are complete
+     */
+    void flush() const {
+        while (!is_idle()) {}
+    }
+
+private:
+    SpiDma &_spi;
+    Transaction *_queue[QUEUE] = {};
+    volatile unsigned _head = 0;
+    volatile unsigned _tail = 0;
+    Transaction *volatile _current = nullptr;
+    const Device *_configured = nullptr;
+    const Device *_selected = nullptr;
+
+    /** Start transaction at tail
+     */
+    void start() {
+        Transaction &transaction = *_queue[_tail & (QUEUE - 1)];
+        _tail = _tail + 1;
+        const Device &device = *transaction.device;
+        if (&device != _configured) {
+            _configured = &device;
+            _spi.configure(device.bits, device.br, device.cpol, device.cpha, device.lsb_first);
+            if (device.crc_polynomial) _spi.configure_crc(device.crc_polynomial, device.crc16);
+        }
+        _selected = &device;
+        if (device.cs) device.cs->BSRR.r = device.cs_mask << 16;
+        segment(transaction);
+    }
+
+    void segment(Transaction &transaction) {
+        _current = &transaction;
+        if (!_spi.transfer(transaction.tx, transaction.rx, transaction.count, transfer_done, this, transaction.crc)) {
+            complete(false);
+        }
+    }
+
+    /** Segment is complete, continue with chain or next transaction
+     */
+    void complete(const bool ok) {
+        Transaction &transaction = *_current;
+        Transaction *next = ok ? transaction.next : nullptr;
+        if (next) {
+            segment(*next);
+        } else {
+            const Device &device = *_selected;
+            if (device.cs) device.cs->BSRR.r = device.cs_mask;
+            _current = nullptr;
+            if (_head != _tail) start();
+        }
+        if (transaction.done) transaction.done(transaction.context, ok);
+    }
+
+    static void transfer_done(void *context, const bool ok) {
+        static_cast<SpiBus *>(context)->complete(ok);
+    }
+};
+
+}
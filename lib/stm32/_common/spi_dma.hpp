@@ -0,0 +1,276 @@
+/**
+* SPI full-duplex DMA transfer
+*
+* SPI master (spi_v2) with paired DMA channels, RX channel drain the
+* RX FIFO and TX channel fill the TX FIFO, so SPI clock is running
+* without gaps also at high baud rates. Done callback is called from
+* RX channel transfer complete interrupt (all frames are received).
+*
+* Frames 4 - 16 bits (Cr2 DS):
+*  - 9 - 16 bits: one frame per 16 bit DMA access (FRXTH = 0)
+*  - 4 - 8 bits with halfword aligned buffers: data packing, two frames
+*    per 16 bit DMA access (FRXTH = 0), odd count without RX buffer is
+*    handled by LDMA_TX / LDMA_RX
+*  - 4 - 8 bits with unaligned buffers or odd count with RX buffer (last
+*    16 bit access would write one byte beyond buffer): one frame per
+*    8 bit DMA access (FRXTH = 1)
+*
+* TX buffer can be nullptr (0xff is sent), RX buffer can be nullptr
+* (received data are dropped).
+*
+* Hardware CRC (CRCEN, CRCPR, CRCL): with crc transfer CRC is computed
+* during DMA transfer, sent after last TX frame and received CRC is
+* checked by SPI (CRCERR), CPU never pass over data. CRC is reset at
+* start of each transfer (initial value 0), DMA counts only data frames,
+* received CRC frames are flushed from RX FIFO at the end. CRC is
+* checked only when RX buffer is used.
+*
+* Done callback is called from RX channel interrupt after SPI is not
+* busy (BSY). Without CRC last frame is already received and the wait
+* is short, with CRC the interrupt waits until CRC frames are sent
+* (8 or 16 SPI clocks, e.g. 85 us at 187.5 kHz), so with slow SPI clock
+* DMA interrupt should have low priority.
+* SD card data block (CRC16-CCITT, polynomial 0x1021, 8 bit frames):
+*   spi.configure_crc(0x1021, true);
+*   spi.transfer(nullptr, block, 512, done, nullptr, true);
+*
+* Example:
+*   io::SpiDma spi(io::SPI1, io::DMA1, 2, 3);
+*   spi.configure(8, io::Spi::Cr1::Br::DIV_2);
+*   spi.transfer(tx, rx, 64, done, nullptr);
+*
+*   void DMA1_CH2_3_DMA2_CH1_2_handler() { spi.handle_dma_isr(); }
+*
+* MCUs containing this peripheral:
+*  - all MCUs with SPI v2 and DMA v1 (F0, F3, L4)
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "io/reg/stm32/_common/spi_v2.hpp"
+#include "io/reg/stm32/_common/dma_v1.hpp"
+
+namespace io {
+
+class SpiDma {
+public:
+    static const unsigned MAX_COUNT = 0xffff;
+
+    /** Done callback
+     * called from interrupt when transfer is complete
+     * @param context user context
+     * @param ok false on DMA transfer error or on received CRC mismatch
+     */
+    typedef void (*done_t)(void *context, bool ok);
+
+    /** SpiDma constructor
+     * @param spi SPI
+     * @param dma DMA controller
+     * @param rx_channel DMA channel connected to SPI RX request (1 - 7)
+     * @param tx_channel DMA channel connected to SPI TX request (1 - 7)
+     */
+    SpiDma(Spi &spi, Dma &dma, const unsigned rx_channel, const unsigned tx_channel) :
+        _spi(spi),
+        _dma(dma),
+        _rx_channel(rx_channel),
+        _tx_channel(tx_channel) {}
+
+    /** Configure SPI master
+     * (SPI is disabled between transfers, NSS is managed by software)
+     * @param bits frame size (4 - 16)
+     * @param br baud rate prescaler (Spi::Cr1::Br)
+     * @param cpol clock polarity
+     * @param cpha clock phase
+     * @param lsb_first LSB first
+     */
+    void configure(const unsigned bits, const uint32_t br, const bool cpol=false, const bool cpha=false, const bool lsb_first=false) {
+        _bits = bits;
+        _spi.CR1.write([br, cpol, cpha, lsb_first](Spi::Cr1 &cr1) {
+            cr1.b.CPHA = cpha;
+            cr1.b.CPOL = cpol;
+            cr1.b.MSTR = 1;
+            cr1.b.BR = br;
+            cr1.b.LSBFIRST = lsb_first;
+            cr1.b.SSI = 1;
+            cr1.b.SSM = 1;
+        });
+    }
+
+    /** Configure hardware CRC
+     * (used by transfers with crc, SPI must be idle)
+     * @param polynomial CRC polynomial (CRCPR, reset value is 7)
+     * @param crc16 16 bit CRC (CRCL), otherwise 8 bit CRC (frames up to 8 bits)
+     */
+    void configure_crc(const uint16_t polynomial, const bool crc16=true) {
+        _spi.CRCPR.r = polynomial;
+        _crc16 = crc16;
+    }
+
+    /** Start transfer
+     * @param tx data to send or nullptr
+     * @param rx buffer for received data or nullptr
+     * @param count number of frames (max 65535, without CRC)
+     * @param done called when transfer is complete
+     * @param context user context for callback
+     * @param crc send CRC after data and check received CRC
+     * @return false if previous transfer is still running
+     */
+    bool transfer(const void *tx, void *rx, const size_t count, done_t done=nullptr, void *context=nullptr, const bool crc=false) {
+        if (_busy || !count || count > MAX_COUNT) return false;
+        _busy = true;
+        _done = done;
+        _context = context;
+        _crc = crc;
+        _crc_check = crc && rx;
+        if (crc) {
+            // CRC registers are reset by enabling CRC (SPI is disabled)
+            const bool crc16 = _crc16;
+            _spi.CR1.modify([crc16](Spi::Cr1 &cr1) {
+                cr1.b.CRCEN = 0;
+                cr1.b.CRCL = crc16;
+            });
+            _spi.CR1.modify([](Spi::Cr1 &cr1) { cr1.b.CRCEN = 1; });
+        }
+        const bool wide = _bits > 8;
+        // pack two 8 bit frames into each 16 bit access if buffers allow it,
+        // last RX access of odd count would write one byte beyond buffer
+        const bool packed = !wide && count > 1 && aligned(tx) && aligned(rx) && !(rx && (count & 1));
+        const bool odd = packed && (count & 1);
+        const size_t accesses = packed ? (count + 1) >> 1 : count;
+        const Dma::Channel::Ccr::Size size = (wide || packed) ? Dma::Channel::Ccr::Size::SIZE_16 : Dma::Channel::Ccr::Size::SIZE_8;
+        const uint32_t ds = _bits - 1;
+        _spi.CR2.write([ds, wide, packed, odd](Spi::Cr2 &cr2) {
+            cr2.b.DS = ds;
+            cr2.b.FRXTH = !wide && !packed;
+            cr2.b.LDMA_TX = odd;
+            cr2.b.LDMA_RX = odd;
+            cr2.b.RXDMAEN = 1;
+        });
+        _dummy_tx = 0xffff;
+        start_channel(_rx_channel, rx ? rx : &_dummy_rx, accesses, size, false, rx != nullptr);
+        start_channel(_tx_channel, tx ? tx : &_dummy_tx, accesses, size, true, tx != nullptr);
+        _spi.CR2.modify([](Spi::Cr2 &cr2) { cr2.b.TXDMAEN = 1; });
+        _spi.CR1.modify([](Spi::Cr1 &cr1) { cr1.b.SPE = 1; });
+        return true;
+    }
+
+    /** Check if transfer is running
+     */
+    bool is_busy() const {
+        return _busy;
+    }
+
+    /** Wait until transfer is complete
+     */
+    void wait() const {
+        while (_busy) {}
+    }
+
+    /** Computed CRC of received data of last crc transfer
+     */
+    uint16_t rx_crc() const {
+        return _spi.RXCRCR.r;
+    }
+
+    /** Computed CRC of sent data of last crc transfer
+     */
+    uint16_t tx_crc() const {
+        return _spi.TXCRCR.r;
+    }
+
+    /** DMA RX channel interrupt handler
+     * call from interrupt handler of DMA channel
+     */
+    void handle_dma_isr() {
+        const unsigned shift = (_rx_channel - 1) << 2;
+        const unsigned flags = (_dma.ISR.r >> shift) & (Dma::Ifcr::TCIF | Dma::Ifcr::TEIF);
+        if (!flags) return;
+        // only read flags, TCIF raised after the read stays pending (GIF would clear it)
+        _dma.IFCR.clear_flags(_rx_channel, flags);
+        dma_event(this, flags);
+    }
+
+    /** RX channel event handler
+     * (can be used as DmaManager callback with this as context)
+     * @param context SpiDma instance
+     * @param flags TCIF and TEIF of channel (already cleared)
+     */
+    static void dma_event(void *context, const unsigned flags) {
+        SpiDma &spi = *static_cast<SpiDma *>(context);
+        if (flags & (Dma::Ifcr::TCIF | Dma::Ifcr::TEIF)) spi.complete(!(flags & Dma::Ifcr::TEIF));
+    }
+
+    /** Access SPI registers
+     */
+    Spi &spi() {
+        return _spi;
+    }
+
+private:
+    Spi &_spi;
+    Dma &_dma;
+    const unsigned _rx_channel;
+    const unsigned _tx_channel;
+    unsigned _bits = 8;
+    done_t _done = nullptr;
+    void *_context = nullptr;
+    volatile bool _busy = false;
+    bool _crc16 = true;
+    bool _crc = false;
+    bool _crc_check = false;
+    uint16_t _dummy_tx = 0xffff;
+    uint16_t _dummy_rx = 0;
+
+    static bool aligned(const void *p) {
+        return !(reinterpret_cast<uintptr_t>(p) & 1);
+    }
+
+    void start_channel(const unsigned channel, const void *memory, const size_t count, const Dma::Channel::Ccr::Size size, const bool tx, const bool minc) {
+        Dma::Channel &ch = _dma.CHANNEL(channel);
+        ch.CCR.r = 0;
+        _dma.IFCR.clear_flags(channel);
+        ch.CPAR.PAR(&_spi.DR);
+        ch.CMAR.MAR(memory);
+        ch.CNDTR.r = static_cast<uint32_t>(count);
+        ch.CCR.write([size, tx, minc](Dma::Channel::Ccr &ccr) {
+            ccr.b.DIR = tx;
+            ccr.b.MINC = minc;
+            ccr.PSIZE(size);
+            ccr.MSIZE(size);
+            // RX before TX, so RX FIFO never overflow
+            ccr.PL(tx ? Dma::Channel::Ccr::Pl::HIGH : Dma::Channel::Ccr::Pl::VERY_HIGH);
+            ccr.b.TCIE = !tx;
+            ccr.b.TEIE = !tx;
+            ccr.b.EN = 1;
+        });
+    }
+
+    void complete(bool ok) {
+        // closing sequence: all frames are received, wait until SPI is not busy
+        // (with CRC also until CRC frames are sent and received, busy wait in interrupt)
+        while (_spi.SR.read().b.BSY) {}
+        _dma.CHANNEL(_tx_channel).CCR.r = 0;
+        _dma.CHANNEL(_rx_channel).CCR.r = 0;
+        if (_crc) {
+            // received CRC stays in RX FIFO
+            while (_spi.SR.read().b.FRLVL != Spi::Sr::Flvl::EMPTY) (void)_spi.DR.DR8;
+            if (_crc_check && _spi.SR.read().b.CRCERR) ok = false;
+            _spi.SR.r = 0;  // clear CRCERR
+        }
+        _spi.CR1.modify([](Spi::Cr1 &cr1) {
+            cr1.b.SPE = 0;
+            cr1.b.CRCEN = 0;
+        });
+        _spi.CR2.modify([](Spi::Cr2 &cr2) {
+            cr2.b.TXDMAEN = 0;
+            cr2.b.RXDMAEN = 0;
+        });
+        _busy = false;
+        if (_done) _done(_context, ok);
+    }
+};
+
+}
@@ -0,0 +1,182 @@
+/**
+* USART baud rate
+*
+* Compile time solver of BRR and oversampling (OVER8) for USART v2 and
+* runtime auto baud rate detection (ABREN, ABRMOD).
+*
+* Oversampling by 16 is preferred (better tolerance to clock deviation
+* and noise), oversampling by 8 is used when oversampling by 16 is not
+* possible (baud rate above clock / 16) or is out of tolerance and
+* oversampling by 8 gives smaller error.
+* Compilation fails when error is above tolerance.
+*
+* Example:
+*   typedef io::UsartBaud<48000000, 6000000> Baud;  // OVER8, BRR = 0x10
+*   Baud::configure(io::USART1);  // before UE is set
+*
+*   io::usart_auto_baud(io::USART1, io::UsartAbrMode::FRAME_0X55);
+*   ...
+*   if (io::usart_auto_baud_done(io::USART1)) baud = io::usart_baud(io::USART1, 48000000);
+*
+* MCUs containing this peripheral:
+*  - all MCUs with USART v2 (F0, L0, L4, F3, F7)
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "io/reg/stm32/_common/usart_v2.hpp"
+
+namespace io {
+
+namespace usart_baud_solver {
+
+/** Divider (USARTDIV) rounded to nearest
+ * @param clock USART kernel clock
+ * @param baud baud rate
+ * @param over8 oversampling by 8
+ */
+constexpr uint32_t divider(const uint32_t clock, const uint32_t baud, const bool over8) {
+    return static_cast<uint32_t>(((static_cast<uint64_t>(clock) << (over8 ? 1 : 0)) + baud / 2) / baud);
+}
+
+/** BRR value from divider
+ * (with OVER8 bits [3:0] of divider are shifted right by one)
+ */
+constexpr uint32_t brr(const uint32_t div, const bool over8) {
+    return over8 ? ((div & ~static_cast<uint32_t>(0x0f)) | ((div & 0x0f) >> 1)) : div;
+}
+
+/** Real baud rate
+ */
+constexpr uint32_t actual(const uint32_t clock, const uint32_t div, const bool over8) {
+    return div ? static_cast<uint32_t>(((static_cast<uint64_t>(clock) << (over8 ? 1 : 0)) + div / 2) / div) : 0;
+}
+
+/** Error in ppm (absolute value)
+ */
+constexpr uint32_t error_ppm(const uint32_t baud, const uint32_t real) {
+    return static_cast<uint32_t>(((real > baud ? real - baud : baud - real) * static_cast<uint64_t>(1000000) + baud / 2) / baud);
+}
+
+/** Divider is valid: 16 .. 0xffff
+ * (with OVER8 BRR[3] must stay zero, which is guaranteed by brr())
+ */
+constexpr bool valid(const uint32_t div) {
+    return div >= 16 && div <= 0xffff;
+}
+
+constexpr uint32_t error_of(const uint32_t clock, const uint32_t baud, const bool over8) {
+    return valid(divider(clock, baud, over8))
+        ? error_ppm(baud, actual(clock, divider(clock, baud, over8), over8))
+        : ~static_cast<uint32_t>(0);
+}
+
+/** Select oversampling by 8
+ * only when oversampling by 16 is not possible, or out of tolerance and worse
+ */
+constexpr bool select_over8(const uint32_t clock, const uint32_t baud, const uint32_t tolerance) {
+    return error_of(clock, baud, false) > tolerance && error_of(clock, baud, true) < error_of(clock, baud, false);
+}
+
+}
+
+/** Compile time USART baud rate
+ * @param CLOCK USART kernel clock in Hz
+ * @param BAUD baud rate
+ * @param TOLERANCE maximal error in ppm (default 2 %)
+ */
+template <uint32_t CLOCK, uint32_t BAUD, uint32_t TOLERANCE=20000>
+struct UsartBaud {
+    static_assert(BAUD > 0, "baud rate must be nonzero");
+
+    static constexpr bool over8 = usart_baud_solver::select_over8(CLOCK, BAUD, TOLERANCE);
+    static constexpr uint32_t divider = usart_baud_solver::divider(CLOCK, BAUD, over8);
+    static constexpr uint32_t brr = usart_baud_solver::brr(divider, over8);
+    static constexpr uint32_t actual = usart_baud_solver::actual(CLOCK, divider, over8);
+    static constexpr uint32_t error_ppm = usart_baud_solver::error_ppm(BAUD, actual);
+
+    static_assert(usart_baud_solver::valid(divider), "baud rate is out of range for this clock");
+    static_assert(error_ppm <= TOLERANCE, "baud rate error is above tolerance");
+
+    /** Set BRR and OVER8
+     * (USART must be disabled, UE = 0)
+     * @param usart USART
+     */
+    static void configure(Usart &usart) {
+        usart.CR1.modify([](Usart::Cr1 &cr1) { cr1.b.OVER8 = over8; });
+        usart.BRR.r = brr;
+    }
+};
+
+template <uint32_t CLOCK, uint32_t BAUD, uint32_t TOLERANCE>
+constexpr bool UsartBaud<CLOCK, BAUD, TOLERANCE>::over8;
+template <uint32_t CLOCK, uint32_t BAUD, uint32_t TOLERANCE>
+constexpr uint32_t UsartBaud<CLOCK, BAUD, TOLERANCE>::divider;
+template <uint32_t CLOCK, uint32_t BAUD, uint32_t TOLERANCE>
+constexpr uint32_t UsartBaud<CLOCK, BAUD, TOLERANCE>::brr;
+template <uint32_t CLOCK, uint32_t BAUD, uint32_t TOLERANCE>
+constexpr uint32_t UsartBaud<CLOCK, BAUD, TOLERANCE>::actual;
+template <uint32_t CLOCK, uint32_t BAUD, uint32_t TOLERANCE>
+constexpr uint32_t UsartBaud<CLOCK, BAUD, TOLERANCE>::error_ppm;
+
+/** Auto baud rate mode (Cr2 ABRMOD)
+ */
+enum class UsartAbrMode : uint32_t {
+    START_BIT = 0,  // measure start bit (character starting with 1)
+    FALLING_EDGE = 1,  // falling edge to falling edge (character starting with 10xx)
+    FRAME_0X7F = 2,  // 0x7f frame
+    FRAME_0X55 = 3,  // 0x55 frame
+};
+
+/** Start auto baud rate detection
+ * (USART must be disabled, UE = 0, detection runs on first received character
+ * after UE is set, repeated by usart_auto_baud_request())
+ * @param usart USART
+ * @param mode detection mode
+ */
+inline void usart_auto_baud(Usart &usart, const UsartAbrMode mode) {
+    usart.CR2.modify([mode](Usart::Cr2 &cr2) {
+        cr2.b.ABREN = 1;
+        cr2.b.ABRMOD = static_cast<uint32_t>(mode);
+    });
+}
+
+/** Request new auto baud rate detection on next character
+ * @param usart USART
+ */
+inline void usart_auto_baud_request(Usart &usart) {
+    usart.RQR.write([](Usart::Rqr &rqr) { rqr.b.ABRRQ = 1; });
+}
+
+/** Check if auto baud rate detection finished successfully
+ * (single read of ISR: ABRF set and ABRE clear)
+ * @param usart USART
+ */
+inline bool usart_auto_baud_done(Usart &usart) {
+    const Usart::Isr isr = usart.ISR.read();
+    return isr.b.ABRF && !isr.b.ABRE;
+}
+
+/** Check if auto baud rate detection failed
+ * @param usart USART
+ */
+inline bool usart_auto_baud_error(Usart &usart) {
+    return usart.ISR.read().b.ABRE;
+}
+
+/** Current baud rate from BRR and OVER8
+ * (after auto baud rate detection BRR contains detected value)
+ * @param usart USART
+ * @param clock USART kernel clock in Hz
+ */
+inline uint32_t usart_baud(Usart &usart, const uint32_t clock) {
+    const bool over8 = usart.CR1.read().b.OVER8;
+    const uint32_t brr = usart.BRR.r & 0xffff;
+    const uint32_t div = over8 ? ((brr & ~static_cast<uint32_t>(0x0f)) | ((brr & 0x07) << 1)) : brr;
+    return usart_baud_solver::actual(clock, div, over8);
+}
+
+}
@@ -0,0 +1,287 @@
+/**
+* USART receiver with circular DMA
+*
+* USART receive continuously by DMA into circular buffer (ring), no
+* interrupt per byte. Received data are delivered as spans directly
+* into the ring (no copy):
+*  - on IDLE (line idle for one frame after data) or RTOF (receiver
+*    timeout after RTOR bit times) with end of frame flag
+*  - or on CMF (character match) when delimiter (ADD) is received, in
+*    delimited mode (start_delimited()), packet ends with delimiter
+*  - on DMA half transfer and transfer complete without end of frame
+*    flag (long frames, so data are delivered before DMA wraps)
+*
+* Span is valid until DMA wraps around whole ring, so callback should
+* process or consume it before next half of ring is received.
+* Frame which wraps in the ring is delivered as two spans.
+*
+* Receiver timeout (RTOR) is not available on all USART instances
+* (see reference manual), IDLE is always available.
+*
+* In delimited mode the hardware compare each byte with delimiter, so
+* CPU is interrupted once per packet and packet length is taken from
+* CNDTR. Packets received faster than interrupt latency are delivered
+* in one span (containing more delimiters).
+*
+* USART interrupt and DMA channel interrupt must have the same priority.
+* USART must be configured (baud rate, frame format, UE) by application.
+*
+* Example:
+*   io::UsartRx rx(io::USART1, io::DMA1, 3);
+*   uint8_t ring[256];
+*
+*   void received(void *, const uint8_t *data, size_t size, bool end) {
+*       parser.push(data, size);
+*       if (end) parser.frame_end();
+*   }
+*
+*   rx.start(ring, sizeof(ring), received, nullptr);
+*
+*   void USART1_handler() { rx.handle_isr(); }
+*   void DMA1_CH2_3_DMA2_CH1_2_handler() { rx.handle_dma_isr(); }
+*
+* MCUs containing this peripheral:
+*  - all MCUs with USART v2 and DMA v1 (F0, L0, L4, F3)
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "io/reg/stm32/_common/usart_v2.hpp"
+#include "io/reg/stm32/_common/dma_v1.hpp"
+
+namespace io {
+
+class UsartRx {
+public:
+    /** Receive callback
+     * called from interrupt
+     * @param context user context
+     * @param data received bytes in the ring
+     * @param size number of bytes (can be 0 with end, if frame ended exactly with previous span)
+     * @param end end of frame (line idle or receiver timeout)
+     */
+    typedef void (*receive_t)(void *context, const uint8_t *data, size_t size, bool end);
+
+    /** UsartRx constructor
+     * @param usart USART
+     * @param dma DMA controller
+     * @param channel DMA channel connected to USART RX request (1 - 7)
+     */
+    UsartRx(Usart &usart, Dma &dma, const unsigned channel) :
+        _usart(usart),
+        _dma(dma),
+        _channel(channel) {}
+
+    /** Start receiving
+     * @param ring buffer for DMA (max 65535 bytes)
+     * @param size size of ring
+     * @param receive called with received data
+     * @param context user context for callback
+     * @param timeout receiver timeout in bit times (RTOR), 0 for IDLE
+     */
+    void start(uint8_t *ring, const size_t size, receive_t receive, void *context=nullptr, const uint32_t timeout=0) {
+        stop();
+        start_dma(ring, size, receive, context);
+        if (timeout) {
+            _usart.RTOR.modify([timeout](Usart::Rtor &rtor) { rtor.b.RTO = timeout; });
+            _usart.CR2.modify([](Usart::Cr2 &cr2) { cr2.b.RTOEN = 1; });
+        }
+        _flags = error_flags() | end_flags(!timeout, timeout != 0, false);
+        _usart.ICR.r = error_flags() | end_flags(true, true, true);
+        _usart.CR3.modify([](Usart::Cr3 &cr3) {
+            cr3.b.DMAR = 1;
+            cr3.b.EIE = 1;
+        });
+        _usart.CR1.modify([timeout](Usart::Cr1 &cr1) {
+            cr1.b.PEIE = 1;
+            cr1.b.IDLEIE = !timeout;
+            cr1.b.RTOIE = timeout != 0;
+            cr1.b.RE = 1;
+        });
+    }
+
+    /** Start receiving packets ended by delimiter
+     * (line feed, SLIP END, ..)
+     * @param ring buffer for DMA (max 65535 bytes)
+     * @param size size of ring
+     * @param delimiter last byte of packet
+     * @param receive called with received data, end is set after delimiter
+     * @param context user context for callback
+     */
+    void start_delimited(uint8_t *ring, const size_t size, const uint8_t delimiter, receive_t receive, void *context=nullptr) {
+        stop();
+        start_dma(ring, size, receive, context);
+        // ADD can be written only when receiver is disabled
+        _usart.CR2.modify([delimiter](Usart::Cr2 &cr2) { cr2.b.ADD = delimiter; });
+        _flags = error_flags() | end_flags(false, false, true);
+        _usart.ICR.r = error_flags() | end_flags(true, true, true);
+        _usart.CR3.modify([](Usart::Cr3 &cr3) {
+            cr3.b.DMAR = 1;
+            cr3.b.EIE = 1;
+        });
+        _usart.CR1.modify([](Usart::Cr1 &cr1) {
+            cr1.b.PEIE = 1;
+            cr1.b.CMIE = 1;
+            cr1.b.RE = 1;
+        });
+    }
+
+    /** Stop receiving
+     * (data received after last delivered span are dropped)
+     */
+    void stop() {
+        _usart.CR1.modify([](Usart::Cr1 &cr1) {
+            cr1.b.PEIE = 0;
+            cr1.b.IDLEIE = 0;
+            cr1.b.RTOIE = 0;
+            cr1.b.CMIE = 0;
+            cr1.b.RE = 0;
+        });
+        _usart.CR3.modify([](Usart::Cr3 &cr3) {
+            cr3.b.DMAR = 0;
+            cr3.b.EIE = 0;
+        });
+        _usart.CR2.modify([](Usart::Cr2 &cr2) { cr2.b.RTOEN = 0; });
+        _dma.CHANNEL(_channel).CCR.r = 0;
+        _dma.IFCR.clear_flags(_channel);
+    }
+
+    /** Number of receive errors (overrun, framing, noise, parity) since start
+     */
+    unsigned errors() const {
+        return _errors;
+    }
+
+    /** USART interrupt handler
+     * call from USART interrupt handler
+     */
+    void handle_isr() {
+        // single read of flags, single write to clear them,
+        // flags without enabled interrupt are ignored (IDLE is set also in timeout mode)
+        const uint32_t flags = _usart.ISR.r & _flags;
+        if (!flags) return;
+        _usart.ICR.r = flags;
+        if (flags & error_flags()) _errors = _errors + 1;
+        if (flags & end_flags(false, false, true)) {
+            // matched byte can still wait in RDR for DMA
+            for (unsigned i = 0; i < RXNE_WAIT && _usart.ISR.read().b.RXNE; i++) {}
+        }
+        if (flags & end_flags(true, true, true)) deliver(true);
+    }
+
+    /** DMA channel interrupt handler
+     * call from interrupt handler of DMA channel
+     */
+    void handle_dma_isr() {
+        const unsigned shift = (_channel - 1) << 2;
+        const unsigned flags = (_dma.ISR.r >> shift) & (Dma::Ifcr::TCIF | Dma::Ifcr::HTIF | Dma::Ifcr::TEIF);
+        if (!flags) return;
+        // only read flags, flag raised after the read stays pending (GIF would clear it)
+        _dma.IFCR.clear_flags(_channel, flags);
+        dma_event(this, flags);
+    }
+
+    /** Channel event handler
+     * (can be used as DmaManager callback with this as context)
+     * @param context UsartRx instance
+     * @param flags TCIF, HTIF and TEIF of channel (already cleared)
+     */
+    static void dma_event(void *context, const unsigned flags) {
+        UsartRx &rx = *static_cast<UsartRx *>(context);
+        if (flags & Dma::Ifcr::TEIF) {
+            rx._errors = rx._errors + 1;
+            return;
+        }
+        rx.deliver(false);
+    }
+
+private:
+    static const unsigned RXNE_WAIT = 16;  // max polls of RXNE (RDR was not read by DMA yet)
+
+    Usart &_usart;
+    Dma &_dma;
+    const unsigned _channel;
+    uint8_t *_ring = nullptr;
+    size_t _size = 0;
+    size_t _tail = 0;
+    bool _partial = false;  // part of frame was delivered without end
+    receive_t _receive = nullptr;
+    void *_context = nullptr;
+    uint32_t _flags = 0;  // Isr flags with enabled interrupt
+    volatile unsigned _errors = 0;
+
+    /** Receive errors: PE, FE, NF, ORE
+     * (Isr flags, the same bits clear them in Icr)
+     */
+    static uint32_t error_flags() {
+        Usart::Icr icr;
+        icr.b.PECF = 1;
+        icr.b.FECF = 1;
+        icr.b.NCF = 1;
+        icr.b.ORECF = 1;
+        return icr.r;
+    }
+
+    /** End of frame: IDLE, RTOF, CMF
+     * (Isr flags, the same bits clear them in Icr)
+     */
+    static uint32_t end_flags(const bool idle, const bool timeout, const bool match) {
+        Usart::Icr icr;
+        icr.b.IDLECF = idle;
+        icr.b.RTOCF = timeout;
+        icr.b.CMCF = match;
+        return icr.r;
+    }
+
+    /** Reset state and start circular DMA
+     */
+    void start_dma(uint8_t *ring, const size_t size, receive_t receive, void *context) {
+        _ring = ring;
+        _size = size;
+        _tail = 0;
+        _partial = false;
+        _receive = receive;
+        _context = context;
+        _errors = 0;
+        Dma::Channel &ch = _dma.CHANNEL(_channel);
+        ch.CPAR.PAR(&_usart.RDR);
+        ch.CMAR.MAR(ring);
+        ch.CNDTR.r = static_cast<uint32_t>(size);
+        ch.CCR.write([](Dma::Channel::Ccr &ccr) {
+            ccr.b.CIRC = 1;
+            ccr.b.MINC = 1;
+            ccr.PSIZE(Dma::Channel::Ccr::Size::SIZE_8);
+            ccr.MSIZE(Dma::Channel::Ccr::Size::SIZE_8);
+            ccr.PL(Dma::Channel::Ccr::Pl::VERY_HIGH);
+            ccr.b.HTIE = 1;
+            ccr.b.TCIE = 1;
+            ccr.b.TEIE = 1;
+            ccr.b.EN = 1;
+        });
+    }
+
+    /** Deliver data between tail and DMA position
+     */
+    void deliver(const bool end) {
+        // CNDTR counts down from size, reload to size after wrap
+        size_t head = _size - _dma.CHANNEL(_channel).CNDTR.r;
+        if (head >= _size) head = 0;
+        const size_t tail = _tail;
+        _tail = head;
+        if (head == tail && !(end && _partial)) return;
+        _partial = !end;
+        if (head < tail) {
+            // wrapped: end of ring first
+            _receive(_context, _ring + tail, _size - tail, end && !head);
+            if (!head) return;
+            _receive(_context, _ring, head, end);
+        } else {
+            _receive(_context, _ring + tail, head - tail, end);
+        }
+    }
+};
+
+}
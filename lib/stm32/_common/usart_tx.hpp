@@ -0,0 +1,274 @@
+/**
+* USART transmit queue with DMA
+*
+* Messages are queued and sent back to back by DMA into TDR, next
+* message is started from DMA transfer complete interrupt, so main loop
+* never wait for TXE.
+*
+* Two ways to queue data:
+*  - send(): buffer is sent in place (no copy), it must stay valid until
+*    done callback is called
+*  - write(): data are copied into staging buffer, consecutive writes
+*    are coalesced into single DMA transfer while it is waiting in queue
+*    (logging of many small messages cost one DMA transfer per burst)
+*
+* Queue operations can be called from main loop, interrupts or code
+* with interrupts already disabled, they save and restore PRIMASK around
+* manipulation with queue (and copy of written data).
+*
+* Example:
+*   uint8_t staging[512];
+*   io::UsartTx<> tx(io::USART1, io::DMA1, 2, staging, sizeof(staging));
+*
+*   tx.write("temp=", 5);
+*   tx.write(digits, count);
+*   tx.send(frame, frame_size, frame_sent, nullptr);
+*
+*   void DMA1_CH2_3_DMA2_CH1_2_handler() { tx.handle_dma_isr(); }
+*
+* MCUs containing this peripheral:
+*  - all MCUs with USART v2 and DMA v1 (F0, L0, L4, F3)
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "io/reg/cortexm/nvic.hpp"
+#include "io/reg/stm32/_common/usart_v2.hpp"
+#include "io/reg/stm32/_common/dma_v1.hpp"
+
+namespace io {
+
+template <unsigned QUEUE=8>
+class UsartTx {
+    static_assert(QUEUE >= 2 && (QUEUE & (QUEUE - 1)) == 0, "QUEUE must be power of two");
+
+public:
+    static const size_t MAX_SIZE = 0xffff;
+
+    /** Done callback (send())
+     * called from interrupt when buffer was passed to USART
+     * @param context user context
+     * @param ok false on DMA transfer error (buffer was not sent whole)
+     */
+    typedef void (*done_t)(void *context, bool ok);
+
+    /** UsartTx constructor
+     * @param usart USART (configured and enabled by application)
+     * @param dma DMA controller
+     * @param channel DMA channel connected to USART TX request (1 - 7)
+     * @param staging buffer for write()
+     * @param staging_size size of staging buffer
+     */
+    UsartTx(Usart &usart, Dma &dma, const unsigned channel, uint8_t *staging=nullptr, const size_t staging_size=0) :
+        _usart(usart),
+        _dma(dma),
+        _channel(channel),
+        _stage(staging),
+        _stage_size(staging_size) {}
+
+    /** Queue buffer to send without copy
+     * @param data buffer
+     * @param size number of bytes (max 65535)
+     * @param done called when all bytes are passed to USART
+     * @param context user context for callback
+     * @return false if queue is full
+     */
+    bool send(const uint8_t *data, const size_t size, done_t done=nullptr, void *context=nullptr) {
+        if (!size || size > MAX_SIZE) return false;
+        const uint32_t primask = Nvic::isr_save();
+        const bool ok = push(data, size, false, done, context);
+        Nvic::isr_restore(primask);
+        return ok;
+    }
+
+    /** Copy data into staging buffer and queue them
+     * data are appended to previous write if it is still waiting
+     * @param data data
+     * @param size number of bytes
+     * @return false if there is no space in queue or staging buffer
+     */
+    bool write(const void *data, const size_t size) {
+        if (!size) return true;
+        const uint32_t primask = Nvic::isr_save();
+        bool ok = append(data, size);
+        if (!ok && size <= MAX_SIZE && _head - _tail < QUEUE) {
+            const size_t offset = allocate(size);
+            if (offset != NO_SPACE) {
+                copy(_stage + offset, data, size);
+                ok = push(_stage + offset, size, true, nullptr, nullptr);
+            }
+        }
+        Nvic::isr_restore(primask);
+        return ok;
+    }
+
+    /** Check if all queued data were passed to USART
+     */
+    bool is_idle() const {
+        return _head == _tail;
+    }
+
+    /** Wait until all queued data were passed to USART
+     */
+    void flush() const {
+        while (!is_idle()) {}
+    }
+
+    /** DMA channel interrupt handler
+     * call from interrupt handler of DMA channel
+     */
+    void handle_dma_isr() {
+        const unsigned shift = (_channel - 1) << 2;
+        const unsigned flags = (_dma.ISR.r >> shift) & (Dma::Ifcr::TCIF | Dma::Ifcr::TEIF);
+        if (!flags) return;
+        // only read flags, TCIF raised after the read stays pending (GIF would clear it)
+        _dma.IFCR.clear_flags(_channel, flags);
+        dma_event(this, flags);
+    }
+
+    /** Channel event handler
+     * (can be used as DmaManager callback with this as context)
+     * @param context UsartTx instance
+     * @param flags TCIF and TEIF of channel (already cleared)
+     */
+    static void dma_event(void *context, const unsigned flags) {
+        UsartTx &tx = *static_cast<UsartTx *>(context);
+        if (flags & (Dma::Ifcr::TCIF | Dma::Ifcr::TEIF)) tx.complete(!(flags & Dma::Ifcr::TEIF));
+    }
+
+private:
+    static const size_t NO_SPACE = ~static_cast<size_t>(0);
+
+    struct Message {
+        const uint8_t *data;
+        size_t size;
+        done_t done;
+        void *context;
+        bool staged;
+    };
+
+    Usart &_usart;
+    Dma &_dma;
+    const unsigned _channel;
+    uint8_t *const _stage;
+    const size_t _stage_size;
+    size_t _stage_head = 0;  // next free byte
+    size_t _stage_tail = 0;  // first used byte
+    Message _queue[QUEUE] = {};
+    volatile unsigned _head = 0;  // next free message
+    volatile unsigned _tail = 0;  // message being sent
+    bool _active = false;
+
+    static void copy(uint8_t *dst, const void *src, size_t size) {
+        const uint8_t *s = static_cast<const uint8_t *>(src);
+        while (size--) *dst++ = *s++;
+    }
+
+    /** Append data to last message if it is staged, waiting and contiguous
+     * (interrupts are disabled)
+     */
+    bool append(const void *data, const size_t size) {
+        if (_head == _tail) return false;
+        const unsigned last = (_head - 1) & (QUEUE - 1);
+        if (_active && last == (_tail & (QUEUE - 1))) return false;
+        Message &msg = _queue[last];
+        if (!msg.staged || msg.data + msg.size != _stage + _stage_head) return false;
+        if (msg.size + size > MAX_SIZE) return false;
+        // space after last message up to end of buffer or to first used byte
+        const size_t limit = _stage_head >= _stage_tail ? _stage_size : _stage_tail - 1;
+        if (_stage_head + size > limit) return false;
+        copy(_stage + _stage_head, data, size);
+        _stage_head += size;
+        msg.size += size;
+        return true;
+    }
+
+    /** Allocate contiguous space in staging buffer
+     * (interrupts are disabled)
+     * @return offset or NO_SPACE
+     */
+    size_t allocate(const size_t size) {
+        if (_head == _tail || !has_staged()) {
+            // nothing staged is queued, whole buffer is free
+            _stage_head = 0;
+            _stage_tail = 0;
+        }
+        size_t offset = _stage_head;
+        if (_stage_head >= _stage_tail) {
+            if (_stage_size - _stage_head < size) {
+                // wrap, must not reach first used byte (head == tail is empty)
+                if (_stage_tail <= size) return NO_SPACE;
+                offset = 0;
+            }
+        } else if (_stage_tail - _stage_head <= size) {
+            return NO_SPACE;
+        }
+        _stage_head = offset + size;
+        return offset;
+    }
+
+    bool has_staged() const {
+        for (unsigned i = _tail; i != _head; i++) {
+            if (_queue[i & (QUEUE - 1)].staged) return true;
+        }
+        return false;
+    }
+
+    /** Add message to queue, start DMA if idle
+     * (interrupts are disabled)
+     */
+    bool push(const uint8_t *data, const size_t size, const bool staged, done_t done, void *context) {
+        if (_head - _tail >= QUEUE) return false;
+        _queue[_head & (QUEUE - 1)] = {data, size, done, context, staged};
+        _head = _head + 1;
+        if (!_active) {
+            _usart.CR3.modify([](Usart::Cr3 &cr3) { cr3.b.DMAT = 1; });
+            start();
+        }
+        return true;
+    }
+
+    /** Start DMA for message at tail
+     */
+    void start() {
+        const Message &msg = _queue[_tail & (QUEUE - 1)];
+        Dma::Channel &ch = _dma.CHANNEL(_channel);
+        ch.CCR.r = 0;
+        ch.CPAR.PAR(&_usart.TDR);
+        ch.CMAR.MAR(msg.data);
+        ch.CNDTR.r = static_cast<uint32_t>(msg.size);
+        ch.CCR.write([](Dma::Channel::Ccr &ccr) {
+            ccr.b.DIR = 1;
+            ccr.b.MINC = 1;
+            ccr.PSIZE(Dma::Channel::Ccr::Size::SIZE_8);
+            ccr.MSIZE(Dma::Channel::Ccr::Size::SIZE_8);
+            ccr.PL(Dma::Channel::Ccr::Pl::MEDIUM);
+            ccr.b.TCIE = 1;
+            ccr.b.TEIE = 1;
+            ccr.b.EN = 1;
+        });
+        _active = true;
+    }
+
+    /** Message at tail was sent (or aborted by transfer error), chain next one
+     * (from interrupt)
+     */
+    void complete(const bool ok) {
+        if (!_active) return;
+        const Message msg = _queue[_tail & (QUEUE - 1)];
+        if (msg.staged) _stage_tail = static_cast<size_t>(msg.data - _stage) + msg.size;
+        _tail = _tail + 1;
+        _active = false;
+        if (_tail != _head) {
+            start();
+        } else {
+            _dma.CHANNEL(_channel).CCR.r = 0;
+        }
+        if (msg.done) msg.done(msg.context, ok);
+    }
+};
+
+}
@@ -0,0 +1,275 @@
+/**
+* Timer paced DMA waveform
+*
+* Stream of precomputed BSRR words is written by DMA channel into GPIO
+* port on each timer event (update or compare), so bit-banged protocols
+* (WS2812 LEDs, parallel strobes, stepper pulse trains, ..) run
+* without CPU. BSRR words can be prepared by PinGroup::bsrr().
+*
+* Two modes:
+*  - single: buffer is sent once, then done callback is called
+*  - stream: circular buffer, first half is refilled from half-transfer
+*    interrupt and second half from transfer-complete interrupt,
+*    stream ends when refill return less words than requested, rest
+*    of buffer is padded by zero (zero BSRR word does not change pins)
+*
+* Timer DMA request must be routed to the DMA channel (fixed mapping or
+* CSELR, see reference manual), timer period is set by set_rate() or
+* directly by application. handle_isr() must be called from DMA channel
+* interrupt handler.
+*
+* Example:
+*   io::Waveform wave(io::DMA1, 5, io::TIM1, io::Waveform::Trigger::UPDATE, io::GPIOB);
+*   wave.set_rate(0, 59);  // 48 MHz / 60 = 800 kHz
+*   wave.start(words, count, done, nullptr);
+*
+* MCUs containing this peripheral:
+*  - STM32F0xx
+*  - STM32L0xx
+*  - STM32L1xx
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "io/reg/stm32/_common/dma_v1.hpp"
+#include "io/reg/stm32/_common/gpio_v2.hpp"
+#include "io/reg/stm32/_common/timer.hpp"
+
+namespace io {
+
+class Waveform {
+public:
+    /** Timer event which trigger DMA request
+     * (value is bit position in Timer::Dier)
+     */
+    enum class Trigger : unsigned {
+        UPDATE = 8,  // UDE
+        CC1 = 9,  // CC1DE
+        CC2 = 10,  // CC2DE
+        CC3 = 11,  // CC3DE
+        CC4 = 12,  // CC4DE
+    };
+
+    /** Done callback (single mode, or transfer error)
+     * @param context user context
+     */
+    typedef void (*done_t)(void *context);
+
+    /** Refill callback (stream mode)
+     * @param context user context
+     * @param words half of buffer to fill with BSRR words
+     * @param count number of words
+     * @return number of filled words, less than count is end of stream
+     */
+    typedef size_t (*refill_t)(void *context, uint32_t *words, size_t count);
+
+    /** Waveform constructor
+     * @param dma DMA controller
+     * @param channel DMA channel (1 - 7)
+     * @param timer timer which pace the transfers
+     * @param trigger timer event used as DMA request
+     * @param gpio output port
+     */
+    Waveform(Dma &dma, const unsigned channel, Timer &timer, const Trigger trigger, Gpio &gpio) :
+        _dma(dma),
+        _channel(channel),
+        _timer(timer),
+        _trigger(trigger),
+        _gpio(gpio) {}
+
+    /** Set timer rate
+     * event frequency = timer clock / (psc + 1) / (arr + 1)
+     * @param psc prescaler
+     * @param arr auto reload value
+     */
+    void set_rate(const uint16_t psc, const uint16_t arr) {
+        _timer.PSC.r = psc;
+        _timer.ARR.r = arr;
+        // load prescaler immediately
+        _timer.EGR.write([](Timer::Egr &egr) { egr.b.UG = 1; });
+        _timer.SR.r = 0;
+    }
+
+    /** Send buffer once
+     * @param words BSRR words
+     * @param count number of words (1 - 65535)
+     * @param done called after last word was written
+     * @param context user context for callback
+     * @return false if count is out of range
+     */
+    bool start(const uint32_t *words, const size_t count, done_t done=nullptr, void *context=nullptr) {
+        // CNDTR 0 would never complete
+        if (!count || count > MAX_COUNT) return false;
+        stop();
+        _done = done;
+        _refill = nullptr;
+        _context = context;
+        _buffer = const_cast<uint32_t *>(words);
+        _count = count;
+        start_dma(false);
+        return true;
+    }
+
+    /** Start stream with circular double buffer
+     * both halves are filled by refill before start
+     * @param buffer buffer for BSRR words
+     * @param count number of words in buffer (even, 2 - 65534, odd count is rounded down)
+     * @param refill called when half of buffer need new data
+     * @param done called after end of stream was sent, or on error
+     * @param context user context for callbacks
+     * @return false if count is out of range
+     */
+    bool start_stream(uint32_t *buffer, const size_t count, refill_t refill, done_t done=nullptr, void *context=nullptr) {
+        const size_t even = count & ~static_cast<size_t>(1);
+        if (!even || even > MAX_COUNT) return false;
+        stop();
+        _done = done;
+        _refill = refill;
+        _context = context;
+        _buffer = buffer;
+        _count = even;
+        if (!fill(0)) {
+            // first half is the last one, second is already empty
+            clear(1);
+            _phase = Phase::DRAINING;
+        } else if (!fill(1)) {
+            _phase = Phase::LAST_QUEUED;
+        } else {
+            _phase = Phase::RUNNING;
+        }
+        start_dma(true);
+        return true;
+    }
+
+    /** Stop transfers
+     * (without done callback)
+     */
+    void stop() {
+        _timer.CR1.modify([](Timer::Cr1 &cr1) { cr1.b.CEN = 0; });
+        _timer.DIER.r = _timer.DIER.r & ~dier_mask();
+        _dma.CHANNEL(_channel).CCR.r = 0;
+        _dma.IFCR.clear_flags(_channel);
+        _running = false;
+    }
+
+    /** Check if transfer is running
+     */
+    bool is_running() const {
+        return _running;
+    }
+
+    /** DMA channel interrupt handler
+     * call from interrupt handler of DMA channel
+     */
+    void handle_isr() {
+        // single read of all flags of this channel
+        const unsigned shift = (_channel - 1) << 2;
+        const unsigned flags = (_dma.ISR.r >> shift) & (Dma::Ifcr::TCIF | Dma::Ifcr::HTIF | Dma::Ifcr::TEIF);
+        if (!flags) return;
+        // only read flags, flag set after read stays pending (GIF would clear it)
+        _dma.IFCR.clear_flags(_channel, flags);
+        if (flags & Dma::Ifcr::TEIF) {
+            finish();
+            return;
+        }
+        if (!_refill) {
+            if (flags & Dma::Ifcr::TCIF) finish();
+            return;
+        }
+        // HTIF: first half was sent, TCIF: second half was sent
+        if (flags & Dma::Ifcr::HTIF) half_sent(0);
+        if (_running && (flags & Dma::Ifcr::TCIF)) half_sent(1);
+    }
+
+private:
+    static const size_t MAX_COUNT = 0xffff;
+
+    enum class Phase {
+        RUNNING,  // both halves contain data
+        LAST_QUEUED,  // half with end of stream is queued
+        DRAINING,  // half with end of stream is being sent, other is zero
+    };
+
+    Dma &_dma;
+    const unsigned _channel;
+    Timer &_timer;
+    const Trigger _trigger;
+    Gpio &_gpio;
+    done_t _done = nullptr;
+    refill_t _refill = nullptr;
+    void *_context = nullptr;
+    uint32_t *_buffer = nullptr;
+    size_t _count = 0;
+    volatile bool _running = false;
+    Phase _phase = Phase::RUNNING;
+
+    uint32_t dier_mask() const {
+        return static_cast<uint32_t>(1) << static_cast<unsigned>(_trigger);
+    }
+
+    void start_dma(const bool circular) {
+        Dma::Channel &ch = _dma.CHANNEL(_channel);
+        ch.CPAR.PAR(&_gpio.BSRR);
+        ch.CMAR.MAR(_buffer);
+        ch.CNDTR.r = static_cast<uint32_t>(_count);
+        ch.CCR.write([circular](Dma::Channel::Ccr &ccr) {
+            ccr.b.DIR = 1;
+            ccr.b.MINC = 1;
+            ccr.b.CIRC = circular;
+            ccr.PSIZE(Dma::Channel::Ccr::Size::SIZE_32);
+            ccr.MSIZE(Dma::Channel::Ccr::Size::SIZE_32);
+            ccr.PL(Dma::Channel::Ccr::Pl::VERY_HIGH);
+            ccr.b.TCIE = 1;
+            ccr.b.HTIE = circular;
+            ccr.b.TEIE = 1;
+            ccr.b.EN = 1;
+        });
+        _running = true;
+        _timer.DIER.r = _timer.DIER.r | dier_mask();
+        _timer.CR1.modify([](Timer::Cr1 &cr1) { cr1.b.CEN = 1; });
+    }
+
+    /** Refill half of buffer, pad rest by zero
+     * @return false if this is end of stream
+     */
+    bool fill(const unsigned index) {
+        const size_t half = _count >> 1;
+        uint32_t *words = _buffer + index * half;
+        size_t filled = _refill(_context, words, half);
+        if (filled >= half) return true;
+        while (filled < half) words[filled++] = 0;
+        return false;
+    }
+
+    void clear(const unsigned index) {
+        const size_t half = _count >> 1;
+        uint32_t *words = _buffer + index * half;
+        for (size_t i = 0; i < half; i++) words[i] = 0;
+    }
+
+    void half_sent(const unsigned index) {
+        switch (_phase) {
+        case Phase::RUNNING:
+            if (!fill(index)) _phase = Phase::LAST_QUEUED;
+            break;
+        case Phase::LAST_QUEUED:
+            // other half with end of stream is being sent
+            clear(index);
+            _phase = Phase::DRAINING;
+            break;
+        case Phase::DRAINING:
+            finish();
+            break;
+        }
+    }
+
+    void finish() {
+        stop();
+        if (_done) _done(_context);
+    }
+};
+
+}
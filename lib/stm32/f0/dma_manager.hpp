@@ -0,0 +1,57 @@
+/**
+* DMA channel manager - STM32F0 interrupt vectors
+*
+* DMA channels of STM32F0 share interrupt vectors, each vector handler
+* must dispatch all channels of both controllers connected to it:
+*
+*   io::DmaManager dma1(io::DMA1);
+*   io::DmaManager dma2(io::DMA2, 5);
+*
+*   void DMA1_CH2_3_DMA2_CH1_2_handler() {
+*       dma1.handle_isr(io::dma_vector::DMA1_CH2_3);
+*       dma2.handle_isr(io::dma_vector::DMA2_CH1_2);
+*   }
+*
+*   void DMA1_CH4_5_6_7_DMA2_CH3_4_5_handler() {
+*       dma1.handle_isr(io::dma_vector::DMA1_CH4_5_6_7);
+*       dma2.handle_isr(io::dma_vector::DMA2_CH3_4_5);
+*   }
+*
+* MCUs containing this peripheral:
+*  - STM32F0xx
+*/
+
+#pragma once
+
+#include <cstdint>
+
+#include "io/lib/stm32/_common/dma_manager.hpp"
+#include "io/reg/stm32/f0/isr.hpp"
+
+namespace io {
+
+namespace dma_vector {
+
+/** Channel masks of shared interrupt vectors (DmaManager::handle_isr())
+ */
+static const uint32_t DMA1_CH1 = DmaManager::mask(1);
+static const uint32_t DMA1_CH2_3 = DmaManager::mask(2, 3);
+static const uint32_t DMA1_CH4_5_6_7 = DmaManager::mask(4, 5, 6, 7);
+static const uint32_t DMA2_CH1_2 = DmaManager::mask(1, 2);
+static const uint32_t DMA2_CH3_4_5 = DmaManager::mask(3, 4, 5);
+
+/** Interrupt number of DMA channel
+ * (for Nvic::ISER when channel is allocated)
+ * @param channel channel number (1 - 7)
+ * @param dma2 channel is from DMA2
+ * @return interrupt number
+ */
+static constexpr uint32_t isr(const unsigned channel, const bool dma2=false) {
+    return dma2
+        ? (channel <= 2 ? isr::DMA1_CH2_3_DMA2_CH1_2_isr : isr::DMA1_CH4_5_6_7_DMA2_CH3_4_5_isr)
+        : (channel == 1 ? isr::DMA1_CH1_isr : channel <= 3 ? isr::DMA1_CH2_3_DMA2_CH1_2_isr : isr::DMA1_CH4_5_6_7_DMA2_CH3_4_5_isr);
+}
+
+}
+
+}
@@ -0,0 +1,386 @@
+/**
+* Modbus RTU slave
+*
+* Frame gap (3.5 characters) is detected by USART receiver timeout
+* (RTOR, RTOF), no software timer. Request is received by DMA, checked
+* by CRC16 computed by CRC peripheral (polynomial 0x8005, reflected
+* input and output, init 0xffff), processed in the receiver timeout
+* interrupt and response is sent by DMA.
+*
+* Supported functions:
+*  - 0x03 read holding registers
+*  - 0x04 read input registers
+*  - 0x06 write single register
+*  - 0x10 write multiple registers
+* other functions are answered by exception 0x01 (illegal function).
+* Broadcast (address 0) write requests are processed without response.
+*
+* Programmable polynomial is available only on STM32F07x and STM32F09x,
+* other MCUs compute CRC by software (crc = nullptr).
+*
+* USART must be configured by application: baud rate, 9 bit frame with
+* parity (8E1, M0 = 1, PCE = 1) or 8N2, RS-485 DE (see Rs485) if used.
+* USART must support receiver timeout (USART1 on most F0 MCUs).
+*
+* Example:
+*   io::ModbusRtu modbus(io::USART1, io::DMA1, 3, 2, &io::CRC);
+*   modbus.start(0x11, 115200, read_register, write_register, nullptr);
+*
+*   void USART1_handler() { modbus.handle_isr(); }
+*   void DMA1_CH2_3_DMA2_CH1_2_handler() { modbus.handle_dma_isr(); }
+*
+* MCUs containing this peripheral:
+*  - STM32F0xx
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "io/reg/stm32/_common/usart_v2.hpp"
+#include "io/reg/stm32/_common/dma_v1.hpp"
+#include "io/reg/stm32/f0/crc.hpp"
+
+namespace io {
+
+/** Modbus CRC16 (polynomial 0x8005, reflected, init 0xffff)
+ */
+class ModbusCrc {
+public:
+    /** ModbusCrc constructor
+     * @param crc CRC peripheral with programmable polynomial, nullptr for software
+     */
+    ModbusCrc(Crc *crc) : _crc(crc) {}
+
+    /** Compute CRC
+     * @param data data
+     * @param size number of bytes
+     * @return CRC (transmitted low byte first)
+     */
+    uint16_t compute(const uint8_t *data, size_t size) const {
+        if (!_crc) return software(data, size);
+        _crc->POL.r = POLYNOMIAL;
+        _crc->INIT.r = 0xffff;
+        _crc->CR.write([](Crc::Cr &cr) {
+            cr.b.POLYSIZE = Crc::Cr::Polysize::POLY_16;
+            cr.b.REVIN = Crc::Cr::Revin::REV_8;
+            cr.b.REVOUT = Crc::Cr::Revout::REVERSE;
+            cr.b.RESET = 1;
+        });
+        while (size--) _crc->DR.DR8 = *data++;
+        return static_cast<uint16_t>(_crc->DR.r);
+    }
+
+    /** Compute CRC by software
+     */
+    static uint16_t software(const uint8_t *data, size_t size) {
+        uint16_t crc = 0xffff;
+        while (size--) {
+            crc ^= *data++;
+            for (unsigned i = 0; i < 8; i++) {
+                crc = (crc & 1) ? static_cast<uint16_t>((crc >> 1) ^ POLYNOMIAL_REFLECTED) : static_cast<uint16_t>(crc >> 1);
+            }
+        }
+        return crc;
+    }
+
+private:
+    static const uint32_t POLYNOMIAL = 0x8005;
+    static const uint16_t POLYNOMIAL_REFLECTED = 0xa001;
+
+    Crc *const _crc;
+};
+
+class ModbusRtu {
+public:
+    static const size_t MAX_ADU = 256;
+
+    /** Exception codes
+     */
+    struct Exception {
+        static const uint8_t NONE = 0x00;
+        static const uint8_t ILLEGAL_FUNCTION = 0x01;
+        static const uint8_t ILLEGAL_DATA_ADDRESS = 0x02;
+        static const uint8_t ILLEGAL_DATA_VALUE = 0x03;
+        static const uint8_t SLAVE_DEVICE_FAILURE = 0x04;
+    };
+
+    /** Function codes
+     */
+    struct Function {
+        static const uint8_t READ_HOLDING_REGISTERS = 0x03;
+        static const uint8_t READ_INPUT_REGISTERS = 0x04;
+        static const uint8_t WRITE_SINGLE_REGISTER = 0x06;
+        static const uint8_t WRITE_MULTIPLE_REGISTERS = 0x10;
+    };
+
+    /** Read register callback
+     * called from interrupt
+     * @param context user context
+     * @param function READ_HOLDING_REGISTERS or READ_INPUT_REGISTERS
+     * @param address register address
+     * @param value register value
+     * @return Exception::NONE or exception code
+     */
+    typedef uint8_t (*read_t)(void *context, uint8_t function, uint16_t address, uint16_t &value);
+
+    /** Write register callback
+     * called from interrupt
+     * @param context user context
+     * @param address register address
+     * @param value new register value
+     * @return Exception::NONE or exception code
+     */
+    typedef uint8_t (*write_t)(void *context, uint16_t address, uint16_t value);
+
+    /** Receiver timeout for 3.5 characters gap in bit times
+     * (11 bits per character, fixed 1750 us above 19200 baud)
+     * @param baud baud rate
+     */
+    static constexpr uint32_t frame_gap(const uint32_t baud) {
+        return baud > 19200 ? static_cast<uint32_t>((static_cast<uint64_t>(baud) * 1750 + 999999) / 1000000) : 39;
+    }
+
+    /** ModbusRtu constructor
+     * @param usart USART (with receiver timeout)
+     * @param dma DMA controller
+     * @param rx_channel DMA channel connected to USART RX request (1 - 7)
+     * @param tx_channel DMA channel connected to USART TX request (1 - 7)
+     * @param crc CRC peripheral with programmable polynomial or nullptr
+     */
+    ModbusRtu(Usart &usart, Dma &dma, const unsigned rx_channel, const unsigned tx_channel, Crc *crc=nullptr) :
+        _usart(usart),
+        _dma(dma),
+        _rx_channel(rx_channel),
+        _tx_channel(tx_channel),
+        _crc(crc) {}
+
+    /** Start slave
+     * @param address slave address (1 - 247)
+     * @param baud baud rate (for frame gap)
+     * @param read read register callback
+     * @param write write register callback
+     * @param context user context for callbacks
+     */
+    void start(const uint8_t address, const uint32_t baud, read_t read, write_t write, void *context=nullptr) {
+        _address = address;
+        _read = read;
+        _write = write;
+        _context = context;
+        const uint32_t gap = frame_gap(baud);
+        _usart.RTOR.modify([gap](Usart::Rtor &rtor) { rtor.b.RTO = gap; });
+        _usart.CR2.modify([](Usart::Cr2 &cr2) { cr2.b.RTOEN = 1; });
+        _usart.ICR.r = clear_flags();
+        start_rx();
+        _usart.CR3.modify([](Usart::Cr3 &cr3) {
+            cr3.b.DMAR = 1;
+            cr3.b.DMAT = 1;
+            cr3.b.EIE = 1;
+        });
+        _usart.CR1.modify([](Usart::Cr1 &cr1) {
+            cr1.b.RTOIE = 1;
+            cr1.b.RE = 1;
+            cr1.b.TE = 1;
+        });
+    }
+
+    /** Number of frames with wrong CRC or length
+     */
+    unsigned errors() const {
+        return _errors;
+    }
+
+    /** USART interrupt handler
+     * call from USART interrupt handler
+     */
+    void handle_isr() {
+        // single read of flags, single write to clear them
+        const uint32_t flags = _usart.ISR.r & clear_flags();
+        if (!flags) return;
+        _usart.ICR.r = flags;
+        const Usart::Isr isr = flags;
+        if (isr.b.PE || isr.b.FE || isr.b.NF || isr.b.ORE) _frame_error = true;
+        if (isr.b.RTOF) frame_end();
+    }
+
+    /** DMA TX channel interrupt handler
+     * call from interrupt handler of DMA channel
+     */
+    void handle_dma_isr() {
+        const unsigned shift = (_tx_channel - 1) << 2;
+        const unsigned flags = (_dma.ISR.r >> shift) & (Dma::Ifcr::TCIF | Dma::Ifcr::TEIF);
+        if (!flags) return;
+        // only read flags, TCIF raised after the read stays pending (GIF would clear it)
+        _dma.IFCR.clear_flags(_tx_channel, flags);
+        dma_event(this, flags);
+    }
+
+    /** TX channel event handler
+     * (can be used as DmaManager callback with this as context)
+     * @param context ModbusRtu instance
+     * @param flags TCIF and TEIF of channel (already cleared)
+     */
+    static void dma_event(void *context, const unsigned flags) {
+        ModbusRtu &modbus = *static_cast<ModbusRtu *>(context);
+        if (flags & (Dma::Ifcr::TCIF | Dma::Ifcr::TEIF)) modbus._dma.CHANNEL(modbus._tx_channel).CCR.r = 0;
+    }
+
+private:
+    static const uint8_t BROADCAST = 0;
+    static const uint16_t MAX_READ = 125;
+    static const uint16_t MAX_WRITE = 123;
+
+    Usart &_usart;
+    Dma &_dma;
+    const unsigned _rx_channel;
+    const unsigned _tx_channel;
+    const ModbusCrc _crc;
+    uint8_t _address = 0;
+    read_t _read = nullptr;
+    write_t _write = nullptr;
+    void *_context = nullptr;
+    bool _frame_error = false;
+    volatile unsigned _errors = 0;
+    uint8_t _rx[MAX_ADU + 1];  // one more byte to detect too long frame
+    uint8_t _tx[MAX_ADU];
+
+    /** Flags handled at frame end: errors (PE, FE, NF, ORE) and RTOF
+     * (Isr flags, the same bits clear them in Icr)
+     */
+    static uint32_t clear_flags() {
+        Usart::Icr icr;
+        icr.b.PECF = 1;
+        icr.b.FECF = 1;
+        icr.b.NCF = 1;
+        icr.b.ORECF = 1;
+        icr.b.RTOCF = 1;
+        return icr.r;
+    }
+
+    static uint16_t get16(const uint8_t *p) {
+        return static_cast<uint16_t>((p[0] << 8) | p[1]);
+    }
+
+    static void put16(uint8_t *p, const uint16_t value) {
+        p[0] = static_cast<uint8_t>(value >> 8);
+        p[1] = static_cast<uint8_t>(value);
+    }
+
+    void start_rx() {
+        Dma::Channel &ch = _dma.CHANNEL(_rx_channel);
+        ch.CCR.r = 0;
+        ch.CPAR.PAR(&_usart.RDR);
+        ch.CMAR.MAR(_rx);
+        ch.CNDTR.r = sizeof(_rx);
+        ch.CCR.write([](Dma::Channel::Ccr &ccr) {
+            ccr.b.MINC = 1;
+            ccr.PSIZE(Dma::Channel::Ccr::Size::SIZE_8);
+            ccr.MSIZE(Dma::Channel::Ccr::Size::SIZE_8);
+            ccr.PL(Dma::Channel::Ccr::Pl::VERY_HIGH);
+            ccr.b.EN = 1;
+        });
+        _frame_error = false;
+    }
+
+    void frame_end() {
+        const size_t size = sizeof(_rx) - _dma.CHANNEL(_rx_channel).CNDTR.r;
+        const bool error = _frame_error;
+        size_t response = 0;
+        if (error || size < 4 || size > MAX_ADU || _crc.compute(_rx, size)) {
+            // CRC over frame including its CRC is zero
+            if (size) _errors = _errors + 1;
+        } else if (_rx[0] == _address || _rx[0] == BROADCAST) {
+            response = process(size - 2);
+            if (_rx[0] == BROADCAST) response = 0;
+        }
+        start_rx();
+        if (response) send(response);
+    }
+
+    /** Process request PDU in _rx, build response in _tx
+     * @param size size of request without CRC
+     * @return size of response without CRC
+     */
+    size_t process(const size_t size) {
+        const uint8_t function = _rx[1];
+        const uint8_t *request = _rx + 2;
+        const size_t length = size - 2;
+        _tx[0] = _address;
+        _tx[1] = function;
+        uint8_t exception = Exception::NONE;
+        size_t response = 2;
+        switch (function) {
+        case Function::READ_HOLDING_REGISTERS:
+        case Function::READ_INPUT_REGISTERS: {
+            if (length != 4) return exception_response(Exception::ILLEGAL_DATA_VALUE);
+            const uint16_t address = get16(request);
+            const uint16_t count = get16(request + 2);
+            if (!count || count > MAX_READ) return exception_response(Exception::ILLEGAL_DATA_VALUE);
+            _tx[2] = static_cast<uint8_t>(count * 2);
+            for (uint16_t i = 0; i < count && exception == Exception::NONE; i++) {
+                uint16_t value = 0;
+                exception = _read ? _read(_context, function, static_cast<uint16_t>(address + i), value) : Exception::ILLEGAL_DATA_ADDRESS;
+                put16(_tx + 3 + i * 2, value);
+            }
+            response = 3 + count * 2;
+            break;
+        }
+        case Function::WRITE_SINGLE_REGISTER: {
+            if (length != 4) return exception_response(Exception::ILLEGAL_DATA_VALUE);
+            exception = _write ? _write(_context, get16(request), get16(request + 2)) : Exception::ILLEGAL_DATA_ADDRESS;
+            // echo of request
+            for (size_t i = 0; i < 4; i++) _tx[2 + i] = request[i];
+            response = 6;
+            break;
+        }
+        case Function::WRITE_MULTIPLE_REGISTERS: {
+            if (length < 5) return exception_response(Exception::ILLEGAL_DATA_VALUE);
+            const uint16_t address = get16(request);
+            const uint16_t count = get16(request + 2);
+            if (!count || count > MAX_WRITE || request[4] != count * 2 || length != 5u + count * 2) {
+                return exception_response(Exception::ILLEGAL_DATA_VALUE);
+            }
+            for (uint16_t i = 0; i < count && exception == Exception::NONE; i++) {
+                exception = _write ? _write(_context, static_cast<uint16_t>(address + i), get16(request + 5 + i * 2)) : Exception::ILLEGAL_DATA_ADDRESS;
+            }
+            for (size_t i = 0; i < 4; i++) _tx[2 + i] = request[i];
+            response = 6;
+            break;
+        }
+        default:
+            exception = Exception::ILLEGAL_FUNCTION;
+        }
+        if (exception != Exception::NONE) return exception_response(exception);
+        return response;
+    }
+
+    size_t exception_response(const uint8_t exception) {
+        _tx[1] = _rx[1] | 0x80;
+        _tx[2] = exception;
+        return 3;
+    }
+
+    void send(const size_t size) {
+        const uint16_t crc = _crc.compute(_tx, size);
+        _tx[size] = static_cast<uint8_t>(crc);
+        _tx[size + 1] = static_cast<uint8_t>(crc >> 8);
+        Dma::Channel &ch = _dma.CHANNEL(_tx_channel);
+        ch.CCR.r = 0;
+        ch.CPAR.PAR(&_usart.TDR);
+        ch.CMAR.MAR(_tx);
+        ch.CNDTR.r = static_cast<uint32_t>(size + 2);
+        ch.CCR.write([](Dma::Channel::Ccr &ccr) {
+            ccr.b.DIR = 1;
+            ccr.b.MINC = 1;
+            ccr.PSIZE(Dma::Channel::Ccr::Size::SIZE_8);
+            ccr.MSIZE(Dma::Channel::Ccr::Size::SIZE_8);
+            ccr.PL(Dma::Channel::Ccr::Pl::HIGH);
+            ccr.b.TCIE = 1;
+            ccr.b.TEIE = 1;
+            ccr.b.EN = 1;
+        });
+    }
+};
+
+}
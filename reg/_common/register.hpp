@@ -0,0 +1,106 @@
+/**
+* Register access helpers
+*
+* Common base for register structs (union of raw value `r` and
+* bit-field `b`). Each access to bit-field of volatile register is
+* separate load/modify/store on the bus, these helpers stage all
+* changes in non-volatile copy and access the register only once.
+*
+* Example:
+*   USART1.CR1.modify([](Usart::Cr1 &cr1) {
+*       cr1.b.M0 = 0;
+*       cr1.b.PCE = 1;
+*       cr1.b.TE = 1;
+*       cr1.b.RE = 1;
+*       cr1.b.UE = 1;
+*   });
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace io {
+
+namespace reg {
+
+/** Copy raw register value from peripheral
+ */
+inline void load(uint32_t &dst, const volatile uint32_t &src) {
+    dst = src;
+}
+
+/** Copy raw register value from peripheral (multi-word registers)
+ */
+template <size_t N>
+inline void load(uint32_t (&dst)[N], const volatile uint32_t (&src)[N]) {
+    for (size_t i = 0; i < N; i++) {
+        dst[i] = src[i];
+    }
+}
+
+/** Copy raw register value into peripheral
+ */
+inline void store(volatile uint32_t &dst, const uint32_t &src) {
+    dst = src;
+}
+
+/** Copy raw register value into peripheral (multi-word registers)
+ */
+template <size_t N>
+inline void store(volatile uint32_t (&dst)[N], const uint32_t (&src)[N]) {
+    for (size_t i = 0; i < N; i++) {
+        dst[i] = src[i];
+    }
+}
+
+}
+
+/** Base of register structs
+ * T is the register struct itself (must have member `r`)
+ */
+template <typename T>
+struct Register {
+    /** Read register
+     * (single load)
+     * @return non-volatile copy of register
+     */
+    inline T read() volatile const {
+        T tmp{};
+        reg::load(tmp.r, static_cast<const volatile T *>(this)->r);
+        return tmp;
+    }
+
+    /** Write register
+     * (single store)
+     * @param val new register value
+     */
+    inline void write(const T &val) volatile {
+        reg::store(static_cast<volatile T *>(this)->r, val.r);
+    }
+
+    /** Write register from zero value
+     * (single store, without reading register)
+     * @param f function which set fields of non-volatile copy: f(T &)
+     */
+    template <typename F>
+    inline void write(F f) volatile {
+        T tmp{};
+        f(tmp);
+        write(tmp);
+    }
+
+    /** Modify register
+     * (single load and single store)
+     * @param f function which change fields of non-volatile copy: f(T &)
+     */
+    template <typename F>
+    inline void modify(F f) volatile {
+        T tmp = read();
+        f(tmp);
+        write(tmp);
+    }
+};
+
+}
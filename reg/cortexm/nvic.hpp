@@ -16,13 +16,15 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "io/reg/_common/register.hpp"
+
 namespace io {
 
 struct Nvic {
     /** Software trigger interrupt register
      * This register is on Cortex-M3, M4 and M7
      */
-    struct Stir {
+    struct Stir : Register<Stir> {
         Stir(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -104,16 +106,46 @@ struct Nvic {
     }
 
     /** Enable global interrupt
+     * (no-op in host build)
      */
     static inline void isr_enable() {
+#if !defined(IO_HOST)
         __asm volatile ("cpsie i" : : : "memory");
+#endif
     }
 
     /**
      * disable global interrupt
+     * (no-op in host build)
      */
     static inline void isr_disable() {
+#if !defined(IO_HOST)
         __asm volatile ("cpsid i" : : : "memory");
+#endif
+    }
+
+    /** Disable global interrupt and return previous state
+     * (nested critical sections, no-op in host build)
+     * @return previous PRIMASK, for isr_restore()
+     */
+    static inline uint32_t isr_save() {
+        uint32_t primask = 0;
+#if !defined(IO_HOST)
+        __asm volatile ("mrs %0, primask\n\tcpsid i" : "=r" (primask) : : "memory");
+#endif
+        return primask;
+    }
+
+    /** Restore global interrupt state
+     * (no-op in host build)
+     * @param primask value returned by isr_save()
+     */
+    static inline void isr_restore(const uint32_t primask) {
+#if !defined(IO_HOST)
+        __asm volatile ("msr primask, %0" : : "r" (primask) : "memory");
+#else
+        (void)primask;
+#endif
     }
 
     static const size_t BASE = 0xe000e100;
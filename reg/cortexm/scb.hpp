@@ -16,12 +16,14 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "io/reg/_common/register.hpp"
+
 namespace io {
 
 struct Scb {
     /** CPUID Register
      */
-    struct Cpuid {
+    struct Cpuid : Register<Cpuid> {
         Cpuid(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -57,7 +59,7 @@ struct Scb {
 
     /** Interrupt control and state register
      */
-    struct Icsr {
+    struct Icsr : Register<Icsr> {
         Icsr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -93,7 +95,7 @@ struct Scb {
 
     /** Application Interrupt and Reset Control Register
      */
-    struct Aircr {
+    struct Aircr : Register<Aircr> {
         Aircr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -119,7 +121,7 @@ struct Scb {
 
     /** System control registe
      */
-    struct Scr {
+    struct Scr : Register<Scr> {
         Scr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -139,7 +141,7 @@ struct Scb {
 
     /** Configuration and control register
      */
-    struct Ccr {
+    struct Ccr : Register<Ccr> {
         Ccr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -162,7 +164,7 @@ struct Scb {
 
     /** System handler priority register
      */
-    struct Shpr {
+    struct Shpr : Register<Shpr> {
         Shpr(const uint32_t raw0=0, const uint32_t raw1=0, const uint32_t raw2=0) { r[0] = raw0; r[1] = raw1; r[2] = raw2; }
 
         struct Bits {
@@ -188,7 +190,7 @@ struct Scb {
 
     /** System handler control and state register (M3, M4, M7)
      */
-    struct Shcsr {
+    struct Shcsr : Register<Shcsr> {
         Shcsr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -220,7 +222,7 @@ struct Scb {
 
     /** Configurable fault status register (M3, M4, M7)
      */
-    struct Cfsr {
+    struct Cfsr : Register<Cfsr> {
         Cfsr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -258,7 +260,7 @@ struct Scb {
 
     /** HardFault status register (M3, M4, M7)
      */
-    struct Hfsr {
+    struct Hfsr : Register<Hfsr> {
         Hfsr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
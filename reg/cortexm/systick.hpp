@@ -16,12 +16,14 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "io/reg/_common/register.hpp"
+
 namespace io {
 
 struct Systick {
     /** SysTick control and status register
      */
-    struct Csr {
+    struct Csr : Register<Csr> {
         Csr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -46,7 +48,7 @@ struct Systick {
 
     /** SysTick reload value register
      */
-    struct Load {
+    struct Load : Register<Load> {
         Load(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -63,7 +65,7 @@ struct Systick {
 
     /** SysTick current value register
      */
-    struct Val {
+    struct Val : Register<Val> {
         Val(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -80,7 +82,7 @@ struct Systick {
 
     /** SysTick calibration value register
      */
-    struct Calib {
+    struct Calib : Register<Calib> {
         Calib(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -36,7 +36,7 @@ def generate_registers_definitions(peripheral):
         register_class_name = register.name.capitalize()
         print(f"    /** {register.description}")
         print("     */")
-        print(f"    struct {register_class_name} {{")
+        print(f"    struct {register_class_name} : Register<{register_class_name}> {{")
         print(f"        {register_class_name}(const uint32_t raw=0) {{ r = raw; }}")
         print()
         generate_bits(register)
@@ -117,6 +117,8 @@ def generate_peripheral(peripheral):
     print("#include <cstdint>")
     print("#include <cstddef>")
     print()
+    print('#include "io/reg/_common/register.hpp"')
+    print()
     print("namespace io {")
     print()
     print(f"/** {peripheral.description}")
@@ -13,12 +13,14 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "io/reg/_common/register.hpp"
+
 namespace io {
 
 struct Adc {
     /** Interrupt and status register
      */
-    struct Isr {
+    struct Isr : Register<Isr> {
         Isr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -42,7 +44,7 @@ struct Adc {
 
     /** Interrupt enable register
      */
-    struct Ier {
+    struct Ier : Register<Ier> {
         Ier(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -66,7 +68,7 @@ struct Adc {
 
     /** Control register
      */
-    struct Cr {
+    struct Cr : Register<Cr> {
         Cr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -89,7 +91,7 @@ struct Adc {
 
     /** Configuration register 1
      */
-    struct Cfgr1 {
+    struct Cfgr1 : Register<Cfgr1> {
         Cfgr1(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -129,7 +131,7 @@ struct Adc {
 
     /** Configuration register 2
      */
-    struct Cfgr2 {
+    struct Cfgr2 : Register<Cfgr2> {
         Cfgr2(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -167,7 +169,7 @@ struct Adc {
 
     /** Sampling time register
      */
-    struct Smpr {
+    struct Smpr : Register<Smpr> {
         Smpr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -194,7 +196,7 @@ struct Adc {
 
     /** Watchdog threshold register
      */
-    struct Tr {
+    struct Tr : Register<Tr> {
         Tr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -212,7 +214,7 @@ struct Adc {
 
     /** Channel selection register
      */
-    struct Chselr {
+    struct Chselr : Register<Chselr> {
         Chselr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -263,7 +265,7 @@ struct Adc {
 
     /** Calibration factor register (L0)
      */
-    struct Calfactr {
+    struct Calfactr : Register<Calfactr> {
         Calfactr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -279,7 +281,7 @@ struct Adc {
 
     /** Common configuration register
      */
-    struct Ccr {
+    struct Ccr : Register<Ccr> {
         Ccr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
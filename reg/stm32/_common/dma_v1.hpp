@@ -17,12 +17,14 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "io/reg/_common/register.hpp"
+
 namespace io {
 
 struct Dma {
     /** Interrupt status register
      */
-    struct Isr {
+    struct Isr : Register<Isr> {
         Isr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -81,7 +83,7 @@ struct Dma {
 
     /** Interrupt flag clear register
      */
-    struct Ifcr {
+    struct Ifcr : Register<Ifcr> {
         Ifcr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -152,7 +154,7 @@ struct Dma {
     struct Channel {
         /** Configuration register
          */
-        struct Ccr {
+        struct Ccr : Register<Ccr> {
             Ccr(const uint32_t raw=0) { r = raw; }
 
             struct Bits {
@@ -230,7 +232,7 @@ struct Dma {
 
             template <typename T>
             void PAR(T *par) volatile {
-                r = reinterpret_cast<uint32_t>(par);
+                r = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(par));
             }
         };
 
@@ -241,7 +243,7 @@ struct Dma {
 
             template <typename T>
             void MAR(T *mar) volatile {
-                r = reinterpret_cast<uint32_t>(mar);
+                r = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(mar));
             }
         };
 
@@ -254,7 +256,7 @@ struct Dma {
 
     /** Selection Register
      */
-    struct Cselr {
+    struct Cselr : Register<Cselr> {
         Cselr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -274,20 +276,20 @@ struct Dma {
         };
 
         inline void set(const unsigned channel, const unsigned request) volatile {
-            r &= ~static_cast<uint32_t>(0x0f << (channel << 2));
-            r |= (request & 0x0f) << (channel << 2);
+            const unsigned shift = (channel - 1) << 2;
+            r = (r & ~static_cast<uint32_t>(0x0f << shift)) | ((request & 0x0f) << shift);
         }
 
         inline unsigned get(const unsigned channel) volatile const {
-            return 0x0f & (r >> (channel << 2));
+            return 0x0f & (r >> ((channel - 1) << 2));
         }
     };
 
     volatile Isr ISR;  // Interrupt status register
     volatile Ifcr IFCR;  // Interrupt flag clear register
     Channel _CHANNEL[7];  // Channel registers
-    uint32_t __res1[20];
-    volatile Cselr CSELR;  // Selection Register
+    uint32_t __res1[5];
+    volatile Cselr CSELR;  // Selection Register (F09x, L0, L4)
 
     Channel &CHANNEL(const unsigned channel) {
         return _CHANNEL[channel - 1];
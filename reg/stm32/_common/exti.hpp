@@ -20,12 +20,14 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "io/reg/_common/register.hpp"
+
 namespace io {
 
 struct Exti {
     /** Mask register
      */
-    struct Mr {
+    struct Mr : Register<Mr> {
         Mr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -85,7 +87,7 @@ struct Exti {
 
     /** Trigger selection register
      */
-    struct Tr {
+    struct Tr : Register<Tr> {
         Tr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -145,7 +147,7 @@ struct Exti {
 
     /** Software interrupt event register
      */
-    struct Swier {
+    struct Swier : Register<Swier> {
         Swier(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -205,7 +207,7 @@ struct Exti {
 
     /** Pending register
      */
-    struct Pr {
+    struct Pr : Register<Pr> {
         Pr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
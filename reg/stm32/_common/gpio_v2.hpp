@@ -20,12 +20,14 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "io/reg/_common/register.hpp"
+
 namespace io {
 
 struct Gpio {
     /** GPIO port mode register
      */
-    struct Moder {
+    struct Moder : Register<Moder> {
         Moder(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -72,7 +74,7 @@ struct Gpio {
 
     /** GPIO port output type register
     */
-    struct Otyper {
+    struct Otyper : Register<Otyper> {
         Otyper(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -120,7 +122,7 @@ struct Gpio {
 
     /** GPIO port output speed register
      */
-    struct Ospeedr {
+    struct Ospeedr : Register<Ospeedr> {
         Ospeedr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -167,7 +169,7 @@ struct Gpio {
 
     /** GPIO port pull-up/pull-down register
      */
-    struct Pupdr {
+    struct Pupdr : Register<Pupdr> {
         Pupdr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -213,7 +215,7 @@ struct Gpio {
 
     /** GPIO port input data register
      */
-    struct Idr {
+    struct Idr : Register<Idr> {
         Idr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -249,7 +251,7 @@ struct Gpio {
 
     /** GPIO port output data register
      */
-    struct Odr {
+    struct Odr : Register<Odr> {
         Odr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -285,7 +287,7 @@ struct Gpio {
 
     /** GPIO port bit set/reset register
      */
-    struct Bsrr {
+    struct Bsrr : Register<Bsrr> {
         Bsrr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -345,7 +347,7 @@ struct Gpio {
 
     /** GPIO port configuration lock register
      */
-    struct Lckr {
+    struct Lckr : Register<Lckr> {
         Lckr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -377,7 +379,7 @@ struct Gpio {
 
     /** GPIO alternate function low register
      */
-    struct Afr {
+    struct Afr : Register<Afr> {
         Afr(const uint64_t raw=0) { r64 = raw; }
 
         struct Bits {
@@ -420,7 +422,7 @@ struct Gpio {
 
     /** GPIO port bit reset register
      */
-    struct Brr {
+    struct Brr : Register<Brr> {
         Brr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -456,7 +458,7 @@ struct Gpio {
 
     /** GPIO port analog switch control register
     */
-    struct Acsr {
+    struct Acsr : Register<Acsr> {
         Acsr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
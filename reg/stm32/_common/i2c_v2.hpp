@@ -17,12 +17,14 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "io/reg/_common/register.hpp"
+
 namespace io {
 
 struct I2c {
     /** Control register 1
      */
-    struct Cr1 {
+    struct Cr1 : Register<Cr1> {
         Cr1(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -58,7 +60,7 @@ struct I2c {
 
     /** Control register 2
      */
-    struct Cr2 {
+    struct Cr2 : Register<Cr2> {
         Cr2(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -84,7 +86,7 @@ struct I2c {
 
     /** Own address 1 register
      */
-    struct Oar1 {
+    struct Oar1 : Register<Oar1> {
         Oar1(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -103,7 +105,7 @@ struct I2c {
 
     /** Own address 2 register
      */
-    struct Oar2 {
+    struct Oar2 : Register<Oar2> {
         Oar2(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -123,7 +125,7 @@ struct I2c {
 
     /** Timing register
      */
-    struct Timingr {
+    struct Timingr : Register<Timingr> {
         Timingr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -143,7 +145,7 @@ struct I2c {
 
     /** Timeout register
      */
-    struct Timeoutr {
+    struct Timeoutr : Register<Timeoutr> {
         Timeoutr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -164,7 +166,7 @@ struct I2c {
 
     /** Interrupt and status register
      */
-    struct Isr {
+    struct Isr : Register<Isr> {
         Isr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -197,7 +199,7 @@ struct I2c {
 
     /** Interrupt clear register
      */
-    struct Icr {
+    struct Icr : Register<Icr> {
         Icr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -15,6 +15,8 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "io/reg/_common/register.hpp"
+
 namespace io {
 
 struct Iwdg {
@@ -36,7 +38,7 @@ struct Iwdg {
 
     /** Prescaler register
      */
-    struct Pr {
+    struct Pr : Register<Pr> {
         Pr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -64,7 +66,7 @@ struct Iwdg {
 
     /** Reload register
      */
-    struct Rlr {
+    struct Rlr : Register<Rlr> {
         Rlr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -82,7 +84,7 @@ struct Iwdg {
 
     /** Status register
      */
-    struct Sr {
+    struct Sr : Register<Sr> {
         Sr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -17,6 +17,8 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "io/reg/_common/register.hpp"
+
 namespace io {
 
 struct Iwdg {
@@ -38,7 +40,7 @@ struct Iwdg {
 
     /** Prescaler register
      */
-    struct Pr {
+    struct Pr : Register<Pr> {
         Pr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -66,7 +68,7 @@ struct Iwdg {
 
     /** Reload register
      */
-    struct Rlr {
+    struct Rlr : Register<Rlr> {
         Rlr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -88,7 +90,7 @@ struct Iwdg {
 
     /** Status register
      */
-    struct Sr {
+    struct Sr : Register<Sr> {
         Sr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -106,7 +108,7 @@ struct Iwdg {
 
     /** Window register
      */
-    struct Winr {
+    struct Winr : Register<Winr> {
         Winr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
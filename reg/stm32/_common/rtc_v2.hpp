@@ -21,12 +21,14 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "io/reg/_common/register.hpp"
+
 namespace io {
 
 struct Rtc {
     /** Time register
      */
-    struct Tr {
+    struct Tr : Register<Tr> {
         Tr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -50,7 +52,7 @@ struct Rtc {
 
     /** Date register
      */
-    struct Dr {
+    struct Dr : Register<Dr> {
         Dr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -73,7 +75,7 @@ struct Rtc {
 
     /** Control register
      */
-    struct Cr {
+    struct Cr : Register<Cr> {
         Cr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -122,7 +124,7 @@ struct Rtc {
 
     /** Initialization and status register
      */
-    struct Isr {
+    struct Isr : Register<Isr> {
         Isr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -155,7 +157,7 @@ struct Rtc {
 
     /** Prescaler register
      */
-    struct Prer {
+    struct Prer : Register<Prer> {
         Prer(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -173,7 +175,7 @@ struct Rtc {
 
     /** Wakeup timer register
      */
-    struct Wutr {
+    struct Wutr : Register<Wutr> {
         Wutr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -190,7 +192,7 @@ struct Rtc {
 
     /** Calibration register (F2, F4, L1)
      */
-    struct Calibr {
+    struct Calibr : Register<Calibr> {
         Calibr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -208,7 +210,7 @@ struct Rtc {
 
      /** Alarm register
      */
-    struct Alarmr {
+    struct Alarmr : Register<Alarmr> {
         Alarmr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -236,7 +238,7 @@ struct Rtc {
 
     /** Write protection register
      */
-    struct Wpr {
+    struct Wpr : Register<Wpr> {
         Wpr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -253,7 +255,7 @@ struct Rtc {
 
     /** Sub second register (F0, F3, F4, F7, H7, L0, L1, L4)
      */
-    struct Ssr {
+    struct Ssr : Register<Ssr> {
         Ssr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -269,7 +271,7 @@ struct Rtc {
 
     /** Shift control register (F0, F3, F4, F7, H7, L0, L1, L4)
      */
-    struct Shiftr {
+    struct Shiftr : Register<Shiftr> {
         Shiftr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -286,7 +288,7 @@ struct Rtc {
 
     /** Time-stamp time register
      */
-    struct Tstr {
+    struct Tstr : Register<Tstr> {
         Tstr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -310,7 +312,7 @@ struct Rtc {
 
     /** Time-stamp date register
      */
-    struct Tsdr {
+    struct Tsdr : Register<Tsdr> {
         Tsdr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -331,7 +333,7 @@ struct Rtc {
 
     /** Time-stamp sub second register (F0, F3, F4, F7, H7, L0, L1, L4)
      */
-    struct Tsssr {
+    struct Tsssr : Register<Tsssr> {
         Tsssr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -347,7 +349,7 @@ struct Rtc {
 
     /** Calibration register (F0, F3, F4, F7, H7, L0, L1, L4)
      */
-    struct Calr {
+    struct Calr : Register<Calr> {
         Calr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -367,7 +369,7 @@ struct Rtc {
 
     /** Tamper and alternate function configuration register (F0, F3, F46+, )
      */
-    struct Tafcr {
+    struct Tafcr : Register<Tafcr> {
         Tafcr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -401,7 +403,7 @@ struct Rtc {
 
     /** Alarm A sSub second register
      */
-    struct Alrmssr {
+    struct Alrmssr : Register<Alrmssr> {
         Alrmssr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -15,12 +15,14 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "io/reg/_common/register.hpp"
+
 namespace io {
 
 struct Spi {
     /** Control register 1
      */
-    struct Cr1 {
+    struct Cr1 : Register<Cr1> {
         Cr1(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -60,7 +62,7 @@ struct Spi {
 
     /** Control register 2
      */
-    struct Cr2 {
+    struct Cr2 : Register<Cr2> {
         Cr2(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -103,7 +105,7 @@ struct Spi {
 
     /** Status register
      */
-    struct Sr {
+    struct Sr : Register<Sr> {
         Sr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -174,7 +176,7 @@ struct Spi {
 
     /** I2S configuration register
      */
-    struct I2scfgr {
+    struct I2scfgr : Register<I2scfgr> {
         I2scfgr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -218,7 +220,7 @@ struct Spi {
 
     /** I2S prescaler register
      */
-    struct I2spr {
+    struct I2spr : Register<I2spr> {
         I2spr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -17,12 +17,14 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "io/reg/_common/register.hpp"
+
 namespace io {
 
 struct Timer {
     /** Control register 1
      */
-    struct Cr1 {
+    struct Cr1 : Register<Cr1> {
         Cr1(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -45,7 +47,7 @@ struct Timer {
 
     /** Control register 2
      */
-    struct Cr2 {
+    struct Cr2 : Register<Cr2> {
         Cr2(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -73,7 +75,7 @@ struct Timer {
 
     /** Slave mode control register
      */
-    struct Smcr {
+    struct Smcr : Register<Smcr> {
         Smcr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -118,7 +120,7 @@ struct Timer {
 
     /** DMA/interrupt enable register
      */
-    struct Dier {
+    struct Dier : Register<Dier> {
         Dier(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -148,7 +150,7 @@ struct Timer {
 
     /** Status register
      */
-    struct Sr {
+    struct Sr : Register<Sr> {
         Sr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -176,7 +178,7 @@ struct Timer {
 
     /** Event generation register
      */
-    struct Egr {
+    struct Egr : Register<Egr> {
         Egr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -199,8 +201,8 @@ struct Timer {
 
     /** Capture/compare mode register - output capture mode
      */
-    struct CcmrOc {
-        CcmrOc() {}
+    struct CcmrOc : Register<CcmrOc> {
+        CcmrOc(const uint32_t raw0=0, const uint32_t raw1=0) { r[0] = raw0; r[1] = raw1; }
 
         struct Bits {
             uint32_t CC1S : 2;  // Capture/Compare 1 selection
@@ -253,8 +255,8 @@ struct Timer {
 
     /** Capture/compare mode register input capture mode
      */
-    struct CcmrIc {
-        CcmrIc() {}
+    struct CcmrIc : Register<CcmrIc> {
+        CcmrIc(const uint32_t raw0=0, const uint32_t raw1=0) { r[0] = raw0; r[1] = raw1; }
 
         struct Bits {
             uint32_t : 2;
@@ -281,7 +283,7 @@ struct Timer {
 
     /** Capture/compare enable register
      */
-    struct Ccer {
+    struct Ccer : Register<Ccer> {
         Ccer(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -359,7 +361,7 @@ struct Timer {
 
     /** Break and dead-time register
      */
-    struct Bdtr {
+    struct Bdtr : Register<Bdtr> {
         Bdtr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -382,7 +384,7 @@ struct Timer {
 
     /** DMA control register
      */
-    struct Dcr {
+    struct Dcr : Register<Dcr> {
         Dcr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -16,12 +16,14 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "io/reg/_common/register.hpp"
+
 namespace io {
 
 struct Usart {
     /** Control register 1
      */
-    struct Cr1 {
+    struct Cr1 : Register<Cr1> {
         Cr1(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -57,7 +59,7 @@ struct Usart {
 
     /** Control register 2
      */
-    struct Cr2 {
+    struct Cr2 : Register<Cr2> {
         Cr2(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -91,7 +93,7 @@ struct Usart {
 
     /** Control register 3
      */
-    struct Cr3 {
+    struct Cr3 : Register<Cr3> {
         Cr3(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -128,7 +130,7 @@ struct Usart {
 
     /** Baud rate register
      */
-    struct Brr {
+    struct Brr : Register<Brr> {
         Brr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -145,7 +147,7 @@ struct Usart {
 
     /** Guard time and prescaler register
      */
-    struct Gtpr {
+    struct Gtpr : Register<Gtpr> {
         Gtpr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -162,7 +164,7 @@ struct Usart {
 
     /** Receiver timeout register
      */
-    struct Rtor {
+    struct Rtor : Register<Rtor> {
         Rtor(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -178,7 +180,7 @@ struct Usart {
 
     /** Request register
      */
-    struct Rqr {
+    struct Rqr : Register<Rqr> {
         Rqr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -198,7 +200,7 @@ struct Usart {
 
     /** Interrupt and status register
      */
-    struct Isr {
+    struct Isr : Register<Isr> {
         Isr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -238,7 +240,7 @@ struct Usart {
 
     /** Interrupt flag clear register
      */
-    struct Icr {
+    struct Icr : Register<Icr> {
         Icr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -20,12 +20,14 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "io/reg/_common/register.hpp"
+
 namespace io {
 
 struct Wwdg {
     /** Control register
      */
-    struct Cr {
+    struct Cr : Register<Cr> {
         Cr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -42,7 +44,7 @@ struct Wwdg {
 
     /** Configuration register
      */
-    struct Cfr {
+    struct Cfr : Register<Cfr> {
         Cfr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -67,7 +69,7 @@ struct Wwdg {
 
     /** Status register
      */
-    struct Sr {
+    struct Sr : Register<Sr> {
         Sr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
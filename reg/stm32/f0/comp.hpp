@@ -12,12 +12,14 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "io/reg/_common/register.hpp"
+
 namespace io {
 
 struct Comp {
     /** Control and status register
      */
-    struct Csr {
+    struct Csr : Register<Csr> {
         struct Bits {
             uint32_t COMP1EN : 1;  // Comparator 1 enable
             uint32_t COMP1SW1 : 1;  // Comparator 1 non inverting input DAC switch
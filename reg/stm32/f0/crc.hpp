@@ -12,6 +12,8 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "io/reg/_common/register.hpp"
+
 namespace io {
 
 struct Crc {
@@ -29,7 +31,7 @@ struct Crc {
 
     /** Independent data register
      */
-    struct Idr {
+    struct Idr : Register<Idr> {
         struct Bits {
             uint32_t IDR : 8;  // General-purpose 8-bit data register bits
             uint32_t : 24;
@@ -44,7 +46,7 @@ struct Crc {
 
     /** Control register
      */
-    struct Cr {
+    struct Cr : Register<Cr> {
         Cr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -101,10 +103,13 @@ struct Crc {
     volatile Dr DR;  // Data register
     volatile Idr IDR;  // Independent data register
     volatile Cr CR;  // Control register
+    uint32_t __res0;
     volatile Init INIT;  // Initial CRC value
     volatile Pol POL;  // CRC polynomial
 };
 
+static_assert(offsetof(Crc, INIT) == 0x10, "wrong CRC register layout");
+
 namespace base {
 
 static constexpr size_t CRC = 0x40023000;
@@ -14,12 +14,14 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "io/reg/_common/register.hpp"
+
 namespace io {
 
 struct Crs {
     /** Control register
      */
-    struct Cr {
+    struct Cr : Register<Cr> {
         Cr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -43,7 +45,7 @@ struct Crs {
 
     /** Configuration register
      */
-    struct Cfgr {
+    struct Cfgr : Register<Cfgr> {
         Cfgr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -64,7 +66,7 @@ struct Crs {
 
     /** Interrupt and status register
      */
-    struct Isr {
+    struct Isr : Register<Isr> {
         Isr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -89,7 +91,7 @@ struct Crs {
 
     /** Interrupt flag clear register
      */
-    struct Icr {
+    struct Icr : Register<Icr> {
         Icr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -14,12 +14,14 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "io/reg/_common/register.hpp"
+
 namespace io {
 
 struct Dac {
     /** Control register
      */
-    struct Cr {
+    struct Cr : Register<Cr> {
         Cr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -82,7 +84,7 @@ struct Dac {
 
     /** DAC software trigger register
      */
-    struct Swtrigr {
+    struct Swtrigr : Register<Swtrigr> {
         Swtrigr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -189,7 +191,7 @@ struct Dac {
 
     /** Dual DAC 12-bit right-aligned data holding register
      */
-    struct Dhr12rd {
+    struct Dhr12rd : Register<Dhr12rd> {
         Dhr12rd(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -212,7 +214,7 @@ struct Dac {
 
     /** Dual DAC 12-bit left-aligned data holding register
      */
-    struct Dhr12ld {
+    struct Dhr12ld : Register<Dhr12ld> {
         Dhr12ld(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -235,7 +237,7 @@ struct Dac {
 
     /** Dual DAC 8-bit right-aligned data holding register
      */
-    struct Dhr8rd {
+    struct Dhr8rd : Register<Dhr8rd> {
         Dhr8rd(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -259,7 +261,7 @@ struct Dac {
 
     /** DAC Channel 1 data output register
      */
-    struct Dhrdor1 {
+    struct Dhrdor1 : Register<Dhrdor1> {
         struct Bits {
             const uint32_t DACC1DOR : 16;  // DAC channel 1 data output
             uint32_t : 16;
@@ -273,7 +275,7 @@ struct Dac {
 
     /** DAC Channel 2 data output register
      */
-    struct Dhrdor2 {
+    struct Dhrdor2 : Register<Dhrdor2> {
         struct Bits {
             const uint32_t DACC2DOR : 16;  // DAC channel 2 data output
             uint32_t : 16;
@@ -287,7 +289,7 @@ struct Dac {
 
     /** DAC status register
      */
-    struct Sr {
+    struct Sr : Register<Sr> {
         struct Bits {
             uint32_t : 13;
             const uint32_t DMAUDR1 : 1;  // DAC channel 2 data output
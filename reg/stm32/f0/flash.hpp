@@ -12,12 +12,14 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "io/reg/_common/register.hpp"
+
 namespace io {
 
 struct Flash {
     /** Flash access control register
      */
-    struct Acr {
+    struct Acr : Register<Acr> {
         Acr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -36,7 +38,7 @@ struct Flash {
 
     /** Flash status register
      */
-    struct Sr {
+    struct Sr : Register<Sr> {
         Sr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -57,7 +59,7 @@ struct Flash {
 
     /** Flash control register
      */
-    struct Cr {
+    struct Cr : Register<Cr> {
         Cr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -86,7 +88,7 @@ struct Flash {
 
     /** Flash option byte register
      */
-    struct Obr {
+    struct Obr : Register<Obr> {
         Obr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
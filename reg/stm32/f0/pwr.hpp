@@ -12,12 +12,14 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "io/reg/_common/register.hpp"
+
 namespace io {
 
 struct Pwr {
     /** Power control register
      */
-    struct Cr {
+    struct Cr : Register<Cr> {
         Cr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -50,7 +52,7 @@ struct Pwr {
 
     /** Power control status register
      */
-    struct Csr {
+    struct Csr : Register<Csr> {
         Csr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -12,12 +12,14 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "io/reg/_common/register.hpp"
+
 namespace io {
 
 struct Rcc {
     /** Clock control register
      */
-    struct Cr {
+    struct Cr : Register<Cr> {
         Cr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -44,7 +46,7 @@ struct Rcc {
 
     /** Clock configuration register
      */
-    struct Cfgr {
+    struct Cfgr : Register<Cfgr> {
         Cfgr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -146,7 +148,7 @@ struct Rcc {
 
     /** Clock interrupt register
      */
-    struct Cir {
+    struct Cir : Register<Cir> {
         Cir(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -187,7 +189,7 @@ struct Rcc {
      * clock enable register
      * reset register
      */
-    struct Ahb {
+    struct Ahb : Register<Ahb> {
         Ahb(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -220,7 +222,7 @@ struct Rcc {
      * clock enable register
      * reset register
      */
-    struct Apb2 {
+    struct Apb2 : Register<Apb2> {
         Apb2(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -255,7 +257,7 @@ struct Rcc {
      * clock enable register
      * reset register
      */
-    struct Apb1 {
+    struct Apb1 : Register<Apb1> {
         Apb1(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -296,7 +298,7 @@ struct Rcc {
 
     /** RTC domain control register
      */
-    struct Bdcr {
+    struct Bdcr : Register<Bdcr> {
         Bdcr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -327,7 +329,7 @@ struct Rcc {
 
     /** Control/status register
      */
-    struct Csr {
+    struct Csr : Register<Csr> {
         Csr(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -353,7 +355,7 @@ struct Rcc {
 
     /** Clock configuration register 2
      */
-    struct Cfgr2 {
+    struct Cfgr2 : Register<Cfgr2> {
         Cfgr2(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -388,7 +390,7 @@ struct Rcc {
 
     /** Clock configuration register 3
      */
-    struct Cfgr3 {
+    struct Cfgr3 : Register<Cfgr3> {
         Cfgr3(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -420,7 +422,7 @@ struct Rcc {
 
     /** Clock control register 2
      */
-    struct Cr2 {
+    struct Cr2 : Register<Cr2> {
         Cr2(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -12,12 +12,14 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "io/reg/_common/register.hpp"
+
 namespace io {
 
 struct Syscfg {
     /** configuration register 1
      */
-    struct Cfgr1 {
+    struct Cfgr1 : Register<Cfgr1> {
         Cfgr1(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -65,19 +67,13 @@ struct Syscfg {
 
     /** external interrupt configuration register 1
      */
-    struct Exticr {
-        Afr() {
-            for (int i = 0; i < 4) {
+    struct Exticr : Register<Exticr> {
+        Exticr() {
+            for (size_t i = 0; i < 4; i++) {
                 r[i] = 0;
             }
         }
 
-        Afr(Acr &acr) {
-            for (int i = 0; i < 4) {
-                r[i] = acr.r[i];
-            }
-        }
-
         struct Bits {
             uint16_t EXTI0 : 4;  // select EXTI source
             uint16_t EXTI1 : 4;
@@ -118,7 +114,7 @@ struct Syscfg {
 
     /** configuration register 2
      */
-    struct Cfgr2 {
+    struct Cfgr2 : Register<Cfgr2> {
         Cfgr2(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -138,7 +134,7 @@ struct Syscfg {
 
     /** Interrupt line 0 status register
      */
-    struct Itline0 {
+    struct Itline0 : Register<Itline0> {
         Itline0(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -154,7 +150,7 @@ struct Syscfg {
 
     /** Interrupt line 1 status register
      */
-    struct Itline1 {
+    struct Itline1 : Register<Itline1> {
         Itline1(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -171,7 +167,7 @@ struct Syscfg {
 
     /** Interrupt line 2 status register
      */
-    struct Itline2 {
+    struct Itline2 : Register<Itline2> {
         Itline2(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -189,7 +185,7 @@ struct Syscfg {
 
     /** Interrupt line 3 status register
      */
-    struct Itline3 {
+    struct Itline3 : Register<Itline3> {
         Itline3(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -205,7 +201,7 @@ struct Syscfg {
 
     /** Interrupt line 4 status register
      */
-    struct Itline4 {
+    struct Itline4 : Register<Itline4> {
         Itline4(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -222,7 +218,7 @@ struct Syscfg {
 
     /** Interrupt line 5 status register
      */
-    struct Itline5 {
+    struct Itline5 : Register<Itline5> {
         Itline5(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -239,7 +235,7 @@ struct Syscfg {
 
     /** Interrupt line 6 status register
      */
-    struct Itline6 {
+    struct Itline6 : Register<Itline6> {
         Itline6(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -256,7 +252,7 @@ struct Syscfg {
 
     /** Interrupt line 7 status register
      */
-    struct Itline7 {
+    struct Itline7 : Register<Itline7> {
         Itline7(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -283,7 +279,7 @@ struct Syscfg {
 
     /** Interrupt line 8 status register
      */
-    struct Itline8 {
+    struct Itline8 : Register<Itline8> {
         Itline8(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -300,7 +296,7 @@ struct Syscfg {
 
     /** Interrupt line 9 status register
      */
-    struct Itline9 {
+    struct Itline9 : Register<Itline9> {
         Itline9(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -316,7 +312,7 @@ struct Syscfg {
 
     /** Interrupt line 10 status register
      */
-    struct Itline10 {
+    struct Itline10 : Register<Itline10> {
         Itline10(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -335,7 +331,7 @@ struct Syscfg {
 
     /** Interrupt line 11 status register
      */
-    struct Itline11 {
+    struct Itline11 : Register<Itline11> {
         Itline11(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -343,9 +339,9 @@ struct Syscfg {
             const uint32_t DMA1_CH5 : 1;  // DMA1_CH5 Interrupt request pending
             const uint32_t DMA1_CH6 : 1;  // DMA1_CH6 Interrupt request pending
             const uint32_t DMA1_CH7 : 1;  // DMA1_CH7 Interrupt request pending
-            const uint32_t DMA2_CH1 : 1;  // DMA2_CH1 Interrupt request pending
-            const uint32_t DMA2_CH2 : 1;  // DMA2_CH2 Interrupt request pending
-            const uint32_t DMA2_CH2 : 1;  // DMA2_CH2 Interrupt request pending
+            const uint32_t DMA2_CH3 : 1;  // DMA2_CH3 Interrupt request pending
+            const uint32_t DMA2_CH4 : 1;  // DMA2_CH4 Interrupt request pending
+            const uint32_t DMA2_CH5 : 1;  // DMA2_CH5 Interrupt request pending
             uint32_t : 25;
         };
 
@@ -357,7 +353,7 @@ struct Syscfg {
 
     /** Interrupt line 12 status register
      */
-    struct Itline12 {
+    struct Itline12 : Register<Itline12> {
         Itline12(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -375,7 +371,7 @@ struct Syscfg {
 
     /** Interrupt line 13 status register
      */
-    struct Itline13 {
+    struct Itline13 : Register<Itline13> {
         Itline13(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -394,7 +390,7 @@ struct Syscfg {
 
     /** Interrupt line 14 status register
      */
-    struct Itline14 {
+    struct Itline14 : Register<Itline14> {
         Itline14(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -410,7 +406,7 @@ struct Syscfg {
 
     /** Interrupt line 15 status register
      */
-    struct Itline15 {
+    struct Itline15 : Register<Itline15> {
         Itline15(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -426,7 +422,7 @@ struct Syscfg {
 
     /** Interrupt line 16 status register
      */
-    struct Itline16 {
+    struct Itline16 : Register<Itline16> {
         Itline16(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -442,7 +438,7 @@ struct Syscfg {
 
     /** Interrupt line 17 status register
      */
-    struct Itline17 {
+    struct Itline17 : Register<Itline17> {
         Itline17(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -459,7 +455,7 @@ struct Syscfg {
 
     /** Interrupt line 18 status register
      */
-    struct Itline18 {
+    struct Itline18 : Register<Itline18> {
         Itline18(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -475,7 +471,7 @@ struct Syscfg {
 
     /** Interrupt line 19 status register
      */
-    struct Itline19 {
+    struct Itline19 : Register<Itline19> {
         Itline19(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -491,7 +487,7 @@ struct Syscfg {
 
     /** Interrupt line 20 status register
      */
-    struct Itline20 {
+    struct Itline20 : Register<Itline20> {
         Itline20(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -507,7 +503,7 @@ struct Syscfg {
 
     /** Interrupt line 21 status register
      */
-    struct Itline21 {
+    struct Itline21 : Register<Itline21> {
         Itline21(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -523,7 +519,7 @@ struct Syscfg {
 
     /** Interrupt line 22 status register
      */
-    struct Itline22 {
+    struct Itline22 : Register<Itline22> {
         Itline22(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -539,7 +535,7 @@ struct Syscfg {
 
     /** Interrupt line 23 status register
      */
-    struct Itline23 {
+    struct Itline23 : Register<Itline23> {
         Itline23(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -555,7 +551,7 @@ struct Syscfg {
 
     /** Interrupt line 24 status register
      */
-    struct Itline24 {
+    struct Itline24 : Register<Itline24> {
         Itline24(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -571,7 +567,7 @@ struct Syscfg {
 
     /** Interrupt line 25 status register
      */
-    struct Itline25 {
+    struct Itline25 : Register<Itline25> {
         Itline25(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -587,7 +583,7 @@ struct Syscfg {
 
     /** Interrupt line 26 status register
      */
-    struct Itline26 {
+    struct Itline26 : Register<Itline26> {
         Itline26(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -603,7 +599,7 @@ struct Syscfg {
 
     /** Interrupt line 27 status register
      */
-    struct Itline27 {
+    struct Itline27 : Register<Itline27> {
         Itline27(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -619,7 +615,7 @@ struct Syscfg {
 
     /** Interrupt line 28 status register
      */
-    struct Itline28 {
+    struct Itline28 : Register<Itline28> {
         Itline28(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -635,7 +631,7 @@ struct Syscfg {
 
     /** Interrupt line 29 status register
      */
-    struct Itline29 {
+    struct Itline29 : Register<Itline29> {
         Itline29(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -656,7 +652,7 @@ struct Syscfg {
 
     /** Interrupt line 30 status register
      */
-    struct Itline30 {
+    struct Itline30 : Register<Itline30> {
         Itline30(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -673,7 +669,7 @@ struct Syscfg {
 
     /** Interrupt line 31 status register
      */
-    struct Itline31 {
+    struct Itline31 : Register<Itline31> {
         Itline31(const uint32_t raw=0) { r = raw; }
 
         struct Bits {
@@ -12,6 +12,7 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "io/reg/_common/register.hpp"
 #include "io/reg/stm32/_common/adc_v2.hpp"
 
 namespace io {
@@ -20,7 +21,7 @@ struct Sysmem {
 
     /** Unique device ID
      */
-    struct Uid {
+    struct Uid : Register<Uid> {
         struct Bits {
             const uint16_t X;  // x-coordinate
             const uint16_t Y;  // y-coordinate
@@ -0,0 +1,74 @@
+/**
+* Host test checks
+*
+* Minimal checks for unit tests of host build (see test/run.py), each
+* failed check is printed and counted, main() return io::test::result().
+*
+* Example:
+*   io::test::check_equal(io::GPIOA.MODER.r, 0x400, "PA5 output");
+*   return io::test::result("gpio");
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+
+namespace io {
+
+namespace test {
+
+/** Number of failed checks
+ */
+inline unsigned &failures() {
+    static unsigned count = 0;
+    return count;
+}
+
+/** Check condition
+ * @param ok condition
+ * @param what description of check
+ * @return ok
+ */
+inline bool check(const bool ok, const char *what) {
+    if (!ok) {
+        failures()++;
+        std::printf("FAIL: %s\n", what);
+    }
+    return ok;
+}
+
+/** Check value
+ * @param actual value
+ * @param expected expected value
+ * @param what description of check
+ * @return true if values are equal
+ */
+inline bool check_equal(const uint64_t actual, const uint64_t expected, const char *what) {
+    if (actual != expected) {
+        failures()++;
+        std::printf("FAIL: %s: %llu (0x%llx), expected %llu (0x%llx)\n", what,
+            static_cast<unsigned long long>(actual), static_cast<unsigned long long>(actual),
+            static_cast<unsigned long long>(expected), static_cast<unsigned long long>(expected));
+        return false;
+    }
+    return true;
+}
+
+/** Print result of test
+ * @param name name of test
+ * @return exit code for main()
+ */
+inline int result(const char *name) {
+    if (failures()) {
+        std::printf("%s: %u checks FAILED\n", name, failures());
+        return 1;
+    }
+    std::printf("%s: OK\n", name);
+    return 0;
+}
+
+}
+
+}
@@ -0,0 +1,104 @@
+"""io:test host unit tests
+
+Compile each test (test/test_*.cpp) by host compiler for host build
+(IO_HOST, simulated memory), run it and report result. Python tests
+(test/test_*.py) are run by the same interpreter.
+
+Tests using bus access counter (include io/host/access_counter.hpp)
+are linked with io/host/access_counter.cpp and run only on x86-64.
+"""
+
+import argparse
+import os
+import platform
+import subprocess
+import sys
+import tempfile
+
+
+class TestError(Exception):
+    pass
+
+
+TEST_DIR = os.path.dirname(os.path.abspath(__file__))
+IO_DIR = os.path.dirname(TEST_DIR)
+
+CFLAGS = [
+    '-std=c++14',
+    '-Wall',
+    '-Wextra',
+    '-Werror',
+    '-DIO_HOST',
+    # DMA address registers are 32 bit, static buffers must be in low 4 GB
+    '-no-pie',
+]
+
+OPTIMIZATIONS = ['0', '1', '2', '3', 's']
+
+MEMORY = os.path.join(IO_DIR, 'host', 'memory.cpp')
+ACCESS_COUNTER = os.path.join(IO_DIR, 'host', 'access_counter.cpp')
+
+
+def uses_access_counter(source):
+    with open(source) as file:
+        return 'io/host/access_counter.hpp' in file.read()
+
+
+def compile_test(tmp, source, compiler, optimization):
+    """Compile one test, return path of executable"""
+    exe = os.path.join(tmp, os.path.splitext(os.path.basename(source))[0])
+    sources = [source, MEMORY]
+    if uses_access_counter(source):
+        sources.append(ACCESS_COUNTER)
+    cmd = [compiler, *CFLAGS, optimization, f'-I{tmp}', *sources, '-o', exe]
+    try:
+        subprocess.run(cmd, check=True)
+    except (OSError, subprocess.CalledProcessError) as err:
+        raise TestError(f"{source}: {err}") from err
+    return exe
+
+
+def run_tests(sources, compiler, optimization):
+    """Run tests, return list of failed tests"""
+    failed = []
+    with tempfile.TemporaryDirectory() as tmp:
+        # tests include headers as "io/..."
+        os.symlink(IO_DIR, os.path.join(tmp, 'io'))
+        for source in sources:
+            name = os.path.basename(source)
+            if source.endswith('.py'):
+                cmd = [sys.executable, source]
+            else:
+                if uses_access_counter(source) and platform.machine() != 'x86_64':
+                    print(f"{name}: SKIPPED (access counter is x86-64 only)")
+                    continue
+                cmd = [compile_test(tmp, source, compiler, optimization)]
+            if subprocess.run(cmd).returncode != 0:
+                failed.append(name)
+    return failed
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('sources', nargs='*', help="tests (default: test/test_*.cpp test/test_*.py)")
+    parser.add_argument('-c', '--compiler', default='g++', help="host compiler (default: %(default)s)")
+    parser.add_argument('-O', '--optimization', default='1', choices=OPTIMIZATIONS, help="optimization level (default: %(default)s)")
+    args = parser.parse_args()
+
+    sources = args.sources or sorted(
+        os.path.join(TEST_DIR, name) for name in os.listdir(TEST_DIR)
+        if name.startswith('test_') and name.endswith(('.cpp', '.py')))
+    failed = run_tests(sources, args.compiler, f'-O{args.optimization}')
+    if failed:
+        print(f"FAILED: {' '.join(failed)}")
+        return 1
+    print("all tests passed")
+    return 0
+
+
+if __name__ == "__main__":
+    try:
+        sys.exit(main())
+    except TestError as err:
+        print(f"ERROR: {err}", file=sys.stderr)
+        sys.exit(2)
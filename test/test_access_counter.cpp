@@ -0,0 +1,45 @@
+/**
+ * Bus access counts of register access primitives
+ *
+ * Number of bus accesses is part of API of register primitives
+ * (set/clr of bit in register, modify() is single read and write).
+ */
+
+#include "io/host/access_counter.hpp"
+#include "io/reg/stm32/f0/gpio.hpp"
+#include "io/reg/stm32/f0/exti.hpp"
+#include "io/reg/stm32/f0/usart.hpp"
+#include "io/test/check.hpp"
+
+static void check_accesses(const io::host::Accesses accesses, const unsigned reads, const unsigned writes, const char *what) {
+    io::test::check_equal(accesses.reads, reads, what);
+    io::test::check_equal(accesses.writes, writes, what);
+}
+
+int main() {
+    // clear and set of 2 bit field, two read-modify-writes
+    check_accesses(io::host::count_accesses([] {
+        io::GPIOA.MODER.set(5, io::Gpio::Moder::Mode::OUTPUT);
+    }), 2, 2, "MODER.set");
+    io::test::check_equal(io::GPIOA.MODER.get(5), io::Gpio::Moder::Mode::OUTPUT, "MODER.get");
+
+    check_accesses(io::host::count_accesses([] {
+        io::EXTI.IMR.set(3);
+    }), 1, 1, "EXTI IMR.set");
+    io::test::check_equal(io::EXTI.IMR.r, 0x8, "EXTI IMR");
+
+    check_accesses(io::host::count_accesses([] {
+        io::USART1.CR1.modify([](io::Usart::Cr1 &cr1) {
+            cr1.b.TE = 1;
+            cr1.b.RE = 1;
+            cr1.b.UE = 1;
+        });
+    }), 1, 1, "CR1.modify");
+    io::test::check_equal(io::USART1.CR1.r, 0x0d, "CR1");
+
+    check_accesses(io::host::count_accesses([] {
+        io::GPIOA.BSRR.set(5);
+    }), 0, 1, "BSRR.set");
+
+    return io::test::result("access_counter");
+}
@@ -0,0 +1,97 @@
+/**
+ * DMA channel manager
+ *
+ * Allocation, CSELR routing and dispatch of shared interrupt vector,
+ * channel flags are set by test.
+ */
+
+#include <cstddef>
+
+#include "io/reg/stm32/f0/dma.hpp"
+#include "io/lib/stm32/f0/dma_manager.hpp"
+#include "io/test/check.hpp"
+
+static_assert(offsetof(io::Dma, CSELR) == 0xa8, "CSELR offset");
+
+struct Event {
+    unsigned count;
+    unsigned flags;
+};
+
+static Event events[8];
+
+static void callback(void *context, const unsigned flags) {
+    Event &event = *static_cast<Event *>(context);
+    event.count++;
+    event.flags = flags;
+}
+
+static uint32_t flags(const unsigned channel, const unsigned value) {
+    return value << ((channel - 1) << 2);
+}
+
+static void test_cselr() {
+    io::DMA1.CSELR.r = 0;
+    io::DMA1.CSELR.set(1, 0x3);
+    io::DMA1.CSELR.set(7, 0xb);
+    io::test::check_equal(io::DMA1.CSELR.r, 0x0b000003, "CSELR channels 1 and 7");
+    io::test::check_equal(io::DMA1.CSELR.get(1), 0x3, "get channel 1");
+    io::test::check_equal(io::DMA1.CSELR.get(7), 0xb, "get channel 7");
+    io::DMA1.CSELR.set(1, 0x5);
+    io::test::check_equal(io::DMA1.CSELR.r, 0x0b000005, "replace channel 1");
+    io::test::check_equal(io::DMA1.CSELR.read().b.C7S, 0xb, "C7S");
+}
+
+static void test_allocate() {
+    io::DmaManager dma(io::DMA1);
+    io::DMA1.CSELR.r = 0;
+    const unsigned ch = dma.allocate(io::DmaManager::mask(2, 4), 0x8, callback, &events[0]);
+    io::test::check_equal(ch, 2, "first free channel");
+    io::test::check_equal(io::DMA1.CSELR.get(2), 0x8, "request routed");
+    io::test::check_equal(dma.allocate(io::DmaManager::mask(2, 4), 0x9, callback, &events[1]), 4, "next free channel");
+    io::test::check_equal(dma.allocate(io::DmaManager::mask(2, 4), 0x9, callback, &events[2]), 0, "no free channel");
+    io::test::check_equal(io::DMA1.CSELR.r, 0x9080, "CSELR");
+    dma.release(2);
+    io::test::check(!dma.is_allocated(2) && dma.is_allocated(4), "released");
+
+    // channel without CSELR
+    io::DmaManager dma2(io::DMA2, 5);
+    io::DMA2.CSELR.r = 0;
+    io::test::check_equal(dma2.allocate(io::DmaManager::mask(6), io::DmaManager::NO_REQUEST, callback), 0, "channel above count");
+    io::test::check_equal(dma2.allocate(io::DmaManager::mask(5), io::DmaManager::NO_REQUEST, callback), 5, "fixed request");
+    io::test::check_equal(io::DMA2.CSELR.r, 0, "CSELR untouched");
+}
+
+static void test_dispatch() {
+    io::DmaManager dma(io::DMA1);
+    for (unsigned ch = 1; ch <= 7; ch++) dma.allocate(io::DmaManager::mask(ch), io::DmaManager::NO_REQUEST, callback, &events[ch]);
+    for (Event &event : events) event = {0, 0};
+
+    // channels 2 and 3 of shared vector pending (with GIF), channel 5 belongs to other vector
+    io::DMA1.ISR.r = flags(2, io::Dma::Ifcr::GIF | io::Dma::Ifcr::TCIF)
+        | flags(3, io::Dma::Ifcr::GIF | io::Dma::Ifcr::HTIF | io::Dma::Ifcr::TEIF)
+        | flags(5, io::Dma::Ifcr::GIF | io::Dma::Ifcr::TCIF);
+    io::DMA1.IFCR.r = 0;
+    dma.handle_isr(io::dma_vector::DMA1_CH2_3);
+    io::test::check(events[2].count == 1 && events[2].flags == io::Dma::Ifcr::TCIF, "channel 2");
+    io::test::check(events[3].count == 1 && events[3].flags == (io::Dma::Ifcr::HTIF | io::Dma::Ifcr::TEIF), "channel 3");
+    io::test::check_equal(events[5].count, 0, "other vector");
+
+    // GIF is not cleared, flags raised after read would be lost
+    io::test::check_equal(io::DMA1.IFCR.r, flags(2, io::Dma::Ifcr::TCIF) | flags(3, io::Dma::Ifcr::HTIF | io::Dma::Ifcr::TEIF), "read flags cleared");
+
+    // GIF alone is not event
+    io::DMA1.ISR.r = flags(4, io::Dma::Ifcr::GIF);
+    io::DMA1.IFCR.r = 0;
+    dma.handle_isr(io::dma_vector::DMA1_CH4_5_6_7);
+    io::test::check_equal(events[4].count, 0, "GIF only");
+    io::test::check_equal(io::DMA1.IFCR.r, 0, "nothing cleared");
+    io::DMA1.ISR.r = 0;
+}
+
+int main() {
+    test_cselr();
+    test_allocate();
+    test_dispatch();
+    return io::test::result("dma_manager");
+}
@@ -0,0 +1,127 @@
+/**
+ * Asynchronous memory copy and fill by DMA
+ *
+ * DMA channel programming (width, count, chaining) is checked, memory is
+ * not copied by simulated DMA, transfer complete is set by test. CPU
+ * path below threshold really copies.
+ */
+
+#include "io/reg/stm32/f0/dma.hpp"
+#include "io/lib/stm32/_common/dma_memory.hpp"
+#include "io/test/check.hpp"
+
+static const unsigned CHANNEL = 1;
+
+// DMA buffers (32 bit addresses)
+alignas(4) static uint8_t src[70004];
+alignas(4) static uint8_t dst[70004];
+
+// fill pattern is inside of instance, it must be static (32 bit address)
+static io::DmaMemory dma_memory(io::DMA1, CHANNEL);
+static io::DmaMemory dma_memory_always(io::DMA1, CHANNEL, 0);
+
+static unsigned done_count = 0;
+static bool done_ok = false;
+
+static void done(void *, const bool ok) {
+    done_count++;
+    done_ok = ok;
+}
+
+static void dma_interrupt(io::DmaMemory &memory, const unsigned flags=io::Dma::Ifcr::TCIF) {
+    io::DMA1.ISR.r = flags << ((CHANNEL - 1) << 2);
+    io::DMA1.IFCR.r = 0;
+    memory.handle_isr();
+    io::DMA1.ISR.r = 0;
+}
+
+/** Check channel setup of chunk
+ */
+static void check_chunk(const void *from, const void *to, const uint32_t count, const io::Dma::Channel::Ccr::Size size, const bool pinc, const char *what) {
+    io::Dma::Channel &ch = io::DMA1.CHANNEL(CHANNEL);
+    io::Dma::Channel::Ccr ccr = ch.CCR.read();
+    io::test::check(ccr.b.EN && ccr.b.MEM2MEM && ccr.b.MINC && !ccr.b.DIR, what);
+    io::test::check_equal(ccr.b.PINC, pinc, what);
+    io::test::check(ccr.PSIZE() == size && ccr.MSIZE() == size, what);
+    io::test::check_equal(ch.CPAR.r, reinterpret_cast<uintptr_t>(from), what);
+    io::test::check_equal(ch.CMAR.r, reinterpret_cast<uintptr_t>(to), what);
+    io::test::check_equal(ch.CNDTR.r, count, what);
+}
+
+static void test_width() {
+    using Size = io::Dma::Channel::Ccr::Size;
+    done_count = 0;
+    io::test::check(dma_memory.memcpy(dst, src, 256, done), "word copy");
+    check_chunk(src, dst, 64, Size::SIZE_32, true, "32 bit");
+    io::test::check(dma_memory.is_busy(), "busy");
+    io::test::check(!dma_memory.memcpy(dst, src, 256, done), "copy while busy");
+    dma_interrupt(dma_memory);
+    io::test::check(done_count == 1 && done_ok, "done");
+    io::test::check(!dma_memory.is_busy(), "not busy");
+    io::test::check_equal(io::DMA1.IFCR.r, io::Dma::Ifcr::TCIF << ((CHANNEL - 1) << 2), "only TCIF cleared");
+
+    dma_memory.memcpy(dst, src + 2, 258, done);
+    check_chunk(src + 2, dst, 129, Size::SIZE_16, true, "16 bit");
+    dma_interrupt(dma_memory);
+
+    dma_memory.memcpy(dst, src + 1, 256, done);
+    check_chunk(src + 1, dst, 256, Size::SIZE_8, true, "8 bit");
+    dma_interrupt(dma_memory, io::Dma::Ifcr::TEIF);
+    io::test::check(done_count == 3 && !done_ok, "transfer error");
+}
+
+static void test_chain() {
+    using Size = io::Dma::Channel::Ccr::Size;
+    done_count = 0;
+    dma_memory.memcpy(dst + 1, src + 1, 70000, done);
+    check_chunk(src + 1, dst + 1, 65535, Size::SIZE_8, true, "first chunk");
+    dma_interrupt(dma_memory);
+    io::test::check_equal(done_count, 0, "not done after first chunk");
+    check_chunk(src + 65536, dst + 65536, 4465, Size::SIZE_8, true, "last chunk");
+    dma_interrupt(dma_memory);
+    io::test::check(done_count == 1 && done_ok, "chain done");
+}
+
+static void test_memset() {
+    using Size = io::Dma::Channel::Ccr::Size;
+    done_count = 0;
+    dma_memory.memset(dst, 0x5a, 1024, done);
+    io::Dma::Channel &ch = io::DMA1.CHANNEL(CHANNEL);
+    const uint32_t *pattern = reinterpret_cast<const uint32_t *>(static_cast<uintptr_t>(ch.CPAR.r));
+    io::test::check_equal(*pattern, 0x5a5a5a5a, "pattern");
+    check_chunk(pattern, dst, 256, Size::SIZE_32, false, "fill");
+    dma_interrupt(dma_memory);
+    io::test::check_equal(done_count, 1, "fill done");
+}
+
+static void test_cpu() {
+    done_count = 0;
+    for (unsigned i = 0; i < 64; i++) src[i] = static_cast<uint8_t>(i + 1);
+    io::DMA1.CHANNEL(CHANNEL).CCR.r = 0;
+
+    // below threshold: copied by CPU before return
+    io::test::check(dma_memory.memcpy(dst + 1, src + 1, 40, done), "CPU copy");
+    io::test::check(done_count == 1 && done_ok && !dma_memory.is_busy(), "CPU copy done");
+    io::test::check_equal(io::DMA1.CHANNEL(CHANNEL).CCR.r, 0, "DMA not used");
+    bool equal = true;
+    for (unsigned i = 1; i <= 40; i++) equal = equal && dst[i] == src[i];
+    io::test::check(equal, "copied data");
+
+    dma_memory.memset(dst + 3, 0xa5, 7, done);
+    io::test::check(dst[2] == src[2] && dst[3] == 0xa5 && dst[9] == 0xa5 && dst[10] == src[10], "CPU fill");
+
+    // empty block with threshold 0 is done immediately, not by DMA
+    io::test::check(dma_memory_always.memcpy(dst, src, 0, done), "empty copy");
+    io::test::check(dma_memory_always.memset(dst, 0, 0, done), "empty fill");
+    io::test::check_equal(done_count, 4, "empty done");
+    io::test::check(!dma_memory_always.is_busy(), "not busy after empty");
+    io::test::check_equal(io::DMA1.CHANNEL(CHANNEL).CCR.r, 0, "no DMA for empty");
+}
+
+int main() {
+    test_width();
+    test_chain();
+    test_memset();
+    test_cpu();
+    return io::test::result("dma_memory");
+}
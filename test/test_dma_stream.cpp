@@ -0,0 +1,114 @@
+/**
+ * Circular DMA double buffer stream
+ *
+ * DMA position (CNDTR) and channel flags are set by test, handed halves,
+ * release and overrun accounting are checked.
+ */
+
+#include "io/reg/stm32/f0/adc.hpp"
+#include "io/reg/stm32/f0/dma.hpp"
+#include "io/lib/stm32/_common/dma_stream.hpp"
+#include "io/test/check.hpp"
+
+static const unsigned CHANNEL = 1;
+static const size_t COUNT = 16;
+static const size_t HALF = COUNT / 2;
+
+typedef io::DmaStream<uint16_t> Stream;
+
+// DMA buffer (32 bit address)
+static uint16_t samples[COUNT];
+
+static uint16_t *ready_data = nullptr;
+static size_t ready_count = 0;
+static unsigned ready_calls = 0;
+
+static void ready(void *, uint16_t *data, const size_t count) {
+    ready_data = data;
+    ready_count = count;
+    ready_calls++;
+}
+
+/** Raise channel flags with DMA at position
+ * @param cndtr remaining transfers (COUNT: first half, HALF: second half)
+ */
+static void dma_interrupt(Stream &stream, const unsigned flags, const uint32_t cndtr) {
+    io::DMA1.CHANNEL(CHANNEL).CNDTR.r = cndtr;
+    io::DMA1.ISR.r = flags << ((CHANNEL - 1) << 2);
+    io::DMA1.IFCR.r = 0;
+    stream.handle_isr();
+    io::DMA1.ISR.r = 0;
+}
+
+static void test_start() {
+    Stream stream(io::DMA1, CHANNEL);
+    stream.start(&io::ADC.DR, samples, COUNT, Stream::Direction::RX, ready);
+    io::Dma::Channel &ch = io::DMA1.CHANNEL(CHANNEL);
+    io::Dma::Channel::Ccr ccr = ch.CCR.read();
+    io::test::check(ccr.b.EN && ccr.b.CIRC && ccr.b.MINC && !ccr.b.DIR, "CCR");
+    io::test::check(ccr.b.HTIE && ccr.b.TCIE && ccr.b.TEIE, "interrupts");
+    io::test::check(ccr.PSIZE() == io::Dma::Channel::Ccr::Size::SIZE_16 && ccr.MSIZE() == io::Dma::Channel::Ccr::Size::SIZE_16, "16 bit");
+    io::test::check_equal(ch.CPAR.r, reinterpret_cast<uintptr_t>(&io::ADC.DR), "CPAR");
+    io::test::check_equal(ch.CMAR.r, reinterpret_cast<uintptr_t>(samples), "CMAR");
+    io::test::check_equal(ch.CNDTR.r, COUNT, "CNDTR");
+    io::test::check(stream.is_running(), "running");
+    stream.stop();
+    io::test::check(!stream.is_running(), "stopped");
+}
+
+static void test_halves() {
+    Stream stream(io::DMA1, CHANNEL);
+    stream.start(&io::ADC.DR, samples, COUNT, Stream::Direction::RX, ready);
+
+    // HT: first half is complete, DMA is in second half
+    dma_interrupt(stream, io::Dma::Ifcr::HTIF, HALF);
+    io::test::check(ready_data == samples && ready_count == HALF, "first half");
+    io::test::check_equal(io::DMA1.IFCR.r, io::Dma::Ifcr::HTIF << ((CHANNEL - 1) << 2), "only HTIF cleared");
+    stream.release(ready_data);
+
+    // TC: second half is complete, DMA wrapped to first half
+    dma_interrupt(stream, io::Dma::Ifcr::TCIF, COUNT);
+    io::test::check(ready_data == samples + HALF && ready_count == HALF, "second half");
+    stream.release(ready_data);
+    io::test::check_equal(stream.overruns(), 0, "no overrun");
+
+    // first half is held when DMA enters it again
+    dma_interrupt(stream, io::Dma::Ifcr::HTIF, HALF);
+    dma_interrupt(stream, io::Dma::Ifcr::TCIF, COUNT);
+    io::test::check_equal(stream.overruns(), 1, "held half re-entered");
+    io::test::check(ready_data == samples + HALF, "newest half handed");
+    stream.release(samples);
+    stream.release(samples + HALF);
+
+    // both flags at once: one half was lost by interrupt latency
+    dma_interrupt(stream, io::Dma::Ifcr::HTIF | io::Dma::Ifcr::TCIF, HALF);
+    io::test::check_equal(stream.overruns(), 2, "lost half");
+    io::test::check(ready_data == samples, "newest half after latency");
+    stream.release(ready_data);
+
+    // transfer error stops stream
+    const unsigned calls = ready_calls;
+    dma_interrupt(stream, io::Dma::Ifcr::TEIF, HALF);
+    io::test::check(!stream.is_running(), "stopped by error");
+    io::test::check_equal(ready_calls, calls, "no half on error");
+}
+
+static void test_polling() {
+    Stream stream(io::DMA1, CHANNEL);
+    stream.start(&io::ADC.DR, samples, COUNT, Stream::Direction::RX);
+    uint16_t *data = nullptr;
+    io::test::check_equal(stream.take(data), 0, "nothing to take");
+    dma_interrupt(stream, io::Dma::Ifcr::HTIF, HALF);
+    io::test::check_equal(stream.take(data), HALF, "take");
+    io::test::check(data == samples, "taken half");
+    io::test::check_equal(stream.take(data), 0, "taken once");
+    stream.release(data);
+    stream.stop();
+}
+
+int main() {
+    test_start();
+    test_halves();
+    test_polling();
+    return io::test::result("dma_stream");
+}
@@ -0,0 +1,163 @@
+/**
+ * I2C master transactions
+ *
+ * CR2 (address, direction, NBYTES, RELOAD, AUTOEND) and DMA setup are
+ * checked for each phase, I2C flags are set by test.
+ */
+
+#include "io/reg/stm32/f0/i2c.hpp"
+#include "io/reg/stm32/f0/dma.hpp"
+#include "io/lib/stm32/_common/i2c_master.hpp"
+#include "io/test/check.hpp"
+
+static const unsigned RX_CHANNEL = 3;
+static const unsigned TX_CHANNEL = 2;
+static const uint32_t TXE = 0x01;
+static const uint32_t NACKF = 0x10;
+static const uint32_t STOPF = 0x20;
+static const uint32_t TC = 0x40;
+static const uint32_t TCR = 0x80;
+static const uint32_t BERR = 0x100;
+static const uint32_t ARLO = 0x200;
+static const uint32_t TIMEOUT = 0x1000;
+static const uint8_t ADDRESS = 0x50;
+
+static uint8_t tx_data[4] = {0x10, 0x11, 0x12, 0x13};
+static uint8_t rx_data[600];
+
+static unsigned done_count = 0;
+static io::I2cMaster::Status done_status = io::I2cMaster::Status::OK;
+
+static void done(void *, const io::I2cMaster::Status status) {
+    done_count++;
+    done_status = status;
+}
+
+static void interrupt(io::I2cMaster &i2c, const uint32_t flags) {
+    io::I2C1.ISR.r = flags;
+    io::I2C1.ICR.r = 0;
+    i2c.handle_isr();
+}
+
+/** Check CR2 of phase
+ */
+static void check_cr2(const bool read, const uint32_t nbytes, const bool reload, const bool autoend, const char *what) {
+    const io::I2c::Cr2 cr2 = io::I2C1.CR2.read();
+    io::test::check_equal(cr2.b.SADD, ADDRESS << 1, what);
+    io::test::check_equal(cr2.b.RD_WRN, read, what);
+    io::test::check_equal(cr2.b.NBYTES, nbytes, what);
+    io::test::check_equal(cr2.b.RELOAD, reload, what);
+    io::test::check_equal(cr2.b.AUTOEND, autoend, what);
+}
+
+static void check_channel(const unsigned channel, const void *memory, const size_t size, const char *what) {
+    io::Dma::Channel &ch = io::DMA1.CHANNEL(channel);
+    io::test::check(ch.CCR.read().b.EN, what);
+    io::test::check_equal(ch.CCR.read().b.DIR, channel == TX_CHANNEL, what);
+    io::test::check_equal(ch.CMAR.r, reinterpret_cast<uintptr_t>(memory), what);
+    io::test::check_equal(ch.CNDTR.r, size, what);
+}
+
+static void test_configure() {
+    io::I2cMaster i2c(io::I2C1, io::DMA1, RX_CHANNEL, TX_CHANNEL);
+    i2c.configure(0x00201d2b);
+    io::test::check_equal(io::I2C1.TIMINGR.r, 0x00201d2b, "TIMINGR");
+    const io::I2c::Cr1 cr1 = io::I2C1.CR1.read();
+    io::test::check(cr1.b.NACKIE && cr1.b.STOPIE && cr1.b.TCIE && cr1.b.ERRIE, "interrupts");
+    io::test::check(cr1.b.TXDMAEN && cr1.b.RXDMAEN && cr1.b.PE, "DMA and PE");
+}
+
+static void test_write() {
+    io::I2cMaster i2c(io::I2C1, io::DMA1, RX_CHANNEL, TX_CHANNEL);
+    done_count = 0;
+    io::test::check(i2c.write(ADDRESS, tx_data, sizeof(tx_data), done), "write");
+    check_cr2(false, sizeof(tx_data), false, true, "write CR2");
+    check_channel(TX_CHANNEL, tx_data, sizeof(tx_data), "write TX");
+    io::test::check(!i2c.write(ADDRESS, tx_data, 1, done), "write while busy");
+
+    interrupt(i2c, STOPF);
+    io::test::check_equal(io::I2C1.ICR.r, STOPF, "STOPF cleared");
+    io::test::check_equal(done_count, 1, "write done");
+    io::test::check(done_status == io::I2cMaster::Status::OK, "write OK");
+    io::test::check(!i2c.is_busy(), "not busy");
+    io::test::check_equal(io::DMA1.CHANNEL(TX_CHANNEL).CCR.r, 0, "TX channel disabled");
+
+    // address only
+    io::test::check(i2c.write(ADDRESS, nullptr, 0, done), "address only");
+    check_cr2(false, 0, false, true, "address only CR2");
+    interrupt(i2c, STOPF);
+
+    // NACK with automatic STOP, TXDR is flushed
+    i2c.write(ADDRESS, tx_data, sizeof(tx_data), done);
+    interrupt(i2c, NACKF);
+    io::test::check_equal(io::I2C1.ICR.r, NACKF, "NACKF cleared");
+    io::test::check(i2c.is_busy(), "busy until STOPF");
+    io::I2C1.ISR.r = 0;
+    interrupt(i2c, STOPF);
+    io::test::check(done_status == io::I2cMaster::Status::NACK, "NACK");
+    io::test::check_equal(io::I2C1.ISR.r & TXE, TXE, "TXDR flushed");
+}
+
+static void test_read() {
+    io::I2cMaster i2c(io::I2C1, io::DMA1, RX_CHANNEL, TX_CHANNEL);
+    done_count = 0;
+    io::test::check(!i2c.read(ADDRESS, rx_data, 0, done), "read nothing");
+
+    // register read: write phase without AUTOEND, repeated start on TC
+    io::test::check(i2c.write_read(ADDRESS, tx_data, 1, rx_data, 10, done), "write_read");
+    check_cr2(false, 1, false, false, "write phase CR2");
+    check_channel(TX_CHANNEL, tx_data, 1, "write phase TX");
+    check_channel(RX_CHANNEL, rx_data, 10, "read phase RX");
+    interrupt(i2c, TC);
+    check_cr2(true, 10, false, true, "read phase CR2");
+    io::test::check(io::I2C1.CR2.read().b.START, "repeated start");
+    interrupt(i2c, STOPF);
+    io::test::check_equal(done_count, 1, "write_read done");
+
+    // TC of last phase is not repeated
+    i2c.read(ADDRESS, rx_data, 10, done);
+    io::I2C1.CR2.modify([](io::I2c::Cr2 &cr2) { cr2.b.START = 0; });
+    interrupt(i2c, TC);
+    io::test::check(!io::I2C1.CR2.read().b.START, "no start after last phase");
+    interrupt(i2c, STOPF);
+
+    // long read: 255 + 255 + 90 bytes
+    i2c.read(ADDRESS, rx_data, sizeof(rx_data), done);
+    check_cr2(true, 255, true, false, "first chunk");
+    interrupt(i2c, TCR);
+    check_cr2(true, 255, true, false, "second chunk");
+    io::test::check(!io::I2C1.CR2.read().b.START, "no start on reload");
+    interrupt(i2c, TCR);
+    check_cr2(true, 90, false, true, "last chunk");
+    interrupt(i2c, STOPF);
+    io::test::check_equal(done_count, 3, "long read done");
+}
+
+static void test_errors() {
+    io::I2cMaster i2c(io::I2C1, io::DMA1, RX_CHANNEL, TX_CHANNEL);
+    i2c.configure(0x00201d2b);
+
+    i2c.write(ADDRESS, tx_data, sizeof(tx_data), done);
+    interrupt(i2c, ARLO | TC);
+    io::test::check_equal(io::I2C1.ICR.r, ARLO, "ARLO cleared");
+    io::test::check(done_status == io::I2cMaster::Status::ARBITRATION_LOST, "arbitration lost");
+    io::test::check(io::I2C1.CR1.read().b.PE, "PE after reset");
+    io::test::check(!i2c.is_busy(), "aborted");
+
+    i2c.read(ADDRESS, rx_data, 10, done);
+    interrupt(i2c, TIMEOUT);
+    io::test::check(done_status == io::I2cMaster::Status::TIMEOUT, "timeout");
+
+    i2c.read(ADDRESS, rx_data, 10, done);
+    interrupt(i2c, BERR);
+    io::test::check(done_status == io::I2cMaster::Status::BUS_ERROR, "bus error");
+    io::test::check_equal(io::DMA1.CHANNEL(RX_CHANNEL).CCR.r, 0, "RX channel disabled");
+}
+
+int main() {
+    test_configure();
+    test_write();
+    test_read();
+    test_errors();
+    return io::test::result("i2c_master");
+}
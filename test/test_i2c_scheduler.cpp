@@ -0,0 +1,114 @@
+/**
+ * Batched I2C read scheduler
+ *
+ * Reads are completed by STOPF set by test, device of each started read
+ * (CR2 SADD, pointer in TX channel) and snapshot masks are checked.
+ */
+
+#include "io/reg/stm32/f0/i2c.hpp"
+#include "io/reg/stm32/f0/dma.hpp"
+#include "io/lib/stm32/_common/i2c_scheduler.hpp"
+#include "io/test/check.hpp"
+
+static const unsigned RX_CHANNEL = 3;
+static const unsigned TX_CHANNEL = 2;
+static const uint32_t NACKF = 0x10;
+static const uint32_t STOPF = 0x20;
+
+typedef io::I2cScheduler<3> Scheduler;
+
+// register pointer and data are moved by DMA (32 bit addresses)
+static uint8_t accel_data[6];
+static uint8_t mag_data[6];
+static uint8_t baro_data[3];
+static Scheduler::Read accel = {0x6a, 0x28, accel_data, sizeof(accel_data), 0};  // period 0 is every cycle
+static Scheduler::Read mag = {0x1e, 0x68, mag_data, sizeof(mag_data), 2};
+static Scheduler::Read baro = {0x76, 0xf7, baro_data, sizeof(baro_data), 4};
+
+static io::I2cMaster i2c(io::I2C1, io::DMA1, RX_CHANNEL, TX_CHANNEL);
+
+static unsigned snapshots = 0;
+static Scheduler::Snapshot last = {0, 0, 0, 0};
+
+static void snapshot(void *, const Scheduler::Snapshot &s) {
+    snapshots++;
+    last = s;
+}
+
+/** Check started read and complete it
+ */
+static void complete(const Scheduler::Read &read, const uint32_t flags, const char *what) {
+    io::test::check_equal(io::I2C1.CR2.read().b.SADD, read.address << 1, what);
+    io::test::check_equal(io::DMA1.CHANNEL(TX_CHANNEL).CMAR.r, reinterpret_cast<uintptr_t>(&read.reg), what);
+    io::test::check_equal(io::DMA1.CHANNEL(RX_CHANNEL).CMAR.r, reinterpret_cast<uintptr_t>(read.data), what);
+    io::test::check_equal(io::DMA1.CHANNEL(RX_CHANNEL).CNDTR.r, read.size, what);
+    io::I2C1.ISR.r = flags;
+    i2c.handle_isr();
+}
+
+static void test_cycles() {
+    Scheduler scheduler(i2c, snapshot);
+    io::test::check(scheduler.add(accel) && scheduler.add(mag) && scheduler.add(baro), "add");
+    io::test::check(!scheduler.add(accel), "add above MAX");
+
+    // cycle 0: all reads are due, one after another
+    io::test::check(scheduler.cycle(1000), "cycle 0");
+    io::test::check(scheduler.is_busy(), "busy");
+    complete(accel, STOPF, "cycle 0 accel");
+    complete(mag, STOPF, "cycle 0 mag");
+    io::test::check_equal(snapshots, 0, "snapshot after last read");
+    complete(baro, STOPF, "cycle 0 baro");
+    io::test::check_equal(snapshots, 1, "cycle 0 snapshot");
+    io::test::check(last.timestamp == 1000 && last.cycle == 0, "cycle 0 timestamp");
+    io::test::check_equal(last.read, 0x7, "cycle 0 reads");
+    io::test::check_equal(last.failed, 0, "cycle 0 failed");
+    io::test::check(!scheduler.is_busy(), "not busy");
+
+    // cycle 1: accel only
+    scheduler.cycle(2000);
+    complete(accel, STOPF, "cycle 1 accel");
+    io::test::check(last.timestamp == 2000 && last.cycle == 1, "cycle 1 timestamp");
+    io::test::check_equal(last.read, 0x1, "cycle 1 reads");
+
+    // cycle 2: accel and mag, mag is not acknowledged
+    scheduler.cycle(3000);
+    io::test::check(!scheduler.add(baro), "add while busy");
+    complete(accel, STOPF, "cycle 2 accel");
+    io::test::check(!scheduler.cycle(3500), "overrun");
+    io::test::check_equal(scheduler.overruns(), 1, "overruns");
+    complete(mag, NACKF | STOPF, "cycle 2 mag");
+    io::test::check_equal(snapshots, 3, "overrun is skipped");
+    io::test::check_equal(last.read, 0x3, "cycle 2 reads");
+    io::test::check_equal(last.failed, 0x2, "cycle 2 failed");
+
+    // cycle 3 and 4: baro again in cycle 4
+    scheduler.cycle(4000);
+    complete(accel, STOPF, "cycle 3 accel");
+    io::test::check_equal(last.read, 0x1, "cycle 3 reads");
+    scheduler.cycle(5000);
+    complete(accel, STOPF, "cycle 4 accel");
+    complete(mag, STOPF, "cycle 4 mag");
+    complete(baro, STOPF, "cycle 4 baro");
+    io::test::check(last.cycle == 4 && last.read == 0x7 && last.failed == 0, "cycle 4");
+}
+
+static void test_busy_master() {
+    Scheduler scheduler(i2c, snapshot);
+    scheduler.add(accel);
+
+    // I2C is used by other driver, read fails and cycle ends immediately
+    static const uint8_t byte = 0;
+    i2c.write(0x10, &byte, 1);
+    snapshots = 0;
+    io::test::check(scheduler.cycle(6000), "cycle with busy master");
+    io::test::check_equal(snapshots, 1, "snapshot without read");
+    io::test::check(last.read == 0x1 && last.failed == 0x1, "read failed");
+    io::I2C1.ISR.r = STOPF;
+    i2c.handle_isr();
+}
+
+int main() {
+    test_cycles();
+    test_busy_master();
+    return io::test::result("i2c_scheduler");
+}
@@ -0,0 +1,188 @@
+/**
+ * I2C slave register file
+ *
+ * Master transactions are simulated by I2C flags, ADDCODE, RXDR and DMA
+ * position set by test, DMA setup and written callbacks are checked.
+ */
+
+#include "io/reg/stm32/f0/i2c.hpp"
+#include "io/reg/stm32/f0/dma.hpp"
+#include "io/lib/stm32/_common/i2c_slave.hpp"
+#include "io/test/check.hpp"
+
+static const unsigned RX_CHANNEL = 3;
+static const unsigned TX_CHANNEL = 2;
+static const uint32_t TXE = 0x01;
+static const uint32_t TXIS = 0x02;
+static const uint32_t RXNE = 0x04;
+static const uint32_t ADDR = 0x08;
+static const uint32_t STOPF = 0x20;
+static const uint32_t OVR = 0x400;
+static const uint32_t DIR = 0x10000;
+static const uint8_t ADDRESS1 = 0x20;
+static const uint8_t ADDRESS2 = 0x40;
+
+static uint8_t regs[2][8];
+
+static uint8_t selected = 0;
+static unsigned written_count = 0;
+static uint8_t written_address = 0;
+static size_t written_offset = 0;
+static size_t written_size = 0;
+
+static io::I2cSlave::File select(void *, const uint8_t address) {
+    selected = address;
+    return {regs[address == ADDRESS1 ? 0 : 1], sizeof(regs[0])};
+}
+
+static void written(void *, const uint8_t address, const size_t offset, const size_t size) {
+    written_count++;
+    written_address = address;
+    written_offset = offset;
+    written_size = size;
+}
+
+static void interrupt(io::I2cSlave &slave, const uint32_t flags) {
+    io::I2C1.ISR.r = flags;
+    io::I2C1.ICR.r = 0;
+    slave.handle_isr();
+}
+
+/** Address match, ADDCODE is 7 bit address
+ */
+static void address(io::I2cSlave &slave, const uint8_t addr, const bool read) {
+    interrupt(slave, ADDR | (read ? DIR : 0) | (static_cast<uint32_t>(addr) << 17));
+}
+
+/** Byte received by CPU (pointer or beyond end of file)
+ */
+static void receive(io::I2cSlave &slave, const uint8_t data) {
+    io::I2C1.RXDR.r = data;
+    interrupt(slave, RXNE);
+}
+
+/** DMA channel transfer complete
+ */
+static void dma_complete(io::I2cSlave &slave, const unsigned channel) {
+    io::DMA1.ISR.r = io::Dma::Ifcr::TCIF << ((channel - 1) << 2);
+    io::DMA1.IFCR.r = 0;
+    slave.handle_dma_isr();
+    io::DMA1.ISR.r = 0;
+    io::test::check_equal(io::DMA1.IFCR.r, io::Dma::Ifcr::TCIF << ((channel - 1) << 2), "only TCIF cleared");
+}
+
+static void check_channel(const unsigned channel, const void *memory, const size_t size, const char *what) {
+    io::Dma::Channel &ch = io::DMA1.CHANNEL(channel);
+    io::test::check(ch.CCR.read().b.EN, what);
+    io::test::check_equal(ch.CCR.read().b.DIR, channel == TX_CHANNEL, what);
+    io::test::check_equal(ch.CMAR.r, reinterpret_cast<uintptr_t>(memory), what);
+    io::test::check_equal(ch.CNDTR.r, size, what);
+}
+
+static void test_configure() {
+    io::I2cSlave slave(io::I2C1, io::DMA1, RX_CHANNEL, TX_CHANNEL);
+    slave.configure(ADDRESS1, ADDRESS2, 2);
+    io::test::check_equal(io::I2C1.OAR1.r, 0x8040, "OAR1");
+    io::test::check_equal(io::I2C1.OAR2.r, 0x8280, "OAR2");
+    slave.start(select, written);
+    const io::I2c::Cr1 cr1 = io::I2C1.CR1.read();
+    io::test::check(cr1.b.ADDRIE && cr1.b.STOPIE && cr1.b.NACKIE && cr1.b.ERRIE, "interrupts");
+    io::test::check(cr1.b.TXDMAEN && cr1.b.RXDMAEN && cr1.b.PE && !cr1.b.NOSTRETCH, "DMA and PE");
+}
+
+static void test_write() {
+    io::I2cSlave slave(io::I2C1, io::DMA1, RX_CHANNEL, TX_CHANNEL);
+    slave.start(select, written);
+    written_count = 0;
+
+    // [addr W] [pointer 2] [3 bytes by DMA] [P]
+    address(slave, ADDRESS1, false);
+    io::test::check_equal(selected, ADDRESS1, "selected");
+    io::test::check_equal(io::I2C1.ICR.r, ADDR, "ADDR cleared");
+    io::test::check(io::I2C1.CR1.read().b.RXIE, "pointer by CPU");
+    receive(slave, 2);
+    io::test::check(!io::I2C1.CR1.read().b.RXIE, "data by DMA");
+    check_channel(RX_CHANNEL, regs[0] + 2, 6, "RX from pointer");
+    io::DMA1.CHANNEL(RX_CHANNEL).CNDTR.r = 3;
+    interrupt(slave, STOPF);
+    io::test::check_equal(io::I2C1.ICR.r, STOPF, "STOPF cleared");
+    io::test::check_equal(written_count, 1, "written");
+    io::test::check(written_address == ADDRESS1 && written_offset == 2 && written_size == 3, "written range");
+    io::test::check_equal(io::DMA1.CHANNEL(RX_CHANNEL).CCR.r, 0, "RX channel disabled");
+
+    // register file full, rest is discarded
+    address(slave, ADDRESS2 + 3, false);
+    io::test::check_equal(selected, ADDRESS2 + 3, "address 2 with mask");
+    receive(slave, 4);
+    check_channel(RX_CHANNEL, regs[1] + 4, 4, "RX second file");
+    dma_complete(slave, RX_CHANNEL);
+    io::test::check(io::I2C1.CR1.read().b.RXIE, "discard by CPU");
+    receive(slave, 0x55);
+    interrupt(slave, STOPF);
+    io::test::check(written_offset == 4 && written_size == 4, "written until end of file");
+
+    // pointer beyond end of file
+    address(slave, ADDRESS1, false);
+    receive(slave, 100);
+    io::test::check_equal(io::DMA1.CHANNEL(RX_CHANNEL).CCR.r, 0, "no DMA beyond file");
+    receive(slave, 0x55);
+    interrupt(slave, STOPF);
+    io::test::check_equal(written_count, 2, "nothing written beyond file");
+
+    // bus errors
+    interrupt(slave, OVR);
+    io::test::check_equal(io::I2C1.ICR.r, OVR, "OVR cleared");
+    io::test::check_equal(slave.errors(), 1, "error");
+}
+
+static void test_read() {
+    io::I2cSlave slave(io::I2C1, io::DMA1, RX_CHANNEL, TX_CHANNEL);
+    slave.start(select, written);
+    written_count = 0;
+
+    // [addr W] [pointer 3] [Sr] [addr R] [data by DMA ..] [P]
+    address(slave, ADDRESS1, false);
+    receive(slave, 3);
+    io::I2C1.ISR.r = 0;
+    address(slave, ADDRESS1, true);
+    io::test::check_equal(io::I2C1.ISR.r & TXE, TXE, "TXDR flushed");
+    check_channel(TX_CHANNEL, regs[0] + 3, 5, "TX from pointer");
+    io::test::check_equal(io::DMA1.CHANNEL(RX_CHANNEL).CCR.r, 0, "RX channel stopped by repeated start");
+    io::test::check_equal(written_count, 0, "pointer is not write");
+
+    // end of register file, 0xff is sent
+    dma_complete(slave, TX_CHANNEL);
+    io::test::check(io::I2C1.CR1.read().b.TXIE, "fill by CPU");
+    io::I2C1.TXDR.r = 0;
+    interrupt(slave, TXIS);
+    io::test::check_equal(io::I2C1.TXDR.r, 0xff, "fill byte");
+    interrupt(slave, STOPF);
+    io::test::check(!io::I2C1.CR1.read().b.TXIE, "fill stopped");
+
+    // read without pointer continues from last pointer
+    address(slave, ADDRESS1, true);
+    check_channel(TX_CHANNEL, regs[0] + 3, 5, "TX from last pointer");
+    interrupt(slave, STOPF);
+    io::test::check_equal(written_count, 0, "read is not write");
+
+    // pointer is kept per address, other addresses of OAR2 range are not moved
+    address(slave, ADDRESS2 + 1, false);
+    receive(slave, 6);
+    interrupt(slave, STOPF);
+    address(slave, ADDRESS2 + 2, true);
+    check_channel(TX_CHANNEL, regs[1], 8, "TX of other address from 0");
+    interrupt(slave, STOPF);
+    address(slave, ADDRESS2 + 1, true);
+    check_channel(TX_CHANNEL, regs[1] + 6, 2, "TX of address from its pointer");
+    interrupt(slave, STOPF);
+    address(slave, ADDRESS1, true);
+    check_channel(TX_CHANNEL, regs[0] + 3, 5, "TX of address 1 not moved");
+    interrupt(slave, STOPF);
+}
+
+int main() {
+    test_configure();
+    test_write();
+    test_read();
+    return io::test::result("i2c_slave");
+}
@@ -0,0 +1,66 @@
+/**
+ * I2C timing
+ *
+ * Solved TIMINGR values are compared with values checked by hand against
+ * I2C specification limits and reference manual formulas, real speed is
+ * never above requested speed.
+ */
+
+#include "io/reg/stm32/f0/i2c.hpp"
+#include "io/lib/stm32/_common/i2c_timing.hpp"
+#include "io/test/check.hpp"
+
+// Standard-mode: PRESC 1, SCLDEL 8, SDADEL 0, SCLH 0x6b, SCLL 0x7c
+typedef io::I2cTiming<48000000, 100000> Standard48M;
+static_assert(Standard48M::timingr == 0x10806b7c && Standard48M::speed == 99984, "48 MHz 100 kHz");
+
+typedef io::I2cTiming<8000000, 100000> Standard8M;
+static_assert(Standard8M::timingr == 0x00202128 && Standard8M::speed == 99157, "8 MHz 100 kHz");
+
+// Fast-mode
+typedef io::I2cTiming<48000000, 400000> Fast48M;
+static_assert(Fast48M::timingr == 0x00902345 && Fast48M::speed == 399739 && Fast48M::error_ppm == 653, "48 MHz 400 kHz");
+
+typedef io::I2cTiming<16000000, 400000> Fast16M;
+static_assert(Fast16M::timingr == 0x00300a15 && Fast16M::speed == 396432, "16 MHz 400 kHz");
+
+// slow edges do not fit into period, real speed is below default tolerance
+typedef io::I2cTiming<48000000, 400000, 300, 300, 100000> FastSlowEdges;
+static_assert(FastSlowEdges::timingr == 0x10950e1f && FastSlowEdges::speed == 364745, "48 MHz 400 kHz slow edges");
+static_assert(io::i2c_timing::error_ppm(400000, FastSlowEdges::speed) > 50000, "slow edges error");
+
+// Fast-mode Plus
+typedef io::I2cTiming<64000000, 1000000> FastPlus64M;
+static_assert(FastPlus64M::timingr == 0x0090101f && FastPlus64M::speed == 963275, "64 MHz 1 MHz");
+
+// low kernel clock: SCL low/high minimums give 630 kHz, 713 kHz
+static_assert(io::i2c_timing::solve(8000000, 1000000, 100, 10).speed == 630914, "8 MHz 1 MHz");
+static_assert(io::i2c_timing::error_ppm(1000000, io::i2c_timing::solve(16000000, 1000000, 120, 120).speed) == 286988, "16 MHz 1 MHz error");
+
+static void test_configure() {
+    io::I2C1.TIMINGR.r = 0;
+    Fast48M::configure(io::I2C1);
+    io::test::check_equal(io::I2C1.TIMINGR.r, 0x00902345, "TIMINGR");
+    const io::I2c::Timingr timingr = io::I2C1.TIMINGR.read();
+    io::test::check_equal(timingr.b.SCLL, 0x45, "SCLL");
+    io::test::check_equal(timingr.b.SCLH, 0x23, "SCLH");
+    io::test::check_equal(timingr.b.SCLDEL, 9, "SCLDEL");
+}
+
+static void test_speed() {
+    // never faster than requested for any clock
+    for (uint32_t clock = 8000000; clock <= 72000000; clock += 4000000) {
+        static const uint32_t speeds[] = {10000, 100000, 400000, 1000000};
+        for (const uint32_t speed : speeds) {
+            const io::i2c_timing::Result result = io::i2c_timing::solve(clock, speed, 100, 10);
+            if (!io::test::check(result.valid, "valid")) continue;
+            io::test::check(result.speed <= speed, "not faster than requested");
+        }
+    }
+}
+
+int main() {
+    test_configure();
+    test_speed();
+    return io::test::result("i2c_timing");
+}
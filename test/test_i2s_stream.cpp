@@ -0,0 +1,112 @@
+/**
+ * I2S audio stream
+ *
+ * Prescaler values are compared with values computed by hand from
+ * reference manual formula, start and stop are checked on registers
+ * with status flags set by test.
+ */
+
+#include "io/reg/stm32/_common/spi_v1.hpp"
+#include "io/reg/stm32/f0/dma.hpp"
+#include "io/lib/stm32/_common/i2s_stream.hpp"
+#include "io/test/check.hpp"
+
+// SPI v1 has no peripheral definition file, SPI2 of F1
+static io::Spi &SPI2 = *reinterpret_cast<io::Spi *>(0x40003800);
+
+static const unsigned CHANNEL = 4;
+static const uint32_t RXNE = 0x01;
+static const uint32_t TXE = 0x02;
+
+// 86 MHz / (64 * 28) = 47991 Hz
+typedef io::I2sPrescaler<86000000, 48000, 32> Prescaler48k;
+static_assert(Prescaler48k::divider == 28 && Prescaler48k::i2spr == 0x0e, "48 kHz I2SPR");
+static_assert(Prescaler48k::actual == 47991 && Prescaler48k::error_ppm == 188, "48 kHz error");
+
+// odd divider: 72 MHz / (32 * 281) = 8007 Hz
+typedef io::I2sPrescaler<72000000, 8000, 16> Prescaler8k;
+static_assert(Prescaler8k::divider == 281 && Prescaler8k::i2spr == 0x18c, "8 kHz I2SPR");
+
+// master clock output: 98.304 MHz / (256 * 8) = 48 kHz
+typedef io::I2sPrescaler<98304000, 48000, 16, true> PrescalerMck;
+static_assert(PrescalerMck::divider == 8 && PrescalerMck::i2spr == 0x204 && PrescalerMck::error_ppm == 0, "MCK I2SPR");
+
+static uint16_t buffer[16];
+static uint16_t *ready_data = nullptr;
+static size_t ready_count = 0;
+
+static void ready(void *, uint16_t *data, const size_t count) {
+    ready_data = data;
+    ready_count = count;
+}
+
+static void test_transmit() {
+    io::I2sStream i2s(SPI2, io::DMA1, CHANNEL);
+    i2s.configure<Prescaler48k>(io::Spi::I2scfgr::I2scfg::MASTER_TX, io::Spi::I2scfgr::Datalen::DATALEN_24);
+    io::test::check_equal(SPI2.I2SPR.r, 0x0e, "I2SPR");
+    const io::Spi::I2scfgr cfg = SPI2.I2SCFGR.read();
+    io::test::check(cfg.b.I2SMOD && cfg.b.CHLEN && !cfg.b.I2SE, "I2SCFGR");
+    io::test::check_equal(cfg.b.DATLEN, io::Spi::I2scfgr::Datalen::DATALEN_24, "DATLEN");
+
+    io::test::check(!i2s.start(buffer, 6, ready), "count not multiple of 4");
+    io::test::check(i2s.start(buffer, 16, ready), "start");
+    io::Dma::Channel &ch = io::DMA1.CHANNEL(CHANNEL);
+    io::test::check(ch.CCR.read().b.EN && ch.CCR.read().b.DIR && ch.CCR.read().b.CIRC, "TX circular DMA");
+    io::test::check_equal(ch.CMAR.r, reinterpret_cast<uintptr_t>(buffer), "CMAR");
+    io::test::check_equal(ch.CNDTR.r, 16, "CNDTR");
+    io::test::check(SPI2.CR2.read().b.TXDMAEN && !SPI2.CR2.read().b.RXDMAEN, "TXDMAEN");
+    io::test::check(SPI2.I2SCFGR.read().b.I2SE, "I2SE");
+
+    // DMA is in second half, first half can be filled
+    ch.CNDTR.r = 8;
+    io::DMA1.ISR.r = io::Dma::Ifcr::HTIF << ((CHANNEL - 1) << 2);
+    i2s.handle_dma_isr();
+    io::DMA1.ISR.r = 0;
+    io::test::check(ready_data == buffer, "ready half");
+    io::test::check_equal(ready_count, 8, "ready count");
+    i2s.release(ready_data);
+
+    // last frame is sent
+    SPI2.SR.r = TXE;
+    i2s.stop();
+    io::test::check_equal(ch.CCR.r, 0, "DMA stopped");
+    io::test::check_equal(SPI2.CR2.r, 0, "DMA requests disabled");
+    io::test::check(!SPI2.I2SCFGR.read().b.I2SE, "I2S disabled");
+}
+
+static void test_receive() {
+    io::I2sStream i2s(SPI2, io::DMA1, CHANNEL);
+    i2s.configure<Prescaler8k>(io::Spi::I2scfgr::I2scfg::MASTER_RX);
+    io::test::check_equal(SPI2.I2SPR.r, 0x18c, "odd I2SPR");
+    i2s.start(buffer, 16, ready);
+    io::test::check(!io::DMA1.CHANNEL(CHANNEL).CCR.read().b.DIR, "RX DMA");
+    io::test::check(SPI2.CR2.read().b.RXDMAEN && !SPI2.CR2.read().b.TXDMAEN, "RXDMAEN");
+
+    // master receive is disabled after next received frame
+    SPI2.SR.r = RXNE;
+    i2s.stop();
+    io::test::check_equal(io::DMA1.CHANNEL(CHANNEL).CCR.r, 0, "RX DMA stopped");
+    io::test::check_equal(SPI2.CR2.r, 0, "RX DMA request disabled");
+    io::test::check(!SPI2.I2SCFGR.read().b.I2SE, "RX I2S disabled");
+
+    // slave does not wait for frame
+    i2s.configure(io::Spi::I2scfgr::I2scfg::SLAVE_RX, io::Spi::I2scfgr::Datalen::DATALEN_16, false, 0);
+    i2s.start(buffer, 16, ready);
+    SPI2.SR.r = 0;
+    i2s.stop();
+    io::test::check(!SPI2.I2SCFGR.read().b.I2SE, "slave I2S disabled");
+}
+
+static void test_samples() {
+    uint16_t data[2];
+    io::I2sStream::set_sample32(data, -0x123400);
+    io::test::check(data[0] == 0xffed && data[1] == 0xcc00, "set sample32");
+    io::test::check_equal(static_cast<uint32_t>(io::I2sStream::sample32(data)), static_cast<uint32_t>(-0x123400), "sample32");
+}
+
+int main() {
+    test_transmit();
+    test_receive();
+    test_samples();
+    return io::test::result("i2s_stream");
+}
@@ -0,0 +1,96 @@
+/**
+ * Deferred binary log
+ *
+ * Records are compared byte by byte with format described in
+ * io/lib/log.hpp (the same bytes are decoded by test_log_decode.py).
+ */
+
+#include "io/lib/log.hpp"
+#include "io/test/check.hpp"
+
+static const char MSG[] = "adc: ch=%u value=%d temp=%.1f";
+
+static size_t drain(io::Log &log, uint8_t *out, const size_t size) {
+    size_t count = 0;
+    const uint8_t *data;
+    size_t available;
+    while ((available = log.peek(data)) != 0 && count < size) {
+        if (available > size - count) available = size - count;
+        for (size_t i = 0; i < available; i++) out[count + i] = data[i];
+        log.consume(available);
+        count += available;
+    }
+    return count;
+}
+
+static void check_bytes(const uint8_t *data, const uint8_t *expected, const size_t size, const char *what) {
+    for (size_t i = 0; i < size; i++) {
+        if (!io::test::check_equal(data[i], expected[i], what)) return;
+    }
+}
+
+static void test_record() {
+    static uint8_t buffer[64];
+    io::Log log(buffer, sizeof(buffer));
+    io::test::check(log.write(MSG, 5u, -3, 1.5f), "write");
+
+    uint8_t record[32];
+    const size_t size = drain(log, record, sizeof(record));
+    io::test::check_equal(record[0], size - 1, "length");
+
+    // ID is address of format string, varint
+    uint32_t id = 0;
+    size_t pos = 1;
+    for (unsigned shift = 0; pos < size; shift += 7) {
+        id |= static_cast<uint32_t>(record[pos] & 0x7f) << shift;
+        if (!(record[pos++] & 0x80)) break;
+    }
+    io::test::check_equal(id, static_cast<uint32_t>(reinterpret_cast<uintptr_t>(MSG)), "ID");
+
+    // 5u: zig-zag 10, -3: zig-zag 5, 1.5f: 0x3fc00000
+    static const uint8_t args[] = {0x0a, 0x05, 0x00, 0x00, 0xc0, 0x3f};
+    io::test::check_equal(size - pos, sizeof(args), "arguments size");
+    check_bytes(record + pos, args, sizeof(args), "arguments");
+}
+
+static void test_varint() {
+    static uint8_t buffer[64];
+    io::Log log(buffer, sizeof(buffer));
+    log.write(nullptr, 300u, INT32_MIN, 'A', true);
+    uint8_t record[32];
+    const size_t size = drain(log, record, sizeof(record));
+    // ID 0, 300: zig-zag 600, INT32_MIN: zig-zag 0xffffffff, 'A': 130, true: 2
+    static const uint8_t expected[] = {11, 0x00, 0xd8, 0x04, 0xff, 0xff, 0xff, 0xff, 0x0f, 0x82, 0x01, 0x02};
+    io::test::check_equal(size, sizeof(expected), "varint size");
+    check_bytes(record, expected, sizeof(expected), "varint");
+}
+
+static void test_ring() {
+    static uint8_t buffer[16];
+    io::Log log(buffer, sizeof(buffer));
+    // record of 4 bytes: length, ID 0, two small arguments
+    for (unsigned i = 0; i < 4; i++) {
+        io::test::check(log.write(nullptr, i, 1), "write into ring");
+    }
+    io::test::check(!log.write(nullptr, 4, 1), "ring full");
+    io::test::check_equal(log.dropped(), 1, "dropped");
+
+    uint8_t out[32];
+    io::test::check_equal(drain(log, out, 6), 6, "partial drain");
+    io::test::check(log.write(nullptr, 5, 1), "write after drain");
+    // new record is at start of ring, ring is drained in two blocks
+    io::test::check_equal(drain(log, out, sizeof(out)), 14, "drain");
+    static const uint8_t expected[] = {2, 2, 3, 0, 4, 2, 3, 0, 6, 2};
+    check_bytes(out, expected, sizeof(expected), "ring order");
+    static const uint8_t last[] = {3, 0, 10, 2};
+    check_bytes(out + 10, last, sizeof(last), "record at start of ring");
+    const uint8_t *data;
+    io::test::check_equal(log.peek(data), 0, "empty");
+}
+
+int main() {
+    test_record();
+    test_varint();
+    test_ring();
+    return io::test::result("log");
+}
@@ -0,0 +1,83 @@
+"""io:test decoder of deferred binary log
+
+Records are the same bytes as encoded by io::Log in test_log.cpp,
+stream is read also in short chunks (serial port, pipe).
+"""
+
+import io
+import os
+import sys
+import unittest
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.dirname(os.path.abspath(__file__))), 'lib'))
+
+import log_decode  # noqa: E402
+
+ADDRESS = 0x20000
+STRINGS = b"adc: ch=%u value=%d temp=%.1f\0x=%x%%\n\0"
+MSG_ADC = ADDRESS
+MSG_HEX = ADDRESS + STRINGS.index(b"x=")
+
+
+def varint(value):
+    data = b''
+    while value >= 0x80:
+        data += bytes([value & 0x7f | 0x80])
+        value >>= 7
+    return data + bytes([value])
+
+
+def record(message_id, arguments):
+    data = varint(message_id) + arguments
+    return bytes([len(data)]) + data
+
+
+class ShortReads(io.RawIOBase):
+    """Stream returning at most chunk bytes per read"""
+
+    def __init__(self, data, chunk):
+        self._data = data
+        self._chunk = chunk
+
+    def readable(self):
+        return True
+
+    def read(self, size=-1):
+        size = min(size, self._chunk)
+        data, self._data = self._data[:size], self._data[size:]
+        return data
+
+
+class TestLogDecode(unittest.TestCase):
+    def setUp(self):
+        self.decoder = log_decode.Decoder(ADDRESS, STRINGS)
+        # 5u, -3, 1.5f and -1 as %x
+        self.stream = (
+            record(MSG_ADC, bytes([0x0a, 0x05, 0x00, 0x00, 0xc0, 0x3f]))
+            + record(MSG_HEX, bytes([0x01])))
+        self.lines = ["adc: ch=5 value=-3 temp=1.5", "x=ffffffff%"]
+
+    def test_stream(self):
+        self.assertEqual(list(self.decoder.decode_stream(io.BytesIO(self.stream))), self.lines)
+
+    def test_short_reads(self):
+        for chunk in (1, 2, 3):
+            stream = ShortReads(self.stream, chunk)
+            self.assertEqual(list(self.decoder.decode_stream(stream)), self.lines)
+
+    def test_truncated(self):
+        stream = io.BytesIO(self.stream[:-1])
+        self.assertEqual(list(self.decoder.decode_stream(stream)), self.lines[:1])
+
+    def test_unknown_id(self):
+        lines = list(self.decoder.decode_stream(io.BytesIO(record(0x10, b'\x02'))))
+        self.assertEqual(lines, ["<unknown message id 16: 1002>"])
+
+    def test_truncated_arguments(self):
+        lines = list(self.decoder.decode_stream(io.BytesIO(record(MSG_ADC, b'\x0a'))))
+        self.assertEqual(len(lines), 1)
+        self.assertTrue(lines[0].startswith("<truncated record"))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,177 @@
+/**
+ * Modbus RTU slave
+ *
+ * Requests are written into RX buffer at DMA address and ended by
+ * receiver timeout, responses are read from TX buffer at DMA address.
+ * CRC is computed by software (CRC peripheral is not simulated).
+ */
+
+#include "io/reg/stm32/f0/usart.hpp"
+#include "io/reg/stm32/f0/dma.hpp"
+#include "io/reg/stm32/f0/crc.hpp"
+#include "io/lib/stm32/f0/modbus_rtu.hpp"
+#include "io/test/check.hpp"
+
+static const unsigned RX_CHANNEL = 3;
+static const unsigned TX_CHANNEL = 2;
+static const uint32_t PE = 0x01;
+static const uint32_t RTOF = 0x800;
+static const uint8_t ADDRESS = 0x11;
+
+static uint16_t registers[256];
+static unsigned writes = 0;
+
+static uint8_t read_register(void *, const uint8_t function, const uint16_t address, uint16_t &value) {
+    if (function != io::ModbusRtu::Function::READ_HOLDING_REGISTERS) return io::ModbusRtu::Exception::ILLEGAL_FUNCTION;
+    if (address >= 256) return io::ModbusRtu::Exception::ILLEGAL_DATA_ADDRESS;
+    value = registers[address];
+    return io::ModbusRtu::Exception::NONE;
+}
+
+static uint8_t write_register(void *, const uint16_t address, const uint16_t value) {
+    if (address >= 256) return io::ModbusRtu::Exception::ILLEGAL_DATA_ADDRESS;
+    registers[address] = value;
+    writes++;
+    return io::ModbusRtu::Exception::NONE;
+}
+
+// DMA buffers are inside of instance, it must be static (32 bit address)
+static io::ModbusRtu modbus(io::USART1, io::DMA1, RX_CHANNEL, TX_CHANNEL);
+
+static uint8_t *address_of(const uint32_t address) {
+    return reinterpret_cast<uint8_t *>(static_cast<uintptr_t>(address));
+}
+
+/** Receive frame (CRC is appended when size is nonzero) and raise receiver timeout
+ */
+static void receive(const uint8_t *data, const size_t size, const uint32_t flags=RTOF, const bool crc=true) {
+    uint8_t *rx = address_of(io::DMA1.CHANNEL(RX_CHANNEL).CMAR.r);
+    for (size_t i = 0; i < size; i++) rx[i] = data[i];
+    size_t total = size;
+    if (crc) {
+        const uint16_t value = io::ModbusCrc::software(data, size);
+        rx[total++] = static_cast<uint8_t>(value);
+        rx[total++] = static_cast<uint8_t>(value >> 8);
+    }
+    io::DMA1.CHANNEL(RX_CHANNEL).CNDTR.r = static_cast<uint32_t>(io::ModbusRtu::MAX_ADU + 1 - total);
+    io::DMA1.CHANNEL(TX_CHANNEL).CCR.r = 0;
+    io::USART1.ISR.r = flags;
+    modbus.handle_isr();
+}
+
+/** Check response sent by DMA (with valid CRC)
+ */
+static void check_response(const uint8_t *expected, const size_t size, const char *what) {
+    io::Dma::Channel &ch = io::DMA1.CHANNEL(TX_CHANNEL);
+    if (!io::test::check(ch.CCR.read().b.EN, what)) return;
+    io::test::check_equal(ch.CNDTR.r, size + 2, what);
+    const uint8_t *tx = address_of(ch.CMAR.r);
+    for (size_t i = 0; i < size; i++) {
+        if (!io::test::check_equal(tx[i], expected[i], what)) return;
+    }
+    io::test::check_equal(io::ModbusCrc::software(tx, size + 2), 0, what);
+}
+
+static void check_no_response(const char *what) {
+    io::test::check_equal(io::DMA1.CHANNEL(TX_CHANNEL).CCR.r, 0, what);
+}
+
+static void test_crc() {
+    // example from Modbus over serial line specification
+    static const uint8_t request[] = {0x01, 0x03, 0x00, 0x00, 0x00, 0x0a};
+    io::test::check_equal(io::ModbusCrc::software(request, sizeof(request)), 0xcdc5, "software CRC");
+
+    // CRC peripheral: INIT at 0x10, POL at 0x14
+    io::test::check_equal(reinterpret_cast<uintptr_t>(&io::CRC.INIT), 0x40023010, "INIT address");
+    io::test::check_equal(reinterpret_cast<uintptr_t>(&io::CRC.POL), 0x40023014, "POL address");
+    io::ModbusCrc crc(&io::CRC);
+    crc.compute(request, sizeof(request));
+    io::test::check_equal(io::CRC.POL.r, 0x8005, "POL");
+    io::test::check_equal(io::CRC.INIT.r, 0xffff, "INIT");
+    const io::Crc::Cr cr = io::CRC.CR.read();
+    io::test::check_equal(cr.b.POLYSIZE, io::Crc::Cr::Polysize::POLY_16, "POLYSIZE");
+    io::test::check_equal(cr.b.REVIN, io::Crc::Cr::Revin::REV_8, "REVIN");
+    io::test::check_equal(cr.b.REVOUT, io::Crc::Cr::Revout::REVERSE, "REVOUT");
+}
+
+static void test_start() {
+    modbus.start(ADDRESS, 115200, read_register, write_register);
+    io::test::check_equal(io::USART1.RTOR.read().b.RTO, io::ModbusRtu::frame_gap(115200), "RTOR");
+    io::test::check_equal(io::ModbusRtu::frame_gap(115200), 202, "frame gap 115200");
+    io::test::check_equal(io::ModbusRtu::frame_gap(9600), 39, "frame gap 9600");
+    io::test::check_equal(io::DMA1.CHANNEL(RX_CHANNEL).CNDTR.r, io::ModbusRtu::MAX_ADU + 1, "RX CNDTR");
+    const io::Usart::Cr1 cr1 = io::USART1.CR1.read();
+    io::test::check(cr1.b.RTOIE && cr1.b.RE && cr1.b.TE, "CR1");
+}
+
+static void test_requests() {
+    for (unsigned i = 0; i < 256; i++) registers[i] = static_cast<uint16_t>(i * 0x0101);
+
+    static const uint8_t read[] = {ADDRESS, 0x03, 0x00, 0x6b, 0x00, 0x03};
+    receive(read, sizeof(read));
+    static const uint8_t read_response[] = {ADDRESS, 0x03, 0x06, 0x6b, 0x6b, 0x6c, 0x6c, 0x6d, 0x6d};
+    check_response(read_response, sizeof(read_response), "read holding registers");
+    io::test::check_equal(io::DMA1.CHANNEL(RX_CHANNEL).CNDTR.r, io::ModbusRtu::MAX_ADU + 1, "RX restarted");
+
+    static const uint8_t write[] = {ADDRESS, 0x06, 0x00, 0x01, 0x12, 0x34};
+    receive(write, sizeof(write));
+    check_response(write, sizeof(write), "write single register");
+    io::test::check_equal(registers[1], 0x1234, "written register");
+
+    static const uint8_t write_multiple[] = {ADDRESS, 0x10, 0x00, 0x02, 0x00, 0x02, 0x04, 0xaa, 0xbb, 0xcc, 0xdd};
+    receive(write_multiple, sizeof(write_multiple));
+    static const uint8_t write_multiple_response[] = {ADDRESS, 0x10, 0x00, 0x02, 0x00, 0x02};
+    check_response(write_multiple_response, sizeof(write_multiple_response), "write multiple registers");
+    io::test::check_equal(registers[3], 0xccdd, "written registers");
+
+    static const uint8_t unknown[] = {ADDRESS, 0x2b, 0x0e, 0x01, 0x00};
+    receive(unknown, sizeof(unknown));
+    static const uint8_t unknown_response[] = {ADDRESS, 0xab, 0x01};
+    check_response(unknown_response, sizeof(unknown_response), "illegal function");
+
+    static const uint8_t read_input[] = {ADDRESS, 0x04, 0x00, 0x00, 0x00, 0x01};
+    receive(read_input, sizeof(read_input));
+    static const uint8_t read_input_response[] = {ADDRESS, 0x84, 0x01};
+    check_response(read_input_response, sizeof(read_input_response), "exception from callback");
+
+    static const uint8_t other[] = {0x12, 0x06, 0x00, 0x01, 0x00, 0x00};
+    receive(other, sizeof(other));
+    check_no_response("other address");
+
+    const unsigned count = writes;
+    static const uint8_t broadcast[] = {0x00, 0x06, 0x00, 0x05, 0x00, 0x07};
+    receive(broadcast, sizeof(broadcast));
+    check_no_response("broadcast");
+    io::test::check_equal(writes, count + 1, "broadcast written");
+    io::test::check_equal(modbus.errors(), 0, "no errors");
+}
+
+static void test_errors() {
+    static const uint8_t read[] = {ADDRESS, 0x03, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00};
+    receive(read, sizeof(read), RTOF, false);
+    check_no_response("wrong CRC");
+    io::test::check_equal(modbus.errors(), 1, "wrong CRC error");
+
+    receive(read, sizeof(read) - 2, RTOF | PE);
+    check_no_response("parity error");
+    io::test::check_equal(modbus.errors(), 2, "parity error");
+
+    // 256 byte ADU is valid (here with wrong byte count)
+    static uint8_t longest[io::ModbusRtu::MAX_ADU + 1] = {ADDRESS, 0x10, 0x00, 0x00, 0x00, 0x7b, 0xf6};
+    receive(longest, io::ModbusRtu::MAX_ADU - 2);
+    static const uint8_t longest_response[] = {ADDRESS, 0x90, 0x03};
+    check_response(longest_response, sizeof(longest_response), "256 byte ADU");
+    io::test::check_equal(modbus.errors(), 2, "256 byte ADU is not error");
+
+    receive(longest, io::ModbusRtu::MAX_ADU - 1);
+    check_no_response("257 byte frame");
+    io::test::check_equal(modbus.errors(), 3, "257 byte frame error");
+}
+
+int main() {
+    test_crc();
+    test_start();
+    test_requests();
+    test_errors();
+    return io::test::result("modbus_rtu");
+}
@@ -0,0 +1,152 @@
+/**
+ * Compile-time pin descriptors
+ *
+ * PinGroup::configure() is compared with configuration of each pin
+ * by register methods on other port, starting from the same state.
+ * PinGroup::bsrr() is compared with bit by bit scatter of all values
+ * for each scatter method (shift, one and two lookup tables).
+ */
+
+#include "io/host/access_counter.hpp"
+#include "io/reg/stm32/f0/gpio.hpp"
+#include "io/lib/stm32/_common/pin.hpp"
+#include "io/test/check.hpp"
+
+using Led = io::PinOutput<io::base::GPIOB, 5, io::Gpio::Otyper::Otype::OPEN_DRAIN, io::Gpio::Ospeedr::Ospeed::HIGH>;
+using Tx = io::PinAf<io::base::GPIOB, 6, 0>;
+using Rx = io::PinAf<io::base::GPIOB, 11, 4, io::Gpio::Otyper::Otype::PUSH_PULL,
+    io::Gpio::Ospeedr::Ospeed::LOW, io::Gpio::Pupdr::Pupd::PULL_UP>;
+using Button = io::PinInput<io::base::GPIOB, 0, io::Gpio::Pupdr::Pupd::PULL_DOWN>;
+using Sense = io::PinAnalog<io::base::GPIOB, 15>;
+using PortB = io::PinGroup<Led, Tx, Rx, Button, Sense>;
+
+static_assert(io::pins_unique<Led, Tx, Rx, Button, Sense, io::PinInput<io::base::GPIOA, 5>>(), "unique pins");
+static_assert(!io::pins_unique<Led, Tx, io::PinInput<io::base::GPIOB, 5>>(), "pin used twice");
+
+/** Other pins of port are in some state, configuration must keep them
+ */
+static void preset(io::Gpio &gpio) {
+    gpio.MODER.r = 0xa5a5a5a5;
+    gpio.OTYPER.r = 0x00005a5a;
+    gpio.OSPEEDR.r = 0x5a5a5a5a;
+    gpio.PUPDR.r = 0x11111111;
+    gpio.AFR.r[0] = 0x12345678;
+    gpio.AFR.r[1] = 0x9abcdef0;
+}
+
+/** Reference: one pin at time by register methods
+ */
+static void configure_pins(io::Gpio &gpio) {
+    gpio.OTYPER.set(5, io::Gpio::Otyper::Otype::OPEN_DRAIN);
+    gpio.OSPEEDR.set(5, io::Gpio::Ospeedr::Ospeed::HIGH);
+    gpio.PUPDR.set(5, io::Gpio::Pupdr::Pupd::OFF);
+    gpio.MODER.set(5, io::Gpio::Moder::Mode::OUTPUT);
+    gpio.AFR.set(6, 0);
+    gpio.OTYPER.set(6, io::Gpio::Otyper::Otype::PUSH_PULL);
+    gpio.OSPEEDR.set(6, io::Gpio::Ospeedr::Ospeed::LOW);
+    gpio.PUPDR.set(6, io::Gpio::Pupdr::Pupd::OFF);
+    gpio.MODER.set(6, io::Gpio::Moder::Mode::AF);
+    gpio.AFR.set(11, 4);
+    gpio.OTYPER.set(11, io::Gpio::Otyper::Otype::PUSH_PULL);
+    gpio.OSPEEDR.set(11, io::Gpio::Ospeedr::Ospeed::LOW);
+    gpio.PUPDR.set(11, io::Gpio::Pupdr::Pupd::PULL_UP);
+    gpio.MODER.set(11, io::Gpio::Moder::Mode::AF);
+    gpio.PUPDR.set(0, io::Gpio::Pupdr::Pupd::PULL_DOWN);
+    gpio.MODER.set(0, io::Gpio::Moder::Mode::INPUT);
+    gpio.PUPDR.set(15, io::Gpio::Pupdr::Pupd::OFF);
+    gpio.MODER.set(15, io::Gpio::Moder::Mode::ANALOG);
+}
+
+static void test_configure() {
+    preset(io::GPIOB);
+    preset(io::GPIOC);
+    const io::host::Accesses accesses = io::host::count_accesses([] {
+        PortB::configure();
+    });
+    configure_pins(io::GPIOC);
+    io::test::check_equal(io::GPIOB.MODER.r, io::GPIOC.MODER.r, "MODER");
+    io::test::check_equal(io::GPIOB.OTYPER.r, io::GPIOC.OTYPER.r, "OTYPER");
+    io::test::check_equal(io::GPIOB.OSPEEDR.r, io::GPIOC.OSPEEDR.r, "OSPEEDR");
+    io::test::check_equal(io::GPIOB.PUPDR.r, io::GPIOC.PUPDR.r, "PUPDR");
+    io::test::check_equal(io::GPIOB.AFR.r[0], io::GPIOC.AFR.r[0], "AFRL");
+    io::test::check_equal(io::GPIOB.AFR.r[1], io::GPIOC.AFR.r[1], "AFRH");
+    // one read-modify-write per register
+    io::test::check_equal(accesses.reads, 6, "configure reads");
+    io::test::check_equal(accesses.writes, 6, "configure writes");
+}
+
+static void test_configure_input() {
+    // only inputs: no AFR, OTYPER and OSPEEDR access
+    using Inputs = io::PinGroup<io::PinInput<io::base::GPIOA, 1>, io::PinInput<io::base::GPIOA, 2, io::Gpio::Pupdr::Pupd::PULL_UP>>;
+    preset(io::GPIOA);
+    const io::host::Accesses accesses = io::host::count_accesses([] {
+        Inputs::configure();
+    });
+    io::test::check_equal(io::GPIOA.MODER.r, 0xa5a5a5a5 & ~0x3cu, "inputs MODER");
+    io::test::check_equal(io::GPIOA.PUPDR.r, (0x11111111 & ~0x3cu) | 0x10, "inputs PUPDR");
+    io::test::check_equal(accesses.reads, 2, "inputs reads");
+    io::test::check_equal(accesses.writes, 2, "inputs writes");
+}
+
+/** Reference: bit i of value to i-th pin
+ */
+static uint32_t bsrr_bits(const unsigned *pins, const unsigned size, const uint32_t value) {
+    uint32_t bsrr = 0;
+    for (unsigned i = 0; i < size; i++) {
+        bsrr |= (value & (1u << i)) ? 1u << pins[i] : 1u << (pins[i] + 16);
+    }
+    return bsrr;
+}
+
+template <typename Group>
+static void check_scatter(const unsigned *pins, const char *name) {
+    unsigned errors = 0;
+    for (uint32_t value = 0; value < (1u << Group::size); value++) {
+        if (Group::bsrr(value) != bsrr_bits(pins, Group::size, value)) errors++;
+    }
+    io::test::check_equal(errors, 0, name);
+}
+
+template <unsigned... N>
+using Outputs = io::PinGroup<io::PinOutput<io::base::GPIOA, N>...>;
+
+static void test_scatter() {
+    using Shift = Outputs<3, 4, 5, 6, 7>;
+    using Lut8 = Outputs<7, 0, 12, 3, 15, 1, 9, 4>;
+    using Lut16 = Outputs<15, 14, 0, 1, 2, 3, 13, 12, 4, 5, 11, 10, 6, 7, 9, 8>;
+    using Lut16Odd = Outputs<2, 9, 4, 11, 6, 13, 8, 15, 10, 1, 5>;
+    static_assert(Shift::ScatterMethod::value == Shift::ScatterShift::value, "shift");
+    static_assert(Lut8::ScatterMethod::value == Lut8::ScatterLut8::value, "lut8");
+    static_assert(Lut16::ScatterMethod::value == Lut16::ScatterLut16::value, "lut16");
+    static_assert(Lut16Odd::ScatterMethod::value == Lut16Odd::ScatterLut16::value, "lut16");
+    static_assert(Lut8::bsrr(0x01) == ((1u << 7) | (0x921bu << 16)), "compile time bsrr");
+
+    const unsigned shift[] = {3, 4, 5, 6, 7};
+    const unsigned lut8[] = {7, 0, 12, 3, 15, 1, 9, 4};
+    const unsigned lut16[] = {15, 14, 0, 1, 2, 3, 13, 12, 4, 5, 11, 10, 6, 7, 9, 8};
+    const unsigned lut16_odd[] = {2, 9, 4, 11, 6, 13, 8, 15, 10, 1, 5};
+    check_scatter<Shift>(shift, "scatter shift");
+    check_scatter<Lut8>(lut8, "scatter 8 pin table");
+    check_scatter<Lut16>(lut16, "scatter 16 pin tables");
+    check_scatter<Lut16Odd>(lut16_odd, "scatter 11 pin tables");
+}
+
+static void test_write() {
+    using Bus = Outputs<7, 0, 12, 3, 15, 1, 9, 4>;
+    static volatile uint32_t value = 0xa5;
+    io::GPIOA.BSRR.r = 0;
+    const io::host::Accesses accesses = io::host::count_accesses([] {
+        Bus::write(value);
+    });
+    io::test::check_equal(io::GPIOA.BSRR.r, Bus::bsrr(0xa5), "write BSRR");
+    io::test::check_equal(accesses.reads, 0, "write reads");
+    io::test::check_equal(accesses.writes, 1, "write writes");
+}
+
+int main() {
+    test_configure();
+    test_configure_input();
+    test_scatter();
+    test_write();
+    return io::test::result("pin");
+}
@@ -0,0 +1,134 @@
+/**
+ * RS-485 multi-drop node
+ *
+ * DMA position and USART flags are set by test, received frames
+ * and sequence of transmission (address mark, DMA, TC) are checked.
+ */
+
+#include "io/reg/stm32/f0/usart.hpp"
+#include "io/reg/stm32/f0/dma.hpp"
+#include "io/lib/stm32/_common/rs485.hpp"
+#include "io/test/check.hpp"
+
+static const unsigned RX_CHANNEL = 3;
+static const unsigned TX_CHANNEL = 2;
+static const uint32_t FE = 0x02;
+static const uint32_t IDLE = 0x10;
+static const uint32_t TC = 0x40;
+static const uint32_t RTOF = 0x800;
+
+static uint8_t buffer[8];
+static const uint8_t reply[] = {0xa1, 0xa2, 0xa3};
+
+static const uint8_t *frame_data = nullptr;
+static size_t frame_size = 0;
+static unsigned frames = 0;
+static unsigned sent_count = 0;
+
+static void received(void *, const uint8_t *data, const size_t size) {
+    frame_data = data;
+    frame_size = size;
+    frames++;
+}
+
+static void sent(void *) {
+    sent_count++;
+}
+
+static void usart_interrupt(io::Rs485 &bus, const uint32_t flags) {
+    io::USART1.ISR.r = flags;
+    io::USART1.ICR.r = 0;
+    bus.handle_isr();
+}
+
+static void test_configure() {
+    io::Rs485 bus(io::USART1, io::DMA1, RX_CHANNEL, TX_CHANNEL);
+    bus.configure(0x92, 8, 4, true);
+    const io::Usart::Cr2 cr2 = io::USART1.CR2.read();
+    io::test::check(cr2.b.ADDM7, "ADDM7");
+    io::test::check_equal(cr2.b.ADD, 0x12, "ADD");
+    const io::Usart::Cr3 cr3 = io::USART1.CR3.read();
+    io::test::check(cr3.b.DEM && cr3.b.DEP && cr3.b.EIE, "CR3");
+    const io::Usart::Cr1 cr1 = io::USART1.CR1.read();
+    io::test::check(cr1.b.M0 && !cr1.b.M1 && cr1.b.WAKE && cr1.b.MME && cr1.b.TE && cr1.b.UE, "CR1");
+    io::test::check_equal(cr1.b.DEAT, 8, "DEAT");
+    io::test::check_equal(cr1.b.DEDT, 4, "DEDT");
+}
+
+static void test_receive() {
+    io::Rs485 bus(io::USART1, io::DMA1, RX_CHANNEL, TX_CHANNEL);
+    bus.configure(0x12);
+    io::USART1.RQR.r = 0;
+    bus.start(buffer, sizeof(buffer), received);
+    io::test::check(io::USART1.CR1.read().b.IDLEIE && io::USART1.CR1.read().b.RE, "start CR1");
+    io::test::check(io::USART1.RQR.read().b.MMRQ, "mute mode request");
+    io::Dma::Channel &ch = io::DMA1.CHANNEL(RX_CHANNEL);
+    io::test::check(ch.CCR.read().PSIZE() == io::Dma::Channel::Ccr::Size::SIZE_16, "RX PSIZE");
+    io::test::check(ch.CCR.read().MSIZE() == io::Dma::Channel::Ccr::Size::SIZE_8, "RX MSIZE");
+
+    // address and 3 bytes of data
+    ch.CNDTR.r = sizeof(buffer) - 4;
+    usart_interrupt(bus, IDLE);
+    io::test::check_equal(io::USART1.ICR.r, IDLE, "IDLE cleared");
+    io::test::check_equal(frames, 1, "frame");
+    io::test::check(frame_data == buffer + 1, "frame without address");
+    io::test::check_equal(frame_size, 3, "frame size");
+    io::test::check_equal(ch.CNDTR.r, sizeof(buffer), "RX restarted");
+
+    // errors, flag without enabled interrupt is ignored
+    usart_interrupt(bus, FE | RTOF);
+    io::test::check_equal(io::USART1.ICR.r, FE, "error cleared");
+    io::test::check_equal(bus.errors(), 1, "error");
+    io::test::check_equal(frames, 1, "no frame on error");
+
+    // frame too long
+    ch.CNDTR.r = 0;
+    usart_interrupt(bus, IDLE);
+    io::test::check_equal(bus.errors(), 2, "frame too long");
+    io::test::check_equal(frames, 1, "no frame too long");
+}
+
+static void test_send() {
+    io::Rs485 bus(io::USART1, io::DMA1, RX_CHANNEL, TX_CHANNEL);
+    io::USART1.CR1.r = 0;
+    io::test::check(bus.send(0x81, reply, sizeof(reply), sent), "send");
+    io::test::check(!bus.send(0x01, reply, sizeof(reply), sent), "send while sending");
+    io::test::check_equal(io::USART1.TDR.r, 0x101, "address mark");
+    io::test::check(io::USART1.CR3.read().b.DMAT, "DMAT");
+    io::Dma::Channel &ch = io::DMA1.CHANNEL(TX_CHANNEL);
+    io::test::check_equal(ch.CMAR.r, reinterpret_cast<uintptr_t>(reply), "TX CMAR");
+    io::test::check_equal(ch.CNDTR.r, sizeof(reply), "TX CNDTR");
+    io::test::check(ch.CCR.read().b.DIR && ch.CCR.read().b.EN, "TX CCR");
+
+    // TC of address mark is not end
+    usart_interrupt(bus, TC);
+    io::test::check_equal(sent_count, 0, "TC before DMA done");
+
+    io::DMA1.ISR.r = io::Dma::Ifcr::TCIF << ((TX_CHANNEL - 1) << 2);
+    io::DMA1.IFCR.r = 0;
+    bus.handle_dma_isr();
+    io::DMA1.ISR.r = 0;
+    io::test::check_equal(io::DMA1.IFCR.r, io::Dma::Ifcr::TCIF << ((TX_CHANNEL - 1) << 2), "only TCIF cleared");
+    io::test::check_equal(ch.CCR.r, 0, "TX channel disabled");
+    io::test::check(io::USART1.CR1.read().b.TCIE, "TCIE");
+    io::test::check(bus.is_sending(), "sending until TC");
+
+    usart_interrupt(bus, TC);
+    io::test::check_equal(io::USART1.ICR.r, TC, "TC cleared");
+    io::test::check(!io::USART1.CR1.read().b.TCIE, "TCIE cleared");
+    io::test::check(!bus.is_sending(), "sent");
+    io::test::check_equal(sent_count, 1, "done");
+
+    // address only
+    io::test::check(bus.send(0x05, nullptr, 0, sent), "send address");
+    io::test::check(io::USART1.CR1.read().b.TCIE, "address only TCIE");
+    usart_interrupt(bus, TC);
+    io::test::check_equal(sent_count, 2, "address only done");
+}
+
+int main() {
+    test_configure();
+    test_receive();
+    test_send();
+    return io::test::result("rs485");
+}
@@ -0,0 +1,166 @@
+/**
+ * Queued SPI bus
+ *
+ * Transactions of two devices are queued while bus is busy, chip select
+ * (last BSRR write), SPI configuration and order of done callbacks are
+ * checked, segments are completed by RX channel flag set by test.
+ */
+
+#include "io/reg/stm32/f0/spi.hpp"
+#include "io/reg/stm32/f0/dma.hpp"
+#include "io/reg/stm32/f0/gpio.hpp"
+#include "io/lib/stm32/_common/spi_bus.hpp"
+#include "io/test/check.hpp"
+
+static const unsigned RX_CHANNEL = 2;
+static const unsigned TX_CHANNEL = 3;
+static const uint32_t FLASH_CS = 1 << 4;
+static const uint32_t DISPLAY_CS = 1 << 9;
+
+typedef io::SpiBus<2> Bus;
+
+static const Bus::Device flash = {&io::GPIOA, FLASH_CS, 8, io::Spi::Cr1::Br::DIV_2, false, false, false, 0, false};
+static const Bus::Device display = {&io::GPIOB, DISPLAY_CS, 16, io::Spi::Cr1::Br::DIV_8, true, true, false, 0, false};
+static const Bus::Device card = {&io::GPIOA, FLASH_CS, 8, io::Spi::Cr1::Br::DIV_4, false, false, false, 0x1021, true};
+
+// DMA buffers (32 bit addresses)
+alignas(2) static uint8_t command[4] = {0x03, 0x00, 0x10, 0x00};
+alignas(2) static uint8_t data[16];
+alignas(2) static uint16_t pixels[8];
+
+// dummy DMA buffers are inside of SpiDma, it must be static
+static io::SpiDma spi(io::SPI1, io::DMA1, RX_CHANNEL, TX_CHANNEL);
+
+static unsigned done_order[8];
+static bool done_ok[8];
+static unsigned done_count = 0;
+
+static void done(void *context, const bool ok) {
+    done_order[done_count] = static_cast<unsigned>(reinterpret_cast<uintptr_t>(context));
+    done_ok[done_count] = ok;
+    done_count++;
+}
+
+static void *id(const unsigned value) {
+    return reinterpret_cast<void *>(static_cast<uintptr_t>(value));
+}
+
+/** RX channel transfer complete (or error) of current segment
+ */
+static void complete(const bool error=false) {
+    io::DMA1.ISR.r = (error ? io::Dma::Ifcr::TEIF : io::Dma::Ifcr::TCIF) << ((RX_CHANNEL - 1) << 2);
+    spi.handle_dma_isr();
+    io::DMA1.ISR.r = 0;
+}
+
+static void test_chain() {
+    Bus bus(spi);
+    done_count = 0;
+    io::test::check(bus.is_idle(), "idle");
+
+    Bus::Transaction read = {&flash, nullptr, data, sizeof(data), done, id(2), nullptr, false};
+    Bus::Transaction cmd = {&flash, command, nullptr, sizeof(command), done, id(1), &read, false};
+    io::test::check(bus.submit(cmd), "submit");
+    io::test::check(!bus.is_idle(), "busy");
+    io::test::check_equal(io::GPIOA.BSRR.r, FLASH_CS << 16, "chip select asserted");
+    io::test::check_equal(io::SPI1.CR2.read().b.DS, 7, "flash frame size");
+    io::test::check_equal(io::DMA1.CHANNEL(TX_CHANNEL).CMAR.r, reinterpret_cast<uintptr_t>(command), "command TX");
+
+    // chip select stays asserted for next segment
+    io::GPIOA.BSRR.r = 0;
+    complete();
+    io::test::check_equal(io::GPIOA.BSRR.r, 0, "chip select kept");
+    io::test::check_equal(io::DMA1.CHANNEL(RX_CHANNEL).CMAR.r, reinterpret_cast<uintptr_t>(data), "read RX");
+    io::test::check_equal(done_count, 1, "command done");
+
+    complete();
+    io::test::check_equal(io::GPIOA.BSRR.r, FLASH_CS, "chip select released");
+    io::test::check_equal(done_count, 2, "read done");
+    io::test::check(done_order[0] == 1 && done_order[1] == 2 && done_ok[0] && done_ok[1], "chain order");
+    io::test::check(bus.is_idle(), "idle after chain");
+
+    // error skips rest of chain
+    done_count = 0;
+    bus.submit(cmd);
+    complete(true);
+    io::test::check_equal(io::GPIOA.BSRR.r, FLASH_CS, "chip select released on error");
+    io::test::check_equal(done_count, 1, "only failed segment done");
+    io::test::check(!done_ok[0], "error reported");
+    io::test::check(bus.is_idle(), "idle after error");
+}
+
+static void test_queue() {
+    Bus bus(spi);
+    done_count = 0;
+
+    Bus::Transaction a = {&flash, command, nullptr, sizeof(command), done, id(1), nullptr, false};
+    Bus::Transaction b = {&display, pixels, nullptr, 8, done, id(2), nullptr, false};
+    Bus::Transaction c = {&display, pixels, nullptr, 8, done, id(3), nullptr, false};
+    Bus::Transaction d = {&flash, command, nullptr, sizeof(command), done, id(4), nullptr, false};
+    io::test::check(bus.submit(a), "submit a");
+    io::test::check(bus.submit(b), "submit b");
+    io::test::check(bus.submit(c), "submit c");
+    io::test::check(!bus.submit(d), "queue full");
+
+    // next device is configured and selected when previous is released
+    io::GPIOB.BSRR.r = 0;
+    complete();
+    io::test::check_equal(io::GPIOB.BSRR.r, DISPLAY_CS << 16, "display selected");
+    io::test::check_equal(io::GPIOA.BSRR.r, FLASH_CS, "flash released");
+    const io::Spi::Cr1 cr1 = io::SPI1.CR1.read();
+    io::test::check(cr1.b.CPOL && cr1.b.CPHA, "display mode");
+    io::test::check_equal(cr1.b.BR, io::Spi::Cr1::Br::DIV_8, "display BR");
+    io::test::check_equal(io::SPI1.CR2.read().b.DS, 15, "display frame size");
+
+    // same device is not configured again
+    io::SPI1.CR1.modify([](io::Spi::Cr1 &r) { r.b.BR = io::Spi::Cr1::Br::DIV_256; });
+    complete();
+    io::test::check_equal(io::SPI1.CR1.read().b.BR, io::Spi::Cr1::Br::DIV_256, "not reconfigured");
+    io::test::check(bus.submit(d), "submit after queue drained");
+    complete();
+    io::test::check_equal(io::GPIOB.BSRR.r, DISPLAY_CS, "display released");
+    io::test::check_equal(io::SPI1.CR1.read().b.BR, io::Spi::Cr1::Br::DIV_2, "flash reconfigured");
+    complete();
+    io::test::check_equal(done_count, 4, "all done");
+    io::test::check(done_order[0] == 1 && done_order[1] == 2 && done_order[2] == 3 && done_order[3] == 4, "queue order");
+    io::test::check(bus.is_idle(), "idle after queue");
+    bus.flush();
+}
+
+static void test_crc() {
+    Bus bus(spi);
+    done_count = 0;
+    io::SPI1.CRCPR.r = 0;
+    io::SPI1.SR.r = 0;
+
+    // CRC polynomial is configured with device, CRC only for crc segment
+    Bus::Transaction block = {&card, nullptr, data, sizeof(data), done, id(2), nullptr, true};
+    Bus::Transaction cmd = {&card, command, nullptr, sizeof(command), done, id(1), &block, false};
+    bus.submit(cmd);
+    io::test::check_equal(io::SPI1.CRCPR.r, 0x1021, "device CRCPR");
+    io::test::check(!io::SPI1.CR1.read().b.CRCEN, "no CRC for command");
+    complete();
+    const io::Spi::Cr1 cr1 = io::SPI1.CR1.read();
+    io::test::check(cr1.b.CRCEN && cr1.b.CRCL, "CRC16 for block");
+
+    // received CRC mismatch fails segment
+    io::SPI1.SR.write([](io::Spi::Sr &sr) { sr.b.CRCERR = 1; });
+    complete();
+    io::test::check_equal(done_count, 2, "block done");
+    io::test::check(done_ok[0] && !done_ok[1], "block CRC error");
+    io::test::check_equal(io::GPIOA.BSRR.r, FLASH_CS, "card released");
+
+    // device without polynomial would use CRCPR of card
+    Bus::Transaction flash_block = {&flash, nullptr, data, sizeof(data), done, id(4), nullptr, true};
+    Bus::Transaction flash_cmd = {&flash, command, nullptr, sizeof(command), done, id(3), &flash_block, false};
+    io::test::check(!bus.submit(flash_block), "crc without polynomial");
+    io::test::check(!bus.submit(flash_cmd), "crc segment in chain without polynomial");
+    io::test::check(bus.is_idle() && done_count == 2, "rejected transactions not started");
+}
+
+int main() {
+    test_chain();
+    test_queue();
+    test_crc();
+    return io::test::result("spi_bus");
+}
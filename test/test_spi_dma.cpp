@@ -0,0 +1,193 @@
+/**
+ * SPI full-duplex DMA transfer
+ *
+ * Frame format and DMA setup (packing, access size and count) are
+ * checked for each kind of transfer, completion is raised by RX channel
+ * transfer complete flag set by test.
+ */
+
+#include "io/reg/stm32/f0/spi.hpp"
+#include "io/reg/stm32/f0/dma.hpp"
+#include "io/lib/stm32/_common/spi_dma.hpp"
+#include "io/test/check.hpp"
+
+static const unsigned RX_CHANNEL = 2;
+static const unsigned TX_CHANNEL = 3;
+
+// halfword aligned DMA buffers (32 bit addresses)
+alignas(2) static uint8_t tx_buffer[64];
+alignas(2) static uint8_t rx_buffer[64];
+
+static unsigned done_count = 0;
+static bool done_ok = false;
+
+static void done(void *, const bool ok) {
+    done_count++;
+    done_ok = ok;
+}
+
+/** Check DMA channel setup
+ */
+static void check_channel(const unsigned channel, const void *memory, const size_t count, const io::Dma::Channel::Ccr::Size size, const bool minc, const char *what) {
+    io::Dma::Channel &ch = io::DMA1.CHANNEL(channel);
+    io::Dma::Channel::Ccr ccr = ch.CCR.read();
+    io::test::check(ccr.b.EN, what);
+    if (memory) io::test::check_equal(ch.CMAR.r, reinterpret_cast<uintptr_t>(memory), what);
+    io::test::check_equal(ch.CNDTR.r, count, what);
+    io::test::check(ccr.PSIZE() == size && ccr.MSIZE() == size, what);
+    io::test::check_equal(ccr.b.MINC, minc, what);
+    io::test::check_equal(ccr.b.DIR, channel == TX_CHANNEL, what);
+}
+
+/** Check frame format in CR2
+ */
+static void check_cr2(const unsigned bits, const bool frxth, const bool ldma, const char *what) {
+    const io::Spi::Cr2 cr2 = io::SPI1.CR2.read();
+    io::test::check_equal(cr2.b.DS, bits - 1, what);
+    io::test::check_equal(cr2.b.FRXTH, frxth, what);
+    io::test::check_equal(cr2.b.LDMA_TX, ldma, what);
+    io::test::check_equal(cr2.b.LDMA_RX, ldma, what);
+    io::test::check(cr2.b.TXDMAEN && cr2.b.RXDMAEN, what);
+}
+
+/** RX channel transfer complete (or error)
+ */
+static void complete(io::SpiDma &spi, const bool error=false) {
+    const uint32_t flags = (error ? io::Dma::Ifcr::TEIF : io::Dma::Ifcr::TCIF) << ((RX_CHANNEL - 1) << 2);
+    io::DMA1.ISR.r = flags;
+    io::DMA1.IFCR.r = 0;
+    spi.handle_dma_isr();
+    io::DMA1.ISR.r = 0;
+    io::test::check_equal(io::DMA1.IFCR.r, flags, "only read flag cleared");
+}
+
+static void test_configure() {
+    io::SpiDma spi(io::SPI1, io::DMA1, RX_CHANNEL, TX_CHANNEL);
+    spi.configure(8, io::Spi::Cr1::Br::DIV_8, true, true, true);
+    const io::Spi::Cr1 cr1 = io::SPI1.CR1.read();
+    io::test::check(cr1.b.MSTR && cr1.b.SSM && cr1.b.SSI, "master, software NSS");
+    io::test::check(cr1.b.CPOL && cr1.b.CPHA && cr1.b.LSBFIRST, "clock and bit order");
+    io::test::check_equal(cr1.b.BR, io::Spi::Cr1::Br::DIV_8, "BR");
+    io::test::check(!cr1.b.SPE, "disabled between transfers");
+}
+
+static void test_transfers() {
+    using Size = io::Dma::Channel::Ccr::Size;
+    io::SpiDma spi(io::SPI1, io::DMA1, RX_CHANNEL, TX_CHANNEL);
+    spi.configure(8, io::Spi::Cr1::Br::DIV_2);
+
+    // 8 bit frames, aligned buffers: two frames per access
+    io::test::check(spi.transfer(tx_buffer, rx_buffer, 64, done), "packed");
+    io::test::check(io::SPI1.CR1.read().b.SPE, "SPE");
+    check_cr2(8, false, false, "packed CR2");
+    check_channel(RX_CHANNEL, rx_buffer, 32, Size::SIZE_16, true, "packed RX");
+    check_channel(TX_CHANNEL, tx_buffer, 32, Size::SIZE_16, true, "packed TX");
+    io::test::check(spi.is_busy(), "busy");
+    io::test::check(!spi.transfer(tx_buffer, rx_buffer, 8, done), "transfer while busy");
+    complete(spi);
+    io::test::check_equal(done_count, 1, "done");
+    io::test::check(done_ok, "done ok");
+    io::test::check(!spi.is_busy(), "not busy");
+    io::test::check_equal(io::DMA1.CHANNEL(RX_CHANNEL).CCR.r, 0, "RX channel disabled");
+    io::test::check_equal(io::DMA1.CHANNEL(TX_CHANNEL).CCR.r, 0, "TX channel disabled");
+    io::test::check(!io::SPI1.CR1.read().b.SPE, "SPE cleared");
+    io::test::check(!io::SPI1.CR2.read().b.TXDMAEN && !io::SPI1.CR2.read().b.RXDMAEN, "DMA requests disabled");
+
+    // odd count with RX buffer: not packed, last access must not write beyond buffer
+    spi.transfer(tx_buffer, rx_buffer, 63, done);
+    check_cr2(8, true, false, "odd RX CR2");
+    check_channel(RX_CHANNEL, rx_buffer, 63, Size::SIZE_8, true, "odd RX");
+    check_channel(TX_CHANNEL, tx_buffer, 63, Size::SIZE_8, true, "odd RX TX");
+    complete(spi);
+
+    // odd count without RX buffer: packed, last frame by LDMA_TX / LDMA_RX
+    spi.transfer(tx_buffer, nullptr, 63, done);
+    check_cr2(8, false, true, "odd TX CR2");
+    check_channel(RX_CHANNEL, nullptr, 32, Size::SIZE_16, false, "odd TX dummy RX");
+    check_channel(TX_CHANNEL, tx_buffer, 32, Size::SIZE_16, true, "odd TX");
+    complete(spi);
+
+    // unaligned buffer: one frame per access
+    spi.transfer(tx_buffer + 1, rx_buffer, 64, done);
+    check_cr2(8, true, false, "unaligned CR2");
+    check_channel(TX_CHANNEL, tx_buffer + 1, 64, Size::SIZE_8, true, "unaligned TX");
+    complete(spi);
+
+    // receive only: 0xff is sent from dummy
+    spi.transfer(nullptr, rx_buffer, 10, done);
+    check_channel(TX_CHANNEL, nullptr, 5, Size::SIZE_16, false, "dummy TX");
+    complete(spi, true);
+    io::test::check(!done_ok, "transfer error");
+
+    // 12 bit frames: one frame per 16 bit access
+    spi.configure(12, io::Spi::Cr1::Br::DIV_2);
+    spi.transfer(tx_buffer, rx_buffer, 31, done);
+    check_cr2(12, false, false, "12 bit CR2");
+    check_channel(RX_CHANNEL, rx_buffer, 31, Size::SIZE_16, true, "12 bit RX");
+    complete(spi);
+
+    io::test::check(!spi.transfer(tx_buffer, rx_buffer, 0, done), "empty transfer");
+    io::test::check(!spi.transfer(tx_buffer, rx_buffer, 0x10000, done), "too long transfer");
+}
+
+/** Set CRC error flag (received CRC mismatch)
+ */
+static void crc_error() {
+    io::SPI1.SR.write([](io::Spi::Sr &sr) { sr.b.CRCERR = 1; });
+}
+
+static void test_crc() {
+    io::SpiDma spi(io::SPI1, io::DMA1, RX_CHANNEL, TX_CHANNEL);
+    spi.configure(8, io::Spi::Cr1::Br::DIV_2);
+    spi.configure_crc(0x1021, true);
+    io::test::check_equal(io::SPI1.CRCPR.r, 0x1021, "CRCPR");
+
+    // CRC is enabled only during crc transfer
+    done_count = 0;
+    io::SPI1.SR.r = 0;
+    spi.transfer(tx_buffer, rx_buffer, 16, done, nullptr, true);
+    io::Spi::Cr1 cr1 = io::SPI1.CR1.read();
+    io::test::check(cr1.b.CRCEN && cr1.b.CRCL && cr1.b.SPE, "CRC16 enabled");
+    check_channel(RX_CHANNEL, rx_buffer, 8, io::Dma::Channel::Ccr::Size::SIZE_16, true, "CRC data without CRC frames");
+    complete(spi);
+    io::test::check(done_ok, "CRC match");
+    io::test::check(!io::SPI1.CR1.read().b.CRCEN, "CRC disabled");
+
+    // received CRC mismatch
+    spi.transfer(tx_buffer, rx_buffer, 16, done, nullptr, true);
+    crc_error();
+    complete(spi);
+    io::test::check(!done_ok, "CRC error");
+    io::test::check_equal(io::SPI1.SR.r, 0, "CRCERR cleared");
+
+    // CRCERR is not checked without RX buffer, but still cleared
+    spi.transfer(tx_buffer, nullptr, 16, done, nullptr, true);
+    crc_error();
+    complete(spi);
+    io::test::check(done_ok, "CRC not checked without RX");
+    io::test::check_equal(io::SPI1.SR.r, 0, "CRCERR cleared without RX");
+
+    // transfer without crc does not touch CRC
+    spi.transfer(tx_buffer, rx_buffer, 16, done);
+    io::test::check(!io::SPI1.CR1.read().b.CRCEN, "CRC not enabled");
+    crc_error();
+    complete(spi);
+    io::test::check(done_ok, "CRCERR ignored without crc");
+    io::SPI1.SR.r = 0;
+
+    // 8 bit CRC
+    spi.configure_crc(0x07, false);
+    spi.transfer(tx_buffer, rx_buffer, 16, done, nullptr, true);
+    cr1 = io::SPI1.CR1.read();
+    io::test::check(cr1.b.CRCEN && !cr1.b.CRCL, "CRC8 enabled");
+    io::test::check_equal(io::SPI1.CRCPR.r, 0x07, "CRC8 CRCPR");
+    complete(spi);
+    io::test::check_equal(done_count, 5, "CRC transfers done");
+}
+
+int main() {
+    test_configure();
+    test_transfers();
+    test_crc();
+    return io::test::result("spi_dma");
+}
@@ -0,0 +1,71 @@
+/**
+ * USART baud rate
+ *
+ * Solved BRR and OVER8 are compared with values computed by hand
+ * from reference manual formulas, configuration is read back.
+ */
+
+#include "io/reg/stm32/f0/usart.hpp"
+#include "io/lib/stm32/_common/usart_baud.hpp"
+#include "io/test/check.hpp"
+
+// oversampling by 16: 48 MHz / 417 = 115108 Bd
+typedef io::UsartBaud<48000000, 115200> Baud115200;
+static_assert(!Baud115200::over8 && Baud115200::brr == 417, "115200 BRR");
+static_assert(Baud115200::actual == 115108 && Baud115200::error_ppm == 799, "115200 error");
+
+typedef io::UsartBaud<8000000, 9600> Baud9600;
+static_assert(!Baud9600::over8 && Baud9600::brr == 0x341 && Baud9600::actual == 9604, "9600 BRR");
+
+// oversampling by 16 is not possible, BRR[2:0] is USARTDIV[3:0] shifted right
+typedef io::UsartBaud<48000000, 6000000> Baud6M;
+static_assert(Baud6M::over8 && Baud6M::brr == 0x10 && Baud6M::error_ppm == 0, "6 MBd BRR");
+
+typedef io::UsartBaud<48000000, 4000000> Baud4M;
+static_assert(Baud4M::over8 && Baud4M::divider == 24 && Baud4M::brr == 0x14, "4 MBd BRR");
+
+// oversampling by 8 is used also when oversampling by 16 is out of tolerance and worse
+static_assert(io::usart_baud_solver::select_over8(8000000, 460800, 20000), "460800 OVER8");
+static_assert(!io::usart_baud_solver::select_over8(8000000, 460800, 100000), "460800 tolerance");
+
+static void test_configure() {
+    io::USART1.CR1.r = 0;
+    Baud4M::configure(io::USART1);
+    io::test::check(io::USART1.CR1.read().b.OVER8, "4 MBd OVER8");
+    io::test::check_equal(io::USART1.BRR.r, 0x14, "4 MBd BRR");
+    io::test::check_equal(io::usart_baud(io::USART1, 48000000), 4000000, "4 MBd read back");
+
+    Baud115200::configure(io::USART1);
+    io::test::check(!io::USART1.CR1.read().b.OVER8, "115200 OVER8");
+    io::test::check_equal(io::usart_baud(io::USART1, 48000000), 115108, "115200 read back");
+}
+
+static void test_auto_baud() {
+    io::USART1.CR2.r = 0;
+    io::usart_auto_baud(io::USART1, io::UsartAbrMode::FRAME_0X55);
+    io::test::check(io::USART1.CR2.read().b.ABREN, "ABREN");
+    io::test::check_equal(io::USART1.CR2.read().b.ABRMOD, 3, "ABRMOD");
+
+    io::USART1.ISR.r = 0;
+    io::test::check(!io::usart_auto_baud_done(io::USART1), "not done");
+    io::USART1.ISR.r = 1u << 15;  // ABRF
+    io::test::check(io::usart_auto_baud_done(io::USART1), "done");
+    io::USART1.ISR.r = (1u << 15) | (1u << 14);  // ABRF, ABRE
+    io::test::check(!io::usart_auto_baud_done(io::USART1), "done with error");
+    io::test::check(io::usart_auto_baud_error(io::USART1), "error");
+
+    io::USART1.RQR.r = 0;
+    io::usart_auto_baud_request(io::USART1);
+    io::test::check_equal(io::USART1.RQR.r, 1, "ABRRQ");
+
+    // detected value with oversampling by 8
+    io::USART1.CR1.modify([](io::Usart::Cr1 &cr1) { cr1.b.OVER8 = 1; });
+    io::USART1.BRR.r = 0x10;
+    io::test::check_equal(io::usart_baud(io::USART1, 48000000), 6000000, "detected baud");
+}
+
+int main() {
+    test_configure();
+    test_auto_baud();
+    return io::test::result("usart_baud");
+}
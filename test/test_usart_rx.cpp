@@ -0,0 +1,168 @@
+/**
+ * USART receiver with circular DMA
+ *
+ * DMA position (CNDTR) and interrupt flags are set by test, spans
+ * delivered by callback are checked against position in ring.
+ */
+
+#include "io/reg/stm32/f0/usart.hpp"
+#include "io/reg/stm32/f0/dma.hpp"
+#include "io/lib/stm32/_common/usart_rx.hpp"
+#include "io/test/check.hpp"
+
+static const unsigned CHANNEL = 3;
+static const uint32_t PE = 0x01;
+static const uint32_t FE = 0x02;
+static const uint32_t IDLE = 0x10;
+static const uint32_t RXNE = 0x20;
+static const uint32_t RTOF = 0x800;
+static const uint32_t CMF = 0x20000;
+
+static uint8_t ring[16];
+
+struct Span {
+    const uint8_t *data;
+    size_t size;
+    bool end;
+};
+
+static Span spans[4];
+static unsigned count = 0;
+
+static void received(void *, const uint8_t *data, const size_t size, const bool end) {
+    if (count < 4) spans[count] = {data, size, end};
+    count++;
+}
+
+static void check_span(const unsigned index, const size_t offset, const size_t size, const bool end, const char *what) {
+    io::test::check_equal(static_cast<size_t>(spans[index].data - ring), offset, what);
+    io::test::check_equal(spans[index].size, size, what);
+    io::test::check_equal(spans[index].end, end, what);
+}
+
+/** DMA received bytes up to position
+ */
+static void dma_position(const size_t head) {
+    io::DMA1.CHANNEL(CHANNEL).CNDTR.r = static_cast<uint32_t>(sizeof(ring) - head);
+}
+
+/** Raise USART interrupt with flags
+ */
+static void usart_interrupt(io::UsartRx &rx, const uint32_t flags) {
+    io::USART1.ISR.r = flags;
+    io::USART1.ICR.r = 0;
+    count = 0;
+    rx.handle_isr();
+}
+
+static void test_start() {
+    io::UsartRx rx(io::USART1, io::DMA1, CHANNEL);
+    rx.start(ring, sizeof(ring), received);
+    const io::Dma::Channel::Ccr ccr = io::DMA1.CHANNEL(CHANNEL).CCR.read();
+    io::test::check(ccr.b.CIRC && ccr.b.MINC && ccr.b.HTIE && ccr.b.TCIE && ccr.b.TEIE && ccr.b.EN, "start CCR");
+    io::test::check_equal(io::DMA1.CHANNEL(CHANNEL).CNDTR.r, sizeof(ring), "start CNDTR");
+    io::test::check_equal(io::DMA1.CHANNEL(CHANNEL).CMAR.r, reinterpret_cast<uintptr_t>(ring), "start CMAR");
+    const io::Usart::Cr1 cr1 = io::USART1.CR1.read();
+    io::test::check(cr1.b.RE && cr1.b.IDLEIE && cr1.b.PEIE && !cr1.b.RTOIE && !cr1.b.CMIE, "start CR1");
+    io::test::check(io::USART1.CR3.read().b.DMAR && io::USART1.CR3.read().b.EIE, "start CR3");
+}
+
+static void test_idle() {
+    io::UsartRx rx(io::USART1, io::DMA1, CHANNEL);
+    rx.start(ring, sizeof(ring), received);
+    dma_position(5);
+    usart_interrupt(rx, IDLE);
+    io::test::check_equal(io::USART1.ICR.r, IDLE, "IDLE cleared");
+    io::test::check_equal(count, 1, "IDLE spans");
+    check_span(0, 0, 5, true, "IDLE span");
+
+    // frame wraps in ring
+    dma_position(3);
+    usart_interrupt(rx, IDLE);
+    io::test::check_equal(count, 2, "wrap spans");
+    check_span(0, 5, 11, false, "wrap end of ring");
+    check_span(1, 0, 3, true, "wrap start of ring");
+
+    // errors are counted, flag without enabled interrupt is ignored
+    usart_interrupt(rx, FE | PE | RTOF);
+    io::test::check_equal(io::USART1.ICR.r, FE | PE, "errors cleared");
+    io::test::check_equal(rx.errors(), 1, "errors");
+    io::test::check_equal(count, 0, "no span on error");
+}
+
+static void test_timeout() {
+    io::UsartRx rx(io::USART1, io::DMA1, CHANNEL);
+    rx.start(ring, sizeof(ring), received, nullptr, 20);
+    io::test::check_equal(io::USART1.RTOR.read().b.RTO, 20, "RTOR");
+    io::test::check(io::USART1.CR2.read().b.RTOEN, "RTOEN");
+    const io::Usart::Cr1 cr1 = io::USART1.CR1.read();
+    io::test::check(cr1.b.RTOIE && !cr1.b.IDLEIE, "timeout CR1");
+
+    // IDLE is set also in timeout mode, it is not end of frame
+    dma_position(4);
+    usart_interrupt(rx, IDLE | FE);
+    io::test::check_equal(count, 0, "stale IDLE");
+    io::test::check_equal(io::USART1.ICR.r, FE, "stale IDLE not cleared");
+
+    // DMA half transfer: data without end
+    io::DMA1.ISR.r = io::Dma::Ifcr::HTIF << ((CHANNEL - 1) << 2);
+    io::DMA1.IFCR.r = 0;
+    rx.handle_dma_isr();
+    io::DMA1.ISR.r = 0;
+    io::test::check_equal(io::DMA1.IFCR.r, io::Dma::Ifcr::HTIF << ((CHANNEL - 1) << 2), "only HTIF cleared");
+    io::test::check_equal(count, 1, "half transfer spans");
+    check_span(0, 0, 4, false, "half transfer span");
+
+    // frame ends exactly with previous span
+    usart_interrupt(rx, RTOF);
+    io::test::check_equal(count, 1, "timeout spans");
+    check_span(0, 4, 0, true, "timeout empty span");
+}
+
+static void test_delimited() {
+    io::UsartRx rx(io::USART1, io::DMA1, CHANNEL);
+    rx.start_delimited(ring, sizeof(ring), '\n', received);
+    io::test::check_equal(io::USART1.CR2.read().b.ADD, '\n', "delimiter");
+    const io::Usart::Cr1 cr1 = io::USART1.CR1.read();
+    io::test::check(cr1.b.CMIE && !cr1.b.IDLEIE && !cr1.b.RTOIE, "delimited CR1");
+
+    dma_position(7);
+    usart_interrupt(rx, IDLE);
+    io::test::check_equal(count, 0, "IDLE in delimited mode");
+    usart_interrupt(rx, CMF);
+    io::test::check_equal(io::USART1.ICR.r, CMF, "CMF cleared");
+    io::test::check_equal(count, 1, "packet spans");
+    check_span(0, 0, 7, true, "packet");
+
+    // packets received faster than interrupt latency are in one span,
+    // matched byte still in RDR (RXNE) is waited for limited time
+    dma_position(15);
+    usart_interrupt(rx, CMF | RXNE);
+    io::test::check_equal(count, 1, "fast packets spans");
+    check_span(0, 7, 8, true, "fast packets");
+
+    // packet wraps in ring
+    dma_position(2);
+    usart_interrupt(rx, CMF);
+    io::test::check_equal(count, 2, "wrapped packet spans");
+    check_span(0, 15, 1, false, "wrapped packet end of ring");
+    check_span(1, 0, 2, true, "wrapped packet start of ring");
+
+    // delimiter is last byte of ring
+    dma_position(16);
+    usart_interrupt(rx, CMF);
+    io::test::check_equal(count, 1, "packet at end of ring spans");
+    check_span(0, 2, 14, true, "packet at end of ring");
+
+    rx.stop();
+    io::test::check_equal(io::DMA1.CHANNEL(CHANNEL).CCR.r, 0, "stop CCR");
+    io::test::check(!io::USART1.CR1.read().b.RE, "stop RE");
+}
+
+int main() {
+    test_start();
+    test_idle();
+    test_timeout();
+    test_delimited();
+    return io::test::result("usart_rx");
+}
@@ -0,0 +1,115 @@
+/**
+ * USART transmit queue with DMA
+ *
+ * DMA transfer complete is raised by test, started transfers (CMAR,
+ * CNDTR) are checked against queued messages.
+ */
+
+#include <cstring>
+
+#include "io/reg/stm32/f0/usart.hpp"
+#include "io/reg/stm32/f0/dma.hpp"
+#include "io/lib/stm32/_common/usart_tx.hpp"
+#include "io/test/check.hpp"
+
+static const unsigned CHANNEL = 2;
+
+static uint8_t staging[16];
+static const uint8_t frame[] = {1, 2, 3, 4, 5};
+static unsigned done_count = 0;
+static bool done_ok = false;
+
+static void sent(void *context, const bool ok) {
+    io::test::check(context == frame, "done context");
+    done_count++;
+    done_ok = ok;
+}
+
+static void check_transfer(const void *data, const size_t size, const char *what) {
+    io::test::check_equal(io::DMA1.CHANNEL(CHANNEL).CMAR.r, reinterpret_cast<uintptr_t>(data), what);
+    io::test::check_equal(io::DMA1.CHANNEL(CHANNEL).CNDTR.r, size, what);
+    io::test::check(io::DMA1.CHANNEL(CHANNEL).CCR.read().b.EN, what);
+}
+
+template <typename Tx>
+static void transfer_complete(Tx &tx, const unsigned flags=io::Dma::Ifcr::TCIF) {
+    io::DMA1.ISR.r = flags << ((CHANNEL - 1) << 2);
+    io::DMA1.IFCR.r = 0;
+    tx.handle_dma_isr();
+    io::DMA1.ISR.r = 0;
+}
+
+static void test_queue() {
+    io::UsartTx<> tx(io::USART1, io::DMA1, CHANNEL, staging, sizeof(staging));
+    io::test::check(tx.is_idle(), "idle");
+
+    io::test::check(tx.send(frame, sizeof(frame), sent, const_cast<uint8_t *>(frame)), "send");
+    io::test::check(io::USART1.CR3.read().b.DMAT, "DMAT");
+    io::test::check_equal(io::DMA1.CHANNEL(CHANNEL).CPAR.r, reinterpret_cast<uintptr_t>(&io::USART1.TDR), "CPAR");
+    check_transfer(frame, sizeof(frame), "send transfer");
+
+    // writes waiting in queue are coalesced
+    io::test::check(tx.write("ab", 2), "write ab");
+    io::test::check(tx.write("cd", 2), "write cd");
+    transfer_complete(tx);
+    io::test::check(done_count == 1 && done_ok, "done");
+    io::test::check_equal(io::DMA1.IFCR.r, io::Dma::Ifcr::TCIF << ((CHANNEL - 1) << 2), "only TCIF cleared");
+    check_transfer(staging, 4, "coalesced transfer");
+    io::test::check(std::memcmp(staging, "abcd", 4) == 0, "staged data");
+
+    // running transfer is not extended
+    io::test::check(tx.write("ef", 2), "write ef");
+    transfer_complete(tx);
+    check_transfer(staging + 4, 2, "next staged transfer");
+    io::test::check(!tx.is_idle(), "not idle");
+    transfer_complete(tx);
+    io::test::check(tx.is_idle(), "idle after last");
+    io::test::check_equal(io::DMA1.CHANNEL(CHANNEL).CCR.r, 0, "channel disabled");
+    io::test::check_equal(done_count, 1, "done only for send");
+}
+
+static void test_full() {
+    io::UsartTx<2> tx(io::USART1, io::DMA1, CHANNEL, staging, sizeof(staging));
+    io::test::check(tx.send(frame, 1), "send 1");
+    io::test::check(tx.send(frame + 1, 1), "send 2");
+    io::test::check(!tx.send(frame + 2, 1), "queue full");
+    io::test::check(!tx.write("x", 1), "write queue full");
+    io::test::check(!tx.send(frame, 0), "empty send");
+    transfer_complete(tx);
+    check_transfer(frame + 1, 1, "second send");
+    transfer_complete(tx);
+
+    // staging buffer: write must fit, space is reused after sent
+    static const char data[] = "0123456789abcdefg";
+    io::test::check(!tx.write(data, sizeof(staging) + 1), "write too big");
+    io::test::check(tx.write(data, 10), "write 10");
+    io::test::check(tx.send(frame, 1), "send between writes");
+    io::test::check(!tx.write(data, 10), "staging full");
+    transfer_complete(tx);
+    transfer_complete(tx);
+    io::test::check(tx.is_idle(), "idle");
+    io::test::check(tx.write(data, 10), "staging reused");
+    check_transfer(staging, 10, "reused transfer");
+    transfer_complete(tx);
+}
+
+static void test_error() {
+    io::UsartTx<> tx(io::USART1, io::DMA1, CHANNEL, staging, sizeof(staging));
+    done_count = 0;
+    tx.send(frame, sizeof(frame), sent, const_cast<uint8_t *>(frame));
+    tx.write("ab", 2);
+
+    // transfer error reports failed send, next message is started anyway
+    transfer_complete(tx, io::Dma::Ifcr::TEIF);
+    io::test::check(done_count == 1 && !done_ok, "done with error");
+    check_transfer(staging, 2, "next after error");
+    transfer_complete(tx);
+    io::test::check(tx.is_idle(), "idle after error");
+}
+
+int main() {
+    test_queue();
+    test_full();
+    test_error();
+    return io::test::result("usart_tx");
+}
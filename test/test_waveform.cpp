@@ -0,0 +1,116 @@
+/**
+ * Timer paced DMA waveform
+ *
+ * DMA channel and timer programming are checked for single and stream
+ * mode, half transfer and transfer complete flags are set by test.
+ */
+
+#include "io/reg/stm32/f0/dma.hpp"
+#include "io/reg/stm32/f0/gpio.hpp"
+#include "io/reg/stm32/f0/timer.hpp"
+#include "io/lib/stm32/_common/waveform.hpp"
+#include "io/test/check.hpp"
+
+static const unsigned CHANNEL = 5;
+static const uint32_t UDE = 1 << 8;
+
+// DMA buffers (32 bit addresses)
+static uint32_t words[3] = {0x10, 0x100000, 0x10};
+static uint32_t buffer[8];
+
+static unsigned done_count = 0;
+
+static void done(void *) {
+    done_count++;
+}
+
+// stream source: 10 words 1 .. 10
+static uint32_t next_word = 1;
+
+static size_t refill(void *, uint32_t *data, const size_t count) {
+    size_t filled = 0;
+    while (filled < count && next_word <= 10) data[filled++] = next_word++;
+    return filled;
+}
+
+/** Raise DMA channel flags
+ */
+static void dma_interrupt(io::Waveform &wave, const unsigned flags) {
+    io::DMA1.ISR.r = flags << ((CHANNEL - 1) << 2);
+    io::DMA1.IFCR.r = 0;
+    wave.handle_isr();
+    io::DMA1.ISR.r = 0;
+}
+
+static bool words_equal(const uint32_t *data, const uint32_t first, const uint32_t last, const size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (data[i] != (first + i <= last ? first + i : 0)) return false;
+    }
+    return true;
+}
+
+static void test_single() {
+    io::Waveform wave(io::DMA1, CHANNEL, io::TIM1, io::Waveform::Trigger::UPDATE, io::GPIOB);
+    wave.set_rate(0, 59);
+    io::test::check(io::TIM1.PSC.r == 0 && io::TIM1.ARR.r == 59, "rate");
+
+    io::test::check(!wave.start(words, 0, done), "empty buffer");
+    io::test::check(!wave.is_running(), "not started");
+    io::test::check(wave.start(words, 3, done), "start");
+    io::Dma::Channel &ch = io::DMA1.CHANNEL(CHANNEL);
+    io::test::check_equal(ch.CPAR.r, reinterpret_cast<uintptr_t>(&io::GPIOB.BSRR), "CPAR");
+    io::test::check_equal(ch.CMAR.r, reinterpret_cast<uintptr_t>(words), "CMAR");
+    io::test::check_equal(ch.CNDTR.r, 3, "CNDTR");
+    io::Dma::Channel::Ccr ccr = ch.CCR.read();
+    io::test::check(ccr.b.DIR && ccr.b.MINC && !ccr.b.CIRC && ccr.b.TCIE && !ccr.b.HTIE && ccr.b.EN, "CCR");
+    io::test::check(ccr.PSIZE() == io::Dma::Channel::Ccr::Size::SIZE_32 && ccr.MSIZE() == io::Dma::Channel::Ccr::Size::SIZE_32, "32 bit");
+    io::test::check_equal(io::TIM1.DIER.r & UDE, UDE, "UDE");
+    io::test::check(io::TIM1.CR1.read().b.CEN, "CEN");
+
+    dma_interrupt(wave, io::Dma::Ifcr::TCIF);
+    io::test::check_equal(done_count, 1, "done");
+    io::test::check(!wave.is_running(), "stopped");
+    io::test::check_equal(ch.CCR.r, 0, "channel disabled");
+    io::test::check_equal(io::TIM1.DIER.r & UDE, 0, "UDE cleared");
+    io::test::check(!io::TIM1.CR1.read().b.CEN, "CEN cleared");
+}
+
+static void test_stream() {
+    io::Waveform wave(io::DMA1, CHANNEL, io::TIM1, io::Waveform::Trigger::UPDATE, io::GPIOB);
+    done_count = 0;
+    io::test::check(!wave.start_stream(buffer, 1, refill, done), "stream of one word");
+
+    // odd count is rounded down, both halves are filled before start
+    io::test::check(wave.start_stream(buffer, 9, refill, done), "start stream");
+    io::Dma::Channel &ch = io::DMA1.CHANNEL(CHANNEL);
+    io::test::check_equal(ch.CNDTR.r, 8, "stream CNDTR");
+    io::test::check(ch.CCR.read().b.CIRC && ch.CCR.read().b.HTIE, "circular");
+    io::test::check(words_equal(buffer, 1, 10, 8), "both halves filled");
+
+    // first half refilled with end of stream, padded by zero
+    dma_interrupt(wave, io::Dma::Ifcr::HTIF);
+    io::test::check_equal(io::DMA1.IFCR.r, io::Dma::Ifcr::HTIF << ((CHANNEL - 1) << 2), "only HTIF cleared");
+    io::test::check(words_equal(buffer, 9, 10, 4), "short refill padded");
+
+    // second half is cleared while last half is sent
+    dma_interrupt(wave, io::Dma::Ifcr::TCIF);
+    io::test::check(words_equal(buffer + 4, 1, 0, 4), "second half cleared");
+    io::test::check(wave.is_running(), "draining");
+
+    dma_interrupt(wave, io::Dma::Ifcr::HTIF);
+    io::test::check_equal(done_count, 1, "stream done");
+    io::test::check(!wave.is_running(), "stream stopped");
+
+    // both halves sent before interrupt: both are refilled
+    next_word = 1;
+    wave.start_stream(buffer, 4, refill, done);
+    dma_interrupt(wave, io::Dma::Ifcr::HTIF | io::Dma::Ifcr::TCIF);
+    io::test::check(words_equal(buffer, 5, 10, 4), "both halves refilled");
+    wave.stop();
+}
+
+int main() {
+    test_single();
+    test_stream();
+    return io::test::result("waveform");
+}